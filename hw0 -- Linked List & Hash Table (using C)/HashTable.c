@@ -15,6 +15,7 @@
 
 #include "HashTable.h"
 #include "HashTable_priv.h"
+#include "LinkedList_priv.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Internal helper functions.
@@ -25,6 +26,11 @@
 // factor has become too high.
 static void MaybeResize(HashTable *ht);
 
+// Moves the iterator onto the head of the next non-empty bucket after
+// iter->bucket_idx, reusing the existing LLIterator.  If there is no such
+// bucket, the iterator is left invalid ("past the end").
+static void HTIterator_NextBucket(HTIterator *iter);
+
 // Implemented for you
 int HashKeyToBucketNum(HashTable *ht, HTKey_t key) {
   return key % ht->num_buckets;
@@ -371,25 +377,74 @@ bool HTIterator_Get(HTIterator *iter, HTKeyValue_t *keyvalue) {
   return false;  // if the iterator is not valid or the table is empty
 }
 
-// Implemented for you
 bool HTIterator_Remove(HTIterator *iter, HTKeyValue_t *keyvalue) {
-  HTKeyValue_t kv;
+  HTKeyValue_t *kv;
+  bool at_tail;
 
   // Try to get what the iterator is pointing to.
-  if (!HTIterator_Get(iter, &kv)) {
+  if (!HTIterator_IsValid(iter)) {
     return false;
   }
+  LLIterator_Get(iter->bucket_it, (LLPayload_t *)&kv);
+  keyvalue->key = kv->key;
+  keyvalue->value = kv->value;
+
+  // Unlink the node we're already sitting on rather than re-hashing the
+  // key and rescanning the chain.  LLIterator_Remove leaves the bucket
+  // iterator on the successor, except when it removes the tail: then it
+  // steps back to the predecessor (or becomes invalid), and we need to
+  // move on to the next bucket ourselves.
+  at_tail = (iter->bucket_it->node == iter->bucket_it->list->tail);
+  LLIterator_Remove(iter->bucket_it, free);
+  iter->ht->num_elements -= 1;
+
+  if (at_tail) {
+    HTIterator_NextBucket(iter);
+  }
+  return true;
+}
+
+int HashTable_RemoveIf(HashTable *table,
+                       HTKeyValuePredicateFnPtr predicate,
+                       ValueFreeFnPtr value_free_function) {
+  HTIterator *it;
+  HTKeyValue_t *kv;
+  HTKeyValue_t removed;
+  int num_removed = 0;
+
+  // One pass over the table; HTIterator_Remove unlinks in place and
+  // advances, so we only step the iterator ourselves on a keep.
+  it = HTIterator_Allocate(table);
+  while (HTIterator_IsValid(it)) {
+    LLIterator_Get(it->bucket_it, (LLPayload_t *)&kv);
+    if (predicate(kv)) {
+      HTIterator_Remove(it, &removed);
+      value_free_function(removed.value);
+      num_removed++;
+    } else {
+      HTIterator_Next(it);
+    }
+  }
+  HTIterator_Free(it);
 
-  // Advance the iterator.  Thanks to the above call to
-  // HTIterator_Get, we know that this iterator is valid (though it
-  // may not be valid after this call to HTIterator_Next).
-  HTIterator_Next(iter);
+  return num_removed;
+}
 
-  // Lastly, remove the element.  Again, we know this call will succeed
-  // due to the successful HTIterator_Get above.
-  HashTable_Remove(iter->ht, kv.key, keyvalue);
+static void HTIterator_NextBucket(HTIterator *iter) {
+  HashTable *table = iter->ht;
+  int i;
 
-  return true;
+  for (i = iter->bucket_idx + 1; i < table->num_buckets; i++) {
+    if (LinkedList_NumElements(table->buckets[i]) > 0) {
+      iter->bucket_idx = i;
+      iter->bucket_it->list = table->buckets[i];
+      LLIterator_Rewind(iter->bucket_it);
+      return;
+    }
+  }
+
+  // No elements remain past this bucket.
+  iter->bucket_it->node = NULL;
 }
 
 // Implemented for you
@@ -166,6 +166,27 @@ bool HashTable_Remove(HashTable *table,
                       HTKey_t key,
                       HTKeyValue_t *keyvalue);
 
+// When bulk-removing from a HashTable, customers pass in a pointer to a
+// predicate function.  The pointed-to function is invoked once for each
+// (key,value) in the HashTable, and returns true if that (key,value)
+// should be removed.
+typedef bool(*HTKeyValuePredicateFnPtr)(HTKeyValue_t *keyvalue);
+
+// Removes every (key,value) for which the predicate returns true, in a
+// single sweep over the HashTable.
+//
+// Arguments:
+// - table: the HashTable to remove from.
+// - predicate: invoked once per (key,value); see above for details.
+// - value_free_function: invoked once on the value of each removed
+//   (key,value); see ValueFreeFnPtr above for details.
+//
+// Returns:
+// - the number of (key,value) pairs that were removed.
+int HashTable_RemoveIf(HashTable *table,
+                       HTKeyValuePredicateFnPtr predicate,
+                       ValueFreeFnPtr value_free_function);
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // HashTable iterator
@@ -241,6 +262,10 @@ bool HTIterator_Get(HTIterator *iter, HTKeyValue_t *keyvalue);
 // pointed to by the value.  As well, this advances
 // the iterator to the next element in the hashtable.
 //
+// The element is unlinked directly from the chain the iterator is
+// sitting on, so this runs in constant time (plus the cost of
+// skipping empty buckets) and never resizes the table.
+//
 // Arguments:
 // - iter: the iterator to fetch the (key,value) from.  Must be non-NULL.
 // - keyvalue: a return parameter through which the (key,value)
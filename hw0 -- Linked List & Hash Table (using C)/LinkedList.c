@@ -192,7 +192,7 @@ LLIterator* LLIterator_Allocate(LinkedList *list) {
     return NULL ;
   }
 
-  LLIterator* LLIterator = malloc(sizeof(LLIterator)) ;
+  LLIterator* LLIterator = malloc(sizeof(struct ll_iter)) ;
   if (LLIterator != NULL) {
     LLIterator->list = list ;                
     LLIterator->node = list->head ;          // the initial node iterator points to is the head node of linked list
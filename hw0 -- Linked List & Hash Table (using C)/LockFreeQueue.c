@@ -0,0 +1,284 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "LockFreeQueue.h"
+#include "LockFreeQueue_priv.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+//
+// Loads acquire and stores release, which is all the queue's links need.
+// The one exception is publishing a hazard pointer: its store must stay
+// ahead of the load that checks it, which only sequential consistency
+// guarantees (see Protect).
+#define LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define CAS(p, expected, desired) \
+  __atomic_compare_exchange_n((p), &(expected), (desired), false, \
+                              __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+// The slot this thread used last; usually still free when it comes back.
+static _Thread_local int slot_hint = 0;
+
+// Claims a slot for the calling thread.  If all LFQ_MAX_THREADS are taken,
+// this waits (yielding after each full sweep) until one is handed back,
+// so beyond that many threads the queue is no longer lock-free.
+static LockFreeQueueSlot* ClaimSlot(LockFreeQueue *queue) {
+  int i = slot_hint, tried = 0;
+
+  while (true) {
+    int expected = 0;
+    if (!__atomic_load_n(&queue->slots[i].in_use, __ATOMIC_RELAXED) &&
+        CAS(&queue->slots[i].in_use, expected, 1)) {
+      slot_hint = i;
+      return &queue->slots[i];
+    }
+    i = (i + 1) % LFQ_MAX_THREADS;
+    if (++tried % LFQ_MAX_THREADS == 0) {
+      sched_yield();
+    }
+  }
+}
+
+// Clears the slot's hazard pointers and hands it back.
+static void ReleaseSlot(LockFreeQueueSlot *slot) {
+  int i;
+
+  for (i = 0; i < LFQ_HAZARDS_PER_THREAD; i++) {
+    STORE(&slot->hazards[i], NULL);
+  }
+  STORE(&slot->in_use, 0);
+}
+
+// Publishes *src as a hazard and re-reads *src until the two agree, so the
+// returned node was reachable after it became protected.
+static LockFreeQueueNode* Protect(LockFreeQueueSlot *slot, int idx,
+                                  LockFreeQueueNode **src) {
+  LockFreeQueueNode *node = LOAD(src);
+
+  while (true) {
+    LockFreeQueueNode *again;
+
+    __atomic_store_n(&slot->hazards[idx], node, __ATOMIC_SEQ_CST);
+    again = __atomic_load_n(src, __ATOMIC_SEQ_CST);
+    if (again == node) {
+      return node;
+    }
+    node = again;
+  }
+}
+
+static int ComparePointers(const void *a, const void *b) {
+  uintptr_t pa = (uintptr_t) *(void * const *) a;
+  uintptr_t pb = (uintptr_t) *(void * const *) b;
+  return (pa > pb) - (pa < pb);
+}
+
+// Frees every node on the slot's retired list that no thread has a hazard
+// pointer to.  The rest stay on the list for a later scan.
+static void Scan(LockFreeQueue *queue, LockFreeQueueSlot *slot) {
+  void *hazards[LFQ_MAX_THREADS * LFQ_HAZARDS_PER_THREAD];
+  LockFreeQueueNode *node, *next, *keep = NULL;
+  int num_hazards = 0, num_kept = 0;
+  int i, j;
+
+  // The retired nodes were unlinked before this point; a thread that
+  // protected one must have done so before then too (see Protect), and
+  // this fence makes sure we see it.
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  for (i = 0; i < LFQ_MAX_THREADS; i++) {
+    for (j = 0; j < LFQ_HAZARDS_PER_THREAD; j++) {
+      void *hp = __atomic_load_n(&queue->slots[i].hazards[j],
+                                 __ATOMIC_SEQ_CST);
+      if (hp != NULL) {
+        hazards[num_hazards++] = hp;
+      }
+    }
+  }
+  qsort(hazards, num_hazards, sizeof(void *), &ComparePointers);
+
+  for (node = slot->retired; node != NULL; node = next) {
+    next = node->retired_next;
+    if (bsearch(&node, hazards, num_hazards, sizeof(void *),
+                &ComparePointers) != NULL) {
+      node->retired_next = keep;
+      keep = node;
+      num_kept++;
+    } else {
+      free(node);
+    }
+  }
+  slot->retired = keep;
+  slot->num_retired = num_kept;
+}
+
+// Puts a node that has been unlinked from the queue on the slot's retired
+// list, scanning once the list grows long enough.
+static void Retire(LockFreeQueue *queue, LockFreeQueueSlot *slot,
+                   LockFreeQueueNode *node) {
+  node->retired_next = slot->retired;
+  slot->retired = node;
+  slot->num_retired++;
+  if (slot->num_retired >= LFQ_RETIRE_THRESHOLD) {
+    Scan(queue, slot);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LockFreeQueue implementation.
+
+LockFreeQueue* LockFreeQueue_Allocate(void) {
+  LockFreeQueue *queue;
+  LockFreeQueueNode *dummy;
+
+  // The struct is cache-line aligned, so its size is a multiple of 64.
+  queue = (LockFreeQueue *) aligned_alloc(64, sizeof(LockFreeQueue));
+  if (!queue) {
+    return NULL;
+  }
+  dummy = (LockFreeQueueNode *) malloc(sizeof(LockFreeQueueNode));
+  if (!dummy) {
+    free(queue);
+    return NULL;
+  }
+
+  memset(queue, 0, sizeof(LockFreeQueue));
+  dummy->payload = NULL;
+  dummy->next = NULL;
+  dummy->retired_next = NULL;
+  queue->head = dummy;
+  queue->tail = dummy;
+  return queue;
+}
+
+void LockFreeQueue_Free(LockFreeQueue *queue,
+                        LLPayloadFreeFnPtr payload_free_function) {
+  LockFreeQueueNode *node, *next;
+  int i;
+
+  // Nobody else is using the queue, so there are no hazards: everything
+  // still linked in, and everything retired, can go.
+  node = queue->head->next;
+  free(queue->head);            // the dummy carries no payload
+  while (node != NULL) {
+    next = node->next;
+    payload_free_function(node->payload);
+    free(node);
+    node = next;
+  }
+  for (i = 0; i < LFQ_MAX_THREADS; i++) {
+    node = queue->slots[i].retired;
+    queue->slots[i].retired = NULL;
+    while (node != NULL) {
+      next = node->retired_next;
+      free(node);
+      node = next;
+    }
+  }
+  free(queue);
+}
+
+int LockFreeQueue_NumElements(LockFreeQueue *queue) {
+  int64_t count = 0;
+  int i;
+
+  // Each operation counts itself in its own slot, so there is no counter
+  // for every thread to fight over; add them up.  A pop can be counted
+  // before the append it took, so a snapshot may dip below zero.
+  for (i = 0; i < LFQ_MAX_THREADS; i++) {
+    count += __atomic_load_n(&queue->slots[i].num_appended, __ATOMIC_RELAXED);
+    count -= __atomic_load_n(&queue->slots[i].num_popped, __ATOMIC_RELAXED);
+  }
+  return count > 0 ? (int) count : 0;
+}
+
+void LockFreeQueue_Append(LockFreeQueue *queue, LLPayload_t payload) {
+  LockFreeQueueSlot *slot;
+  LockFreeQueueNode *node, *tail, *next;
+
+  node = (LockFreeQueueNode *) malloc(sizeof(LockFreeQueueNode));
+  if (!node) {
+    return;
+  }
+  node->payload = payload;
+  node->next = NULL;
+  node->retired_next = NULL;
+
+  slot = ClaimSlot(queue);
+  while (true) {
+    tail = Protect(slot, 0, &queue->tail);
+    next = LOAD(&tail->next);
+    if (tail != LOAD(&queue->tail)) {
+      continue;
+    }
+    if (next != NULL) {
+      // The tail is lagging behind; help move it along, then retry.
+      CAS(&queue->tail, tail, next);
+      continue;
+    }
+    if (CAS(&tail->next, next, node)) {
+      // Linked in.  Swinging the tail can fail if someone helped us.
+      CAS(&queue->tail, tail, node);
+      break;
+    }
+  }
+  // Only the slot's owner writes its counts, so no read-modify-write.
+  __atomic_store_n(&slot->num_appended, slot->num_appended + 1,
+                   __ATOMIC_RELAXED);
+  ReleaseSlot(slot);
+}
+
+bool LockFreeQueue_Pop(LockFreeQueue *queue, LLPayload_t *payload_ptr) {
+  LockFreeQueueSlot *slot;
+  LockFreeQueueNode *head, *tail, *next;
+  LLPayload_t payload;
+
+  slot = ClaimSlot(queue);
+  while (true) {
+    head = Protect(slot, 0, &queue->head);
+    tail = LOAD(&queue->tail);
+    next = LOAD(&head->next);
+    __atomic_store_n(&slot->hazards[1], next, __ATOMIC_SEQ_CST);
+    if (head != __atomic_load_n(&queue->head, __ATOMIC_SEQ_CST)) {
+      continue;
+    }
+    if (next == NULL) {                   // only the dummy is left
+      ReleaseSlot(slot);
+      return false;
+    }
+    if (head == tail) {
+      // The tail is lagging behind the node we're about to expose.
+      CAS(&queue->tail, tail, next);
+      continue;
+    }
+    // next becomes the new dummy; its payload is ours if the CAS wins.
+    payload = LOAD(&next->payload);
+    if (CAS(&queue->head, head, next)) {
+      break;
+    }
+  }
+  __atomic_store_n(&slot->num_popped, slot->num_popped + 1, __ATOMIC_RELAXED);
+
+  STORE(&slot->hazards[0], NULL);
+  STORE(&slot->hazards[1], NULL);
+  Retire(queue, slot, head);
+  ReleaseSlot(slot);
+
+  *payload_ptr = payload;
+  return true;
+}
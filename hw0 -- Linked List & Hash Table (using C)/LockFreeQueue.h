@@ -0,0 +1,91 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW0_LOCKFREEQUEUE_H_
+#define HW0_LOCKFREEQUEUE_H_
+
+#include <stdbool.h>    // for bool type (true, false)
+
+#include "./LinkedList.h"  // for LLPayload_t and LLPayloadFreeFnPtr
+
+///////////////////////////////////////////////////////////////////////////////
+// A LockFreeQueue is a FIFO queue that any number of threads may append to
+// and pop from at the same time, without an external lock.
+//
+// It is a drop-in replacement for the LinkedList_Append / LinkedList_Pop
+// pattern guarded by a mutex: LockFreeQueue_Append adds to the tail and
+// LockFreeQueue_Pop removes from the head, with the same payload types and
+// the same return conventions as their LinkedList counterparts.  There is
+// no Push/Slice: only the FIFO ends are supported.
+//
+// Internally this is a Michael-Scott queue.  Popped nodes are reclaimed
+// with hazard pointers, so a node is only freed once no other thread can
+// still be reading it.  At most LFQ_MAX_THREADS (64) threads may be inside
+// Append or Pop on the same queue at once; any more wait, yielding the CPU,
+// for one of them to finish.  So the queue is only lock-free for up to
+// that many threads: past it, a thread preempted mid-operation can hold
+// up the others.
+//
+// Lock-free doesn't mean faster.  With few cores, or little contention, a
+// mutex around a LinkedList is usually quicker (see the Throughput test).
+typedef struct lfq LockFreeQueue;
+
+// Allocate and return a new, empty queue.  The caller takes responsibility
+// for eventually calling LockFreeQueue_Free.
+//
+// Arguments: none.
+//
+// Returns:
+// - the newly-allocated queue or NULL on error.
+LockFreeQueue* LockFreeQueue_Allocate(void);
+
+// Free a queue previously allocated by LockFreeQueue_Allocate.  No other
+// thread may be using the queue at this point.
+//
+// Arguments:
+// - queue: the queue to free.  It is unsafe to use "queue" after this
+//   function returns.
+// - payload_free_function: invoked once on every payload still in
+//   the queue.
+void LockFreeQueue_Free(LockFreeQueue *queue,
+                        LLPayloadFreeFnPtr payload_free_function);
+
+// Return the number of elements in the queue.  While other threads are
+// appending or popping this is only a snapshot.
+//
+// Arguments:
+// - queue: the queue to query.
+//
+// Returns:
+// - queue length.
+int LockFreeQueue_NumElements(LockFreeQueue *queue);
+
+// Adds a new element to the tail of the queue.  Safe to call concurrently.
+//
+// Arguments:
+// - queue: the LockFreeQueue to append to.
+// - payload: the payload to append; it's up to the caller to interpret and
+//   manage the memory of the payload.
+void LockFreeQueue_Append(LockFreeQueue *queue, LLPayload_t payload);
+
+// Pop an element from the head of the queue.  Safe to call concurrently.
+//
+// Arguments:
+// - queue: the LockFreeQueue to pop from.
+// - payload_ptr: a return parameter; on success, the popped payload
+//   is returned through this parameter.
+//
+// Returns:
+// - false on failure (eg, the queue is empty).
+// - true on success.
+bool LockFreeQueue_Pop(LockFreeQueue *queue, LLPayload_t *payload_ptr);
+
+#endif  // HW0_LOCKFREEQUEUE_H_
@@ -0,0 +1,73 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW0_LOCKFREEQUEUE_PRIV_H_
+#define HW0_LOCKFREEQUEUE_PRIV_H_
+
+#include <stdint.h>  // for int64_t
+
+#include "./LockFreeQueue.h"
+
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// Internal structures for our LockFreeQueue implementation.
+//
+// As with LinkedList_priv.h, these are broken out so that our unittests can
+// peek inside the implementation.  Customers should not include this file
+// or assume anything based on its contents.
+//
+// Fields shared between threads are plain types accessed only through the
+// __atomic builtins, so this header stays usable from C++ tests.
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+// The most threads that may be inside Append/Pop on one queue at once
+// without waiting (see LockFreeQueue.h).
+#define LFQ_MAX_THREADS 64
+
+// Hazard pointers per thread: Pop needs to protect both the head and its
+// successor.
+#define LFQ_HAZARDS_PER_THREAD 2
+
+// Once a slot has this many retired nodes, it scans the hazard pointers and
+// frees whichever of them are no longer protected.  Keeping this at twice
+// the number of hazard pointers means each scan frees at least half.
+#define LFQ_RETIRE_THRESHOLD (2 * LFQ_MAX_THREADS * LFQ_HAZARDS_PER_THREAD)
+
+// A single queue node.  The queue always holds one "dummy" node at the
+// head; the payloads live in the nodes after it.
+typedef struct lfq_node {
+  LLPayload_t      payload;       // customer-supplied payload pointer
+  struct lfq_node *next;          // next node toward the tail, or NULL
+  struct lfq_node *retired_next;  // next node on a retired list
+} LockFreeQueueNode;
+
+// Per-thread state.  A thread claims a free slot for the duration of each
+// Append/Pop; the retired list stays with the slot, not the thread, so no
+// cleanup is needed when threads exit.  Each slot has a cache line to
+// itself, so threads working on their own slots don't false-share.
+typedef struct lfq_slot {
+  int                in_use __attribute__((aligned(64)));  // claimed?
+  LockFreeQueueNode *hazards[LFQ_HAZARDS_PER_THREAD];  // nodes in use
+  LockFreeQueueNode *retired;      // popped nodes awaiting reclamation
+  int                num_retired;  // length of the retired list
+  int64_t            num_appended;  // Appends done through this slot
+  int64_t            num_popped;    // successful Pops done through it
+} LockFreeQueueSlot;
+
+// The queue itself.  head and tail sit on separate cache lines so that
+// producers and consumers don't false-share.  The element count is kept
+// in the slots.
+typedef struct lfq {
+  LockFreeQueueNode *head __attribute__((aligned(64)));  // the dummy node
+  LockFreeQueueNode *tail __attribute__((aligned(64)));  // last node
+  LockFreeQueueSlot  slots[LFQ_MAX_THREADS];
+} LockFreeQueue;
+
+#endif  // HW0_LOCKFREEQUEUE_PRIV_H_
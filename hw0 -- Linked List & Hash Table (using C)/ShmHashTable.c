@@ -0,0 +1,414 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // for shm_open, ftruncate, etc. under c11
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ShmHashTable.h"
+#include "ShmHashTable_priv.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+//
+
+// Readers walk the table while a writer may be changing it, so every field
+// a reader looks at is read and written as a single atomic word.  Relaxed
+// ordering is enough; the sequence counter supplies the fences.
+#define RELAXED_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define RELAXED_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+
+// Translate offsets within the segment into pointers in this process.
+static ShmOffset_t* BucketAt(ShmHashTableHeader *hdr, int bucket) {
+  return (ShmOffset_t *) ((char *) hdr + hdr->buckets) + bucket;
+}
+
+static ShmHashTableNode* NodeAt(ShmHashTableHeader *hdr, ShmOffset_t off) {
+  return (ShmHashTableNode *) ((char *) hdr + off);
+}
+
+static int ShmHashKeyToBucketNum(ShmHashTableHeader *hdr, HTKey_t key) {
+  return key % hdr->num_buckets;
+}
+
+// Walks the chain for key.  If found, returns true and the link that points
+// at the matching node (either a bucket head or some node's next field)
+// through prev_link, so the caller can unlink it without a second scan.
+// Caller holds the writer lock.
+static bool FindLink(ShmHashTableHeader *hdr, HTKey_t key,
+                     ShmOffset_t **prev_link) {
+  ShmOffset_t *link = BucketAt(hdr, ShmHashKeyToBucketNum(hdr, key));
+
+  while (*link != SHM_NULL_OFFSET) {
+    ShmHashTableNode *node = NodeAt(hdr, *link);
+    if (node->kv.key == key) {
+      *prev_link = link;
+      return true;
+    }
+    link = &node->next;
+  }
+  return false;
+}
+
+// Returns true if off is the offset of a node in the pool.  A reader racing
+// with a writer may see a stale link, but never one that leads outside the
+// pool, since nodes are recycled and never unmapped.  We still check, so
+// that a torn walk can't stray out of the segment.
+static bool IsNodeOffset(ShmHashTableHeader *hdr, ShmOffset_t off) {
+  return off >= hdr->nodes &&
+         off < hdr->nodes + (ShmOffset_t) hdr->max_elements *
+                            sizeof(ShmHashTableNode) &&
+         (off - hdr->nodes) % sizeof(ShmHashTableNode) == 0;
+}
+
+// One optimistic, lock-free walk of key's chain.  Returns 1 if found (with
+// the pair in keyvalue), 0 if not, or -1 if the walk went somewhere it
+// shouldn't have because of a concurrent write and must be retried.
+static int TryFind(ShmHashTableHeader *hdr, HTKey_t key,
+                   ShmHTKeyValue_t *keyvalue) {
+  ShmOffset_t off = RELAXED_LOAD(BucketAt(hdr,
+                                          ShmHashKeyToBucketNum(hdr, key)));
+  int steps;
+
+  // A chain can't be longer than the pool, so anything longer is a cycle
+  // formed by nodes that moved while we walked.
+  for (steps = 0; off != SHM_NULL_OFFSET; steps++) {
+    ShmHashTableNode *node;
+
+    if (steps > hdr->max_elements || !IsNodeOffset(hdr, off)) {
+      return -1;
+    }
+    node = NodeAt(hdr, off);
+    if (RELAXED_LOAD(&node->kv.key) == key) {
+      keyvalue->key = key;
+      keyvalue->value = RELAXED_LOAD(&node->kv.value);
+      return 1;
+    }
+    off = RELAXED_LOAD(&node->next);
+  }
+  return 0;
+}
+
+// Called with the writer lock just taken from a writer that died holding
+// it, maybe halfway through a change.  Every store a writer makes leaves
+// the chains walkable, so the worst it can have left is a node that is on
+// no chain (which is leaked) and a wrong element count.  Recount, make the
+// sequence counter even again (which also sends any reader that started
+// before the crash back to retry), and mark the lock usable.
+static void RecoverFromDeadWriter(ShmHashTableHeader *hdr) {
+  int count = 0, i;
+
+  for (i = 0; i < hdr->num_buckets; i++) {
+    ShmOffset_t off;
+    for (off = *BucketAt(hdr, i); off != SHM_NULL_OFFSET;
+         off = NodeAt(hdr, off)->next) {
+      count++;
+    }
+  }
+  RELAXED_STORE(&hdr->num_elements, count);
+  if (hdr->seq % 2 == 1) {
+    __atomic_store_n(&hdr->seq, hdr->seq + 1, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_consistent(&hdr->lock);
+}
+
+// Writers bracket every change with these.  The sequence counter is odd for
+// the duration of the change, which tells readers to retry.
+static void BeginWrite(ShmHashTableHeader *hdr) {
+  if (pthread_mutex_lock(&hdr->lock) == EOWNERDEAD) {
+    RecoverFromDeadWriter(hdr);
+  }
+  RELAXED_STORE(&hdr->seq, hdr->seq + 1);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void EndWrite(ShmHashTableHeader *hdr) {
+  __atomic_store_n(&hdr->seq, hdr->seq + 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&hdr->lock);
+}
+
+// How many times a reader spins before it starts yielding the CPU.
+#define SHM_SPIN_LIMIT 64
+
+// Waits a little before a reader retries.  A write takes well under a
+// microsecond, so spin at first (with a pause, which frees the core for
+// a sibling hyperthread); after that the writer has likely been
+// descheduled, so yield to it.  Every so often, check whether the writer
+// died holding the lock: then nobody else may ever come along to clean up,
+// and the sequence counter would stay odd forever.
+static void Backoff(ShmHashTableHeader *hdr, int *spins) {
+  int result;
+
+  *spins += 1;
+  if (*spins < SHM_SPIN_LIMIT) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+    return;
+  }
+  if (*spins % SHM_SPIN_LIMIT == 0) {
+    result = pthread_mutex_trylock(&hdr->lock);
+    if (result == EOWNERDEAD) {
+      RecoverFromDeadWriter(hdr);
+    }
+    if (result == 0 || result == EOWNERDEAD) {
+      pthread_mutex_unlock(&hdr->lock);
+    }
+  }
+  sched_yield();
+}
+
+// Hands out a node from the free list, or else from the untouched part of
+// the pool.  Returns 0 if the pool is exhausted.  Caller holds the lock.
+static ShmOffset_t AllocateNode(ShmHashTableHeader *hdr) {
+  ShmOffset_t off = hdr->free_list;
+
+  if (off != SHM_NULL_OFFSET) {
+    hdr->free_list = NodeAt(hdr, off)->next;
+    return off;
+  }
+  if (hdr->num_used == hdr->max_elements) {
+    return SHM_NULL_OFFSET;
+  }
+  off = hdr->nodes + (ShmOffset_t) hdr->num_used * sizeof(ShmHashTableNode);
+  hdr->num_used += 1;
+  return off;
+}
+
+// Maps the whole of the shared-memory object behind fd.
+static ShmHashTable* MapSegment(int fd, size_t size) {
+  ShmHashTable *table;
+  void *addr;
+
+  table = (ShmHashTable *) malloc(sizeof(ShmHashTable));
+  if (!table) {
+    return NULL;
+  }
+  addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    perror("mmap failed");
+    free(table);
+    return NULL;
+  }
+  table->hdr = (ShmHashTableHeader *) addr;
+  table->size = size;
+  return table;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ShmHashTable implementation.
+
+ShmHashTable* ShmHashTable_Create(const char *name,
+                                  int num_buckets,
+                                  int max_elements) {
+  ShmHashTable *table;
+  ShmHashTableHeader *hdr;
+  pthread_mutexattr_t attr;
+  size_t size;
+  int fd, i;
+
+  if (num_buckets <= 0 || max_elements <= 0) {
+    return NULL;
+  }
+
+  // Lay out header, bucket array and node pool back to back.  The header
+  // and node sizes are multiples of 8, so every offset stays aligned.
+  size = sizeof(ShmHashTableHeader)
+       + (size_t) num_buckets * sizeof(ShmOffset_t)
+       + (size_t) max_elements * sizeof(ShmHashTableNode);
+
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd == -1) {
+    perror("shm_open failed");
+    return NULL;
+  }
+  if (ftruncate(fd, size) == -1) {    // also zero-fills the segment
+    perror("ftruncate failed");
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+  table = MapSegment(fd, size);
+  close(fd);                          // the mapping keeps the object alive
+  if (!table) {
+    shm_unlink(name);
+    return NULL;
+  }
+
+  // Initialize the header.  The magic number is published last, so a
+  // concurrent ShmHashTable_Open never sees a half-built table.
+  hdr = table->hdr;
+  hdr->segment_size = size;
+  hdr->num_buckets = num_buckets;
+  hdr->max_elements = max_elements;
+  hdr->num_elements = 0;
+  hdr->num_used = 0;
+  hdr->buckets = sizeof(ShmHashTableHeader);
+  hdr->nodes = hdr->buckets + (ShmOffset_t) num_buckets * sizeof(ShmOffset_t);
+  hdr->free_list = SHM_NULL_OFFSET;
+  hdr->seq = 0;
+  for (i = 0; i < num_buckets; i++) {
+    *BucketAt(hdr, i) = SHM_NULL_OFFSET;
+  }
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);  // see BeginWrite
+  pthread_mutex_init(&hdr->lock, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  __atomic_store_n(&hdr->magic, SHM_HT_MAGIC, __ATOMIC_RELEASE);
+  return table;
+}
+
+ShmHashTable* ShmHashTable_Open(const char *name) {
+  ShmHashTable *table;
+  struct stat st;
+  int fd;
+
+  fd = shm_open(name, O_RDWR, 0);
+  if (fd == -1) {
+    return NULL;
+  }
+  if (fstat(fd, &st) == -1 ||
+      (size_t) st.st_size < sizeof(ShmHashTableHeader)) {
+    close(fd);
+    return NULL;
+  }
+  table = MapSegment(fd, st.st_size);
+  close(fd);
+  if (!table) {
+    return NULL;
+  }
+
+  if (__atomic_load_n(&table->hdr->magic, __ATOMIC_ACQUIRE) != SHM_HT_MAGIC ||
+      table->hdr->segment_size != table->size) {
+    ShmHashTable_Close(table);
+    return NULL;
+  }
+  return table;
+}
+
+void ShmHashTable_Close(ShmHashTable *table) {
+  munmap(table->hdr, table->size);
+  free(table);
+}
+
+bool ShmHashTable_Unlink(const char *name) {
+  return shm_unlink(name) == 0;
+}
+
+int ShmHashTable_NumElements(ShmHashTable *table) {
+  return RELAXED_LOAD(&table->hdr->num_elements);
+}
+
+bool ShmHashTable_Insert(ShmHashTable *table,
+                         ShmHTKeyValue_t newkeyvalue,
+                         ShmHTKeyValue_t *oldkeyvalue) {
+  ShmHashTableHeader *hdr = table->hdr;
+  ShmHashTableNode *node;
+  ShmOffset_t *link, *head, off;
+
+  BeginWrite(hdr);
+
+  if (FindLink(hdr, newkeyvalue.key, &link)) {  // the key already exists
+    node = NodeAt(hdr, *link);
+    *oldkeyvalue = node->kv;
+    RELAXED_STORE(&node->kv.value, newkeyvalue.value);
+    EndWrite(hdr);
+    return true;
+  }
+
+  off = AllocateNode(hdr);
+  if (off == SHM_NULL_OFFSET) {                 // the table is full
+    EndWrite(hdr);
+    return false;
+  }
+
+  // Push onto the front of the chain; order within a chain doesn't matter.
+  head = BucketAt(hdr, ShmHashKeyToBucketNum(hdr, newkeyvalue.key));
+  node = NodeAt(hdr, off);
+  RELAXED_STORE(&node->kv.key, newkeyvalue.key);
+  RELAXED_STORE(&node->kv.value, newkeyvalue.value);
+  RELAXED_STORE(&node->next, *head);
+  RELAXED_STORE(head, off);
+  RELAXED_STORE(&hdr->num_elements, hdr->num_elements + 1);
+
+  EndWrite(hdr);
+  return false;
+}
+
+bool ShmHashTable_Find(ShmHashTable *table,
+                       HTKey_t key,
+                       ShmHTKeyValue_t *keyvalue) {
+  ShmHashTableHeader *hdr = table->hdr;
+  ShmHTKeyValue_t kv;
+  uint64_t seq;
+  int found, spins = 0;
+
+  // Read without locking, and retry if a writer was active at any point
+  // during the walk.  Every retry backs off, so readers don't keep pulling
+  // the lines a writer is working on away from it.
+  while (true) {
+    seq = __atomic_load_n(&hdr->seq, __ATOMIC_ACQUIRE);
+    if (seq % 2 == 1) {
+      Backoff(hdr, &spins);               // a write is in progress
+      continue;
+    }
+    found = TryFind(hdr, key, &kv);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (found != -1 && RELAXED_LOAD(&hdr->seq) == seq) {
+      break;
+    }
+    Backoff(hdr, &spins);                 // a write began during the walk
+  }
+
+  if (found == 1) {
+    *keyvalue = kv;
+  }
+  return found == 1;
+}
+
+bool ShmHashTable_Remove(ShmHashTable *table,
+                         HTKey_t key,
+                         ShmHTKeyValue_t *keyvalue) {
+  ShmHashTableHeader *hdr = table->hdr;
+  ShmHashTableNode *node;
+  ShmOffset_t *link, off;
+
+  BeginWrite(hdr);
+
+  if (!FindLink(hdr, key, &link)) {
+    EndWrite(hdr);
+    return false;
+  }
+
+  // Splice the node out of its chain and onto the free list.
+  off = *link;
+  node = NodeAt(hdr, off);
+  *keyvalue = node->kv;
+  RELAXED_STORE(link, node->next);
+  RELAXED_STORE(&node->next, hdr->free_list);
+  hdr->free_list = off;
+  RELAXED_STORE(&hdr->num_elements, hdr->num_elements - 1);
+
+  EndWrite(hdr);
+  return true;
+}
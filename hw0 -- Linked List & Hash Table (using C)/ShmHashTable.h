@@ -0,0 +1,153 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW0_SHMHASHTABLE_H_
+#define HW0_SHMHASHTABLE_H_
+
+#include <stdbool.h>    // for bool type (true, false)
+#include <stdint.h>     // for uint64_t, etc.
+
+#include "./HashTable.h"  // for HTKey_t and FNVHash64
+
+///////////////////////////////////////////////////////////////////////////////
+// A ShmHashTable is a chained hash table that lives entirely inside a named
+// POSIX shared-memory segment, so that several processes can build it once
+// and share it.
+//
+// Every link inside the table is stored as a byte offset from the start of
+// the segment rather than as a raw pointer, so each process may map the
+// segment at a different address.  For the same reason, values cannot be
+// pointers into one process' heap: a value is a plain 64-bit integer (which
+// may of course be an offset into some other shared region).
+//
+// The bucket count and the maximum number of elements are fixed when the
+// table is created; unlike HashTable, a ShmHashTable never resizes.
+//
+// All operations are safe to call concurrently from any number of processes
+// (and threads).  Insert and Remove serialize on a process-shared mutex.
+// Lookups take no lock at all: they read optimistically and retry if a
+// writer changed the table underneath them (a "sequence lock"), so readers
+// never contend with each other.  A process that dies in the middle of an Insert or
+// Remove doesn't take the table with it: the next writer, or a reader kept
+// waiting, repairs it, at the cost of at most one node of the pool.
+typedef struct sht ShmHashTable;
+
+typedef uint64_t ShmHTValue_t;  // shared hash table value type
+typedef struct {
+  HTKey_t      key;    // the key in the (key,value) pair
+  ShmHTValue_t value;  // the value in the (key,value) pair
+} ShmHTKeyValue_t;
+
+// Create a new, empty ShmHashTable in a shared-memory segment called `name`
+// and map it into this process.  The caller is responsible for eventually
+// calling ShmHashTable_Close, and for calling ShmHashTable_Unlink once no
+// process needs the segment any more.
+//
+// Arguments:
+// - name: the shared-memory object name; per shm_open(3), it should
+//   look like "/some_name".  Fails if the object already exists.
+// - num_buckets: the number of buckets; MUST be greater than zero.
+// - max_elements: the most (key,value) pairs the table can ever hold;
+//   MUST be greater than zero.
+//
+// Returns NULL on error, non-NULL on success.
+ShmHashTable* ShmHashTable_Create(const char *name,
+                                  int num_buckets,
+                                  int max_elements);
+
+// Map an existing ShmHashTable, created by ShmHashTable_Create in this or
+// another process, into this process.
+//
+// Arguments:
+// - name: the shared-memory object name passed to ShmHashTable_Create.
+//
+// Returns NULL on error (eg, no such segment), non-NULL on success.
+ShmHashTable* ShmHashTable_Open(const char *name);
+
+// Unmap a ShmHashTable from this process.  The table itself, and its
+// contents, stay in shared memory for other processes.
+//
+// Arguments:
+// - table: the table to close.  It is unsafe to use table after this
+//   function returns.
+void ShmHashTable_Close(ShmHashTable *table);
+
+// Remove the name of a ShmHashTable's segment.  Processes that already
+// have the table open may keep using it; the memory is released once the
+// last of them closes it.
+//
+// Arguments:
+// - name: the shared-memory object name passed to ShmHashTable_Create.
+//
+// Returns:
+// - true on success, false if there was no such segment.
+bool ShmHashTable_Unlink(const char *name);
+
+// Figure out the number of elements in the table.
+//
+// Arguments:
+// - table: the table to query.
+//
+// Returns:
+// - table size (>=0).
+int ShmHashTable_NumElements(ShmHashTable *table);
+
+// Inserts a (key,value) pair into the table.  Same contract as
+// HashTable_Insert, except that there is no memory for the caller to
+// manage.
+//
+// Arguments:
+// - table: the ShmHashTable to insert into.
+// - newkeyvalue: the (key,value) to insert into the table.
+// - oldkeyvalue: if the key was already present, the replaced
+//   (key,value) is returned through this return parameter.
+//
+// Returns:
+//  - false: if newkeyvalue was inserted and there was no existing
+//    (key,value) with that key, or if the table already holds
+//    max_elements pairs, in which case nothing was inserted.
+//  - true: if an old (key,value) with the same key was replaced and
+//    returned through the oldkeyvalue return parameter.
+bool ShmHashTable_Insert(ShmHashTable *table,
+                         ShmHTKeyValue_t newkeyvalue,
+                         ShmHTKeyValue_t *oldkeyvalue);
+
+// Looks up a key in the table.  Same contract as HashTable_Find.
+//
+// Arguments:
+// - table: the ShmHashTable to look in.
+// - key: the key to look up.
+// - keyvalue: if the key is present, a copy of the (key,value) is
+//   returned to the caller via this return parameter.
+//
+// Returns:
+//  - false: if the key wasn't found.
+//  - true: if the key was found and returned through keyvalue.
+bool ShmHashTable_Find(ShmHashTable *table,
+                       HTKey_t key,
+                       ShmHTKeyValue_t *keyvalue);
+
+// Removes a (key,value) from the table.  Same contract as HashTable_Remove.
+//
+// Arguments:
+// - table: the ShmHashTable to remove from.
+// - key: the key to look up.
+// - keyvalue: if the key is present, a copy of the removed (key,value)
+//   is returned to the caller via this return parameter.
+//
+// Returns:
+//  - false: if the key wasn't found.
+//  - true: if the key was found, returned and removed.
+bool ShmHashTable_Remove(ShmHashTable *table,
+                         HTKey_t key,
+                         ShmHTKeyValue_t *keyvalue);
+
+#endif  // HW0_SHMHASHTABLE_H_
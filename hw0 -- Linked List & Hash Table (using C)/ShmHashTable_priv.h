@@ -0,0 +1,70 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW0_SHMHASHTABLE_PRIV_H_
+#define HW0_SHMHASHTABLE_PRIV_H_
+
+#include <stddef.h>   // for size_t
+#include <stdint.h>   // for uint64_t, etc.
+#include <pthread.h>  // for pthread_mutex_t
+
+#include "./ShmHashTable.h"
+
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// Internal structures for our ShmHashTable implementation.
+//
+// As with HashTable_priv.h, these are broken out so that our unittests can
+// peek inside the implementation.  Customers should not include this file
+// or assume anything based on its contents.
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+// An offset from the start of the shared-memory segment.  The header lives
+// at offset 0, so no node can, and 0 doubles as the "NULL" offset.
+typedef uint64_t ShmOffset_t;
+#define SHM_NULL_OFFSET 0
+
+// Written into the header once it is fully initialized, so that
+// ShmHashTable_Open can reject segments that aren't ours.
+#define SHM_HT_MAGIC 0x5348545F43495435ULL
+
+// A single chain node.  Nodes are carved out of a fixed pool that follows
+// the bucket array; removed nodes are kept on a free list for reuse.
+typedef struct sht_node {
+  ShmHTKeyValue_t kv;    // the (key,value) pair stored in this node
+  ShmOffset_t     next;  // next node in the chain (or free list), or 0
+} ShmHashTableNode;
+
+// The segment header, at offset 0 of the shared memory.  The segment is
+// laid out as: header, then num_buckets chain heads, then max_elements
+// nodes.
+typedef struct sht_header {
+  uint64_t          magic;         // SHM_HT_MAGIC once initialized
+  uint64_t          segment_size;  // total bytes in the segment
+  int               num_buckets;   // # of buckets in this HT
+  int               max_elements;  // # of nodes in the pool
+  int               num_elements;  // # of elements currently in this HT
+  int               num_used;      // # of pool nodes ever handed out
+  ShmOffset_t       buckets;       // offset of the chain-head array
+  ShmOffset_t       nodes;         // offset of the node pool
+  ShmOffset_t       free_list;     // first recycled node, or 0
+  uint64_t          seq;           // bumped before and after every write;
+                                   // odd while a write is in progress
+  pthread_mutex_t   lock;          // process-shared, robust lock between
+                                   // writers
+} ShmHashTableHeader;
+
+// The per-process handle returned to customers.
+typedef struct sht {
+  ShmHashTableHeader *hdr;   // where the segment is mapped in this process
+  size_t              size;  // the size of that mapping
+} ShmHashTable;
+
+#endif  // HW0_SHMHASHTABLE_PRIV_H_
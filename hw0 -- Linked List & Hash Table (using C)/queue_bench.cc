@@ -0,0 +1,164 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+// Compares the throughput of LockFreeQueue with the LinkedList + mutex
+// pattern it replaces, with n producers and n consumers for n = 1 to 16.
+// Both queues are built optimized for this (see the makefile), so it
+// measures the algorithms and not -O0; test_suite's Throughput test runs
+// the same comparison on the unoptimized, graded build.
+//
+// Each run is repeated a number of trials, and the best is reported, as
+// operations (appends plus pops) a second.
+//
+// Usage: ./queue_bench [-n trials] [-o operations]
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+extern "C" {
+  #include "./LinkedList.h"
+  #include "./LockFreeQueue.h"
+}
+
+using std::vector;
+
+static uint64_t get_ns() {
+  struct timespec spec;
+  clock_gettime(CLOCK_MONOTONIC, &spec);
+  return spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+}
+
+static void NoFree(LLPayload_t payload) { }
+
+// The LinkedList + mutex pattern, behind the same interface as the
+// lock-free queue.
+struct MutexQueue {
+  LinkedList *list;
+  pthread_mutex_t lock;
+};
+
+static void MutexAppend(void *q, LLPayload_t p) {
+  MutexQueue *mq = static_cast<MutexQueue *>(q);
+  pthread_mutex_lock(&mq->lock);
+  LinkedList_Append(mq->list, p);
+  pthread_mutex_unlock(&mq->lock);
+}
+
+static bool MutexPop(void *q, LLPayload_t *p) {
+  MutexQueue *mq = static_cast<MutexQueue *>(q);
+  pthread_mutex_lock(&mq->lock);
+  bool ok = LinkedList_Pop(mq->list, p);
+  pthread_mutex_unlock(&mq->lock);
+  return ok;
+}
+
+static void LockFreeAppend(void *q, LLPayload_t p) {
+  LockFreeQueue_Append(static_cast<LockFreeQueue *>(q), p);
+}
+
+static bool LockFreePop(void *q, LLPayload_t *p) {
+  return LockFreeQueue_Pop(static_cast<LockFreeQueue *>(q), p);
+}
+
+// Runs num_threads producers that each append per_thread payloads while
+// num_threads consumers pop them all, and returns the elapsed time in ns.
+static uint64_t Run(void *queue, void (*append)(void *, LLPayload_t),
+                    bool (*pop)(void *, LLPayload_t *), int num_threads,
+                    int per_thread) {
+  std::atomic<int> remaining(num_threads * per_thread);
+  vector<std::thread> threads;
+
+  uint64_t start = get_ns();
+  for (int c = 0; c < num_threads; c++) {
+    threads.emplace_back([&]() {
+      LLPayload_t p;
+      while (remaining.load() > 0) {
+        if (pop(queue, &p)) {
+          remaining--;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&]() {
+      for (int s = 0; s < per_thread; s++) {
+        append(queue, reinterpret_cast<LLPayload_t>(s + 1));
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  return get_ns() - start;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "usage: %s [-n trials] [-o operations]\n", prog);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  int trials = 5;
+  int total = 200000;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:o:")) != -1) {
+    switch (opt) {
+      case 'n':
+        trials = atoi(optarg);
+        break;
+      case 'o':
+        total = atoi(optarg);
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (trials <= 0 || total <= 0 || optind != argc) {
+    usage(argv[0]);
+  }
+
+  for (int n = 1; n <= 16; n *= 2) {
+    uint64_t lf_ns = UINT64_MAX, mutex_ns = UINT64_MAX;
+    for (int i = 0; i < trials; i++) {
+      LockFreeQueue *queue = LockFreeQueue_Allocate();
+      lf_ns = std::min(lf_ns, Run(queue, &LockFreeAppend, &LockFreePop, n,
+                                  total / n));
+      LockFreeQueue_Free(queue, &NoFree);
+
+      MutexQueue mq;
+      mq.list = LinkedList_Allocate();
+      pthread_mutex_init(&mq.lock, NULL);
+      mutex_ns = std::min(mutex_ns, Run(&mq, &MutexAppend, &MutexPop, n,
+                                        total / n));
+      pthread_mutex_destroy(&mq.lock);
+      LinkedList_Free(mq.list, &NoFree);
+    }
+
+    double ops = 2.0 * (total / n) * n;
+    printf("%d producer(s) / %d consumer(s): %lu ops/s lock-free, "
+           "%lu ops/s LinkedList + mutex\n", n, n,
+           static_cast<unsigned long>(ops / (lf_ns / 1e9)),
+           static_cast<unsigned long>(ops / (mutex_ns / 1e9)));
+  }
+  return EXIT_SUCCESS;
+}
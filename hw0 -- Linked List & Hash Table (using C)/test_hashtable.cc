@@ -335,6 +335,79 @@ TEST_F(Test_HashTable, Iterator) {
 
 static void NoOpFree(HTValue_t freeme) { }
 
+static bool IsEvenKey(HTKeyValue_t *keyvalue) {
+  return keyvalue->key % 2 == 0;
+}
+
+TEST_F(Test_HashTable, IteratorRemoveAll) {
+  HW0Environment::OpenTestCase();
+  HTKeyValue_t oldkv, newkv;
+  HashTable *table = HashTable_Allocate(7);
+
+  // Use few buckets so that chains are long and removal hits heads,
+  // tails and middles of chains.
+  for (int i = 0; i < 100; i++) {
+    Payload *np = static_cast<Payload *>(malloc(sizeof(Payload)));
+    ASSERT_TRUE(np != NULL);
+    np->magic_num = kMagicNum;
+    np->payload_num = i;
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = np;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  int num_buckets = table->num_buckets;
+
+  // Drain the whole table through the iterator, checking that every
+  // element is visited exactly once and the table never resizes.
+  int num_times_seen[100] = { 0 };
+  HTIterator *it = HTIterator_Allocate(table);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(HTIterator_IsValid(it));
+    ASSERT_TRUE(HTIterator_Remove(it, &oldkv));
+    ASSERT_EQ(99 - i, HashTable_NumElements(table));
+
+    int htkey = static_cast<int>(oldkv.key);
+    ASSERT_EQ(0, num_times_seen[htkey]);
+    num_times_seen[htkey]++;
+
+    Payload *op = static_cast<Payload *>(oldkv.value);
+    ASSERT_EQ(htkey, op->payload_num);
+    free(op);
+  }
+  ASSERT_FALSE(HTIterator_IsValid(it));
+  ASSERT_FALSE(HTIterator_Remove(it, &oldkv));
+  HTIterator_Free(it);
+  ASSERT_EQ(num_buckets, table->num_buckets);
+  for (int i = 0; i < num_buckets; i++) {
+    ASSERT_EQ(0, LinkedList_NumElements(table->buckets[i]));
+  }
+  HW0Environment::AddPoints(5);
+
+  // Refill, then bulk-remove the even keys in one sweep.
+  for (int i = 0; i < 100; i++) {
+    Payload *np = static_cast<Payload *>(malloc(sizeof(Payload)));
+    ASSERT_TRUE(np != NULL);
+    np->magic_num = kMagicNum;
+    np->payload_num = i;
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = np;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(50, HashTable_RemoveIf(table, &IsEvenKey,
+                                   &Test_HashTable::InstrumentedFree));
+  ASSERT_EQ(50, freeInvocations_);
+  ASSERT_EQ(50, HashTable_NumElements(table));
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(i % 2 == 1, HashTable_Find(table, i, &oldkv));
+  }
+  ASSERT_EQ(0, HashTable_RemoveIf(table, &IsEvenKey,
+                                  &Test_HashTable::InstrumentedFree));
+
+  HashTable_Free(table, &Test_HashTable::InstrumentedFree);
+  ASSERT_EQ(100, freeInvocations_);
+  HW0Environment::AddPoints(5);
+}
+
 TEST_F(Test_HashTable, Resize) {
   HW0Environment::OpenTestCase();
   HashTable *table = HashTable_Allocate(2);
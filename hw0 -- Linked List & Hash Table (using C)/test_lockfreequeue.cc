@@ -0,0 +1,334 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+  #include "./LinkedList.h"
+  #include "./LockFreeQueue.h"
+  #include "./LockFreeQueue_priv.h"
+}
+
+#include "gtest/gtest.h"
+
+#include "./test_suite.h"
+
+using std::vector;
+
+namespace hw0 {
+
+// Payloads are encoded as (producer << 32 | sequence number) + 1, so
+// none of them is NULL.
+static LLPayload_t Encode(uint64_t producer, uint64_t seq) {
+  return reinterpret_cast<LLPayload_t>(((producer << 32) | seq) + 1);
+}
+static uint64_t Producer(LLPayload_t p) {
+  return (reinterpret_cast<uint64_t>(p) - 1) >> 32;
+}
+static uint64_t Sequence(LLPayload_t p) {
+  return (reinterpret_cast<uint64_t>(p) - 1) & 0xFFFFFFFFULL;
+}
+
+class Test_LockFreeQueue : public ::testing::Test {
+ protected:
+  // Code here will be called before each test executes (ie, before
+  // each TEST_F).
+  virtual void SetUp() {
+    freeInvocations_ = 0;
+  }
+
+  // A stubbed free() which only counts its invocations.  Note that the
+  // counter is reset in SetUp().
+  static std::atomic<int> freeInvocations_;
+  static void StubbedFree(LLPayload_t payload) {
+    freeInvocations_++;
+  }
+};  // class Test_LockFreeQueue
+
+// statics:
+std::atomic<int> Test_LockFreeQueue::freeInvocations_;
+
+static uint64_t get_ns() {
+  struct timespec spec;
+  clock_gettime(CLOCK_MONOTONIC, &spec);
+  return spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+}
+
+// A common interface over the lock-free queue and the LinkedList + mutex
+// pattern it replaces, so both can run through the same benchmark.
+struct MutexQueue {
+  LinkedList *list;
+  pthread_mutex_t lock;
+};
+
+static void MutexAppend(void *q, LLPayload_t p) {
+  MutexQueue *mq = static_cast<MutexQueue *>(q);
+  pthread_mutex_lock(&mq->lock);
+  LinkedList_Append(mq->list, p);
+  pthread_mutex_unlock(&mq->lock);
+}
+
+static bool MutexPop(void *q, LLPayload_t *p) {
+  MutexQueue *mq = static_cast<MutexQueue *>(q);
+  pthread_mutex_lock(&mq->lock);
+  bool ok = LinkedList_Pop(mq->list, p);
+  pthread_mutex_unlock(&mq->lock);
+  return ok;
+}
+
+static void LockFreeAppend(void *q, LLPayload_t p) {
+  LockFreeQueue_Append(static_cast<LockFreeQueue *>(q), p);
+}
+
+static bool LockFreePop(void *q, LLPayload_t *p) {
+  return LockFreeQueue_Pop(static_cast<LockFreeQueue *>(q), p);
+}
+
+// When the append and the pop of one payload were invoked and returned,
+// in ns.  The times are taken just outside each call, so each interval
+// holds the real one.
+struct OpTimes {
+  uint64_t append_invoked, append_returned;
+  uint64_t pop_invoked, pop_returned;
+};
+
+// Runs num_producers threads that each append per_producer payloads while
+// num_consumers threads pop until everything has been consumed.  Each
+// consumer's popped payloads are returned in consumed[consumer], in the
+// order that consumer saw them.  If times isn't NULL, the times of each
+// payload's append and pop are returned in (*times)[producer][sequence].
+// Returns the elapsed time in ns.
+static uint64_t RunProducersConsumers(void *queue,
+                                      void (*append)(void *, LLPayload_t),
+                                      bool (*pop)(void *, LLPayload_t *),
+                                      int num_producers, int num_consumers,
+                                      int per_producer,
+                                      vector<vector<LLPayload_t>> *consumed,
+                                      vector<vector<OpTimes>> *times = NULL) {
+  std::atomic<int> remaining(num_producers * per_producer);
+  vector<std::thread> threads;
+
+  consumed->assign(num_consumers, vector<LLPayload_t>());
+  if (times != NULL) {
+    times->assign(num_producers, vector<OpTimes>(per_producer, OpTimes()));
+  }
+  uint64_t start = get_ns();
+  for (int c = 0; c < num_consumers; c++) {
+    threads.emplace_back([&, c]() {
+      vector<LLPayload_t> &mine = (*consumed)[c];
+      LLPayload_t p;
+      while (remaining.load() > 0) {
+        uint64_t invoked = times != NULL ? get_ns() : 0;
+        if (pop(queue, &p)) {
+          uint64_t returned = times != NULL ? get_ns() : 0;
+          // Each payload is popped once, so its times have one writer.
+          // (Payloads the queue made up are caught by the caller.)
+          if (times != NULL && Producer(p) < times->size() &&
+              Sequence(p) < (*times)[Producer(p)].size()) {
+            OpTimes &t = (*times)[Producer(p)][Sequence(p)];
+            t.pop_invoked = invoked;
+            t.pop_returned = returned;
+          }
+          mine.push_back(p);
+          remaining--;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int i = 0; i < num_producers; i++) {
+    threads.emplace_back([&, i]() {
+      for (int s = 0; s < per_producer; s++) {
+        uint64_t invoked = times != NULL ? get_ns() : 0;
+        append(queue, Encode(i, s));
+        if (times != NULL) {
+          (*times)[i][s].append_invoked = invoked;
+          (*times)[i][s].append_returned = get_ns();
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  return get_ns() - start;
+}
+
+// Looks for two payloads a and b whose pops contradict the real-time
+// order of their appends: a's append returned before b's began, yet b's
+// pop returned before a's began.  A FIFO queue can't do that, however its
+// operations are linearized.  Nor can a pop return before the append of
+// its payload began.  Returns false and sets *what if it finds either.
+static bool CheckRealTimeOrder(const vector<vector<OpTimes>> &times,
+                               std::string *what) {
+  vector<OpTimes> ops;
+  for (const auto &row : times) {
+    ops.insert(ops.end(), row.begin(), row.end());
+  }
+  for (const OpTimes &op : ops) {
+    if (op.pop_returned < op.append_invoked) {
+      *what = "a payload was popped before it was appended";
+      return false;
+    }
+  }
+
+  // Go through the appends in the order they began.  Each one's pop must
+  // not return before the latest-beginning pop of the payloads whose
+  // appends had already returned.
+  vector<const OpTimes *> by_invoked, by_returned;
+  for (const OpTimes &op : ops) {
+    by_invoked.push_back(&op);
+    by_returned.push_back(&op);
+  }
+  std::sort(by_invoked.begin(), by_invoked.end(),
+            [](const OpTimes *x, const OpTimes *y) {
+              return x->append_invoked < y->append_invoked;
+            });
+  std::sort(by_returned.begin(), by_returned.end(),
+            [](const OpTimes *x, const OpTimes *y) {
+              return x->append_returned < y->append_returned;
+            });
+  size_t done = 0;
+  uint64_t latest_pop = 0;
+  for (const OpTimes *b : by_invoked) {
+    while (done < by_returned.size() &&
+           by_returned[done]->append_returned < b->append_invoked) {
+      latest_pop = std::max(latest_pop, by_returned[done]->pop_invoked);
+      done++;
+    }
+    if (b->pop_returned < latest_pop) {
+      *what = "a payload appended later was popped first";
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST_F(Test_LockFreeQueue, Basic) {
+  HW0Environment::OpenTestCase();
+  LLPayload_t p;
+
+  LockFreeQueue *queue = LockFreeQueue_Allocate();
+  ASSERT_TRUE(queue != NULL);
+  ASSERT_EQ(0, LockFreeQueue_NumElements(queue));
+  ASSERT_FALSE(LockFreeQueue_Pop(queue, &p));
+
+  // Single-threaded, it behaves exactly like LinkedList_Append/Pop.
+  for (uint64_t i = 0; i < 1000; i++) {
+    LockFreeQueue_Append(queue, Encode(0, i));
+  }
+  ASSERT_EQ(1000, LockFreeQueue_NumElements(queue));
+  for (uint64_t i = 0; i < 600; i++) {
+    ASSERT_TRUE(LockFreeQueue_Pop(queue, &p));
+    ASSERT_EQ(i, Sequence(p));
+  }
+  ASSERT_EQ(400, LockFreeQueue_NumElements(queue));
+  HW0Environment::AddPoints(5);
+
+  // Popped nodes are reclaimed as we go rather than piling up.
+  ASSERT_LT(queue->slots[0].num_retired, LFQ_RETIRE_THRESHOLD);
+
+  LockFreeQueue_Free(queue, &Test_LockFreeQueue::StubbedFree);
+  ASSERT_EQ(400, freeInvocations_);
+  HW0Environment::AddPoints(5);
+}
+
+TEST_F(Test_LockFreeQueue, Stress) {
+  HW0Environment::OpenTestCase();
+  const int kProducers = 4, kConsumers = 4, kPerProducer = 50000;
+  vector<vector<LLPayload_t>> consumed;
+  vector<vector<OpTimes>> times;
+
+  LockFreeQueue *queue = LockFreeQueue_Allocate();
+  ASSERT_TRUE(queue != NULL);
+  RunProducersConsumers(queue, &LockFreeAppend, &LockFreePop,
+                        kProducers, kConsumers, kPerProducer, &consumed,
+                        &times);
+
+  // Every payload comes out exactly once, and each consumer sees any one
+  // producer's payloads in increasing sequence order, as a FIFO queue must.
+  vector<vector<int>> seen(kProducers, vector<int>(kPerProducer, 0));
+  for (const auto &mine : consumed) {
+    vector<int64_t> last(kProducers, -1);
+    for (LLPayload_t p : mine) {
+      uint64_t prod = Producer(p), seq = Sequence(p);
+      ASSERT_LT(prod, static_cast<uint64_t>(kProducers));
+      ASSERT_LT(seq, static_cast<uint64_t>(kPerProducer));
+      ASSERT_LT(last[prod], static_cast<int64_t>(seq));
+      last[prod] = seq;
+      seen[prod][seq]++;
+    }
+  }
+  for (int i = 0; i < kProducers; i++) {
+    for (int s = 0; s < kPerProducer; s++) {
+      ASSERT_EQ(1, seen[i][s]);
+    }
+  }
+  ASSERT_EQ(0, LockFreeQueue_NumElements(queue));
+  HW0Environment::AddPoints(10);
+
+  // With those, a queue history is linearizable unless a pop contradicts
+  // the real-time order of the appends, or a pop came back empty while the
+  // queue had to hold something.  The first is checked here; the empty
+  // pops aren't recorded.
+  std::string what;
+  ASSERT_TRUE(CheckRealTimeOrder(times, &what)) << what;
+  HW0Environment::AddPoints(5);
+
+  LockFreeQueue_Free(queue, &Test_LockFreeQueue::StubbedFree);
+  ASSERT_EQ(0, freeInvocations_);
+  HW0Environment::AddPoints(5);
+}
+
+// This runs on the unoptimized build, like the rest of the suite, so the
+// numbers say little about either queue; "make bench" runs the same
+// comparison with both optimized.
+TEST_F(Test_LockFreeQueue, Throughput) {
+  HW0Environment::OpenTestCase();
+  const int kTotal = 200000;
+  vector<vector<LLPayload_t>> consumed;
+
+  for (int n = 1; n <= 16; n *= 2) {
+    LockFreeQueue *queue = LockFreeQueue_Allocate();
+    uint64_t lf_ns = RunProducersConsumers(queue, &LockFreeAppend,
+                                           &LockFreePop, n, n, kTotal / n,
+                                           &consumed);
+    LockFreeQueue_Free(queue, &Test_LockFreeQueue::StubbedFree);
+
+    MutexQueue mq;
+    mq.list = LinkedList_Allocate();
+    pthread_mutex_init(&mq.lock, NULL);
+    uint64_t mutex_ns = RunProducersConsumers(&mq, &MutexAppend, &MutexPop,
+                                              n, n, kTotal / n, &consumed);
+    pthread_mutex_destroy(&mq.lock);
+    LinkedList_Free(mq.list, &Test_LockFreeQueue::StubbedFree);
+
+    double ops = 2.0 * (kTotal / n) * n;
+    std::cout << n << " producer(s) / " << n << " consumer(s): "
+              << static_cast<uint64_t>(ops / (lf_ns / 1e9))
+              << " ops/s lock-free, "
+              << static_cast<uint64_t>(ops / (mutex_ns / 1e9))
+              << " ops/s LinkedList + mutex" << std::endl;
+  }
+  HW0Environment::AddPoints(5);
+}
+
+}  // namespace hw0
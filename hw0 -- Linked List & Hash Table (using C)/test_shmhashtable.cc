@@ -0,0 +1,338 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <time.h>
+
+#include <iostream>
+#include <string>
+
+extern "C" {
+  #include "./ShmHashTable.h"
+  #include "./ShmHashTable_priv.h"
+}
+
+#include "gtest/gtest.h"
+
+#include "./test_suite.h"
+
+using std::string;
+
+namespace hw0 {
+
+class Test_ShmHashTable : public ::testing::Test {
+ protected:
+  // Code here will be called before each test executes (ie, before
+  // each TEST_F).  Each test gets its own segment name, so that a
+  // crashed earlier run can't interfere.
+  virtual void SetUp() {
+    name_ = "/cit5950_shm_ht_" + std::to_string(getpid());
+    ShmHashTable_Unlink(name_.c_str());
+  }
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    ShmHashTable_Unlink(name_.c_str());
+  }
+
+  // Forks a child that runs fn(arg) and exits with its return value.
+  static pid_t ForkChild(int (*fn)(const char *, int),
+                         const char *name, int arg) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      _exit(fn(name, arg));
+    }
+    return pid;
+  }
+
+  // Waits for a child forked by ForkChild and returns its exit status,
+  // or -1 if it didn't exit normally.
+  static int WaitChild(pid_t pid) {
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+      return -1;
+    }
+    return WEXITSTATUS(status);
+  }
+
+  static constexpr int kNumKeys = 2000;
+  static constexpr int kNumReaders = 4;
+
+  string name_;
+};  // class Test_ShmHashTable
+
+static uint64_t get_ns() {
+  struct timespec spec;
+  clock_gettime(CLOCK_MONOTONIC, &spec);
+  return spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+}
+
+// Child process bodies.  These can't use gtest assertions, so they report
+// failure through their exit status instead.
+
+// Inserts keys [0, num_keys) with value key * 3, then removes the odd ones,
+// then inserts key num_keys to say it's done.
+static int WriterMain(const char *name, int num_keys) {
+  ShmHashTable *table = ShmHashTable_Open(name);
+  ShmHTKeyValue_t kv, oldkv;
+  if (!table) {
+    return 1;
+  }
+  for (int i = 0; i < num_keys; i++) {
+    kv.key = i;
+    kv.value = i * 3;
+    if (ShmHashTable_Insert(table, kv, &oldkv)) {
+      return 2;
+    }
+  }
+  for (int i = 1; i < num_keys; i += 2) {
+    if (!ShmHashTable_Remove(table, i, &oldkv) || oldkv.value != i * 3ULL) {
+      return 3;
+    }
+  }
+  kv.key = num_keys;
+  kv.value = 0;
+  if (ShmHashTable_Insert(table, kv, &oldkv)) {
+    return 4;
+  }
+  ShmHashTable_Close(table);
+  return 0;
+}
+
+// How long a reader waits for the writer to finish before giving up.
+static const uint64_t kReaderTimeoutNs = 60 * 1000000000ULL;
+
+// Repeatedly scans the table while the writer runs.  Every (key,value) it
+// sees must be one the writer stored.  Once the writer is done (key
+// num_keys is there), the contents must be exactly the even keys.  (The
+// element count is no use for telling when it's done: it passes through
+// num_keys / 2 on the way up, too.)  Fails if the writer doesn't finish
+// within kReaderTimeoutNs.
+static int ReaderMain(const char *name, int num_keys) {
+  ShmHashTable *table = ShmHashTable_Open(name);
+  ShmHTKeyValue_t kv;
+  uint64_t deadline = get_ns() + kReaderTimeoutNs;
+  if (!table) {
+    return 1;
+  }
+  while (!ShmHashTable_Find(table, num_keys, &kv)) {
+    if (get_ns() > deadline) {
+      return 4;
+    }
+    for (int i = 0; i < num_keys; i++) {
+      if (ShmHashTable_Find(table, i, &kv) &&
+          (kv.key != static_cast<HTKey_t>(i) || kv.value != i * 3ULL)) {
+        return 2;
+      }
+    }
+  }
+  for (int i = 0; i < num_keys; i++) {
+    if (ShmHashTable_Find(table, i, &kv) != (i % 2 == 0)) {
+      return 3;
+    }
+  }
+  ShmHashTable_Close(table);
+  return 0;
+}
+
+// Looks up every key `rounds` times.
+static int LookupMain(const char *name, int rounds) {
+  ShmHashTable *table = ShmHashTable_Open(name);
+  ShmHTKeyValue_t kv;
+  int num_keys;
+  if (!table) {
+    return 1;
+  }
+  num_keys = ShmHashTable_NumElements(table);
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < num_keys; i++) {
+      if (!ShmHashTable_Find(table, i, &kv)) {
+        return 2;
+      }
+    }
+  }
+  ShmHashTable_Close(table);
+  return 0;
+}
+
+TEST_F(Test_ShmHashTable, Basic) {
+  HW0Environment::OpenTestCase();
+  ShmHTKeyValue_t kv, oldkv;
+
+  // Bad arguments and missing segments are errors.
+  ASSERT_EQ(nullptr, ShmHashTable_Create(name_.c_str(), 0, 10));
+  ASSERT_EQ(nullptr, ShmHashTable_Open(name_.c_str()));
+
+  ShmHashTable *table = ShmHashTable_Create(name_.c_str(), 3, 4);
+  ASSERT_NE(nullptr, table);
+  ASSERT_EQ(nullptr, ShmHashTable_Create(name_.c_str(), 3, 4));
+  ASSERT_EQ(0, ShmHashTable_NumElements(table));
+
+  // Insert until full, then make sure a fifth key is refused but
+  // replacing an existing key still works.
+  for (int i = 0; i < 4; i++) {
+    kv.key = i;
+    kv.value = 100 + i;
+    ASSERT_FALSE(ShmHashTable_Insert(table, kv, &oldkv));
+  }
+  ASSERT_EQ(4, ShmHashTable_NumElements(table));
+  kv.key = 4;
+  ASSERT_FALSE(ShmHashTable_Insert(table, kv, &oldkv));
+  ASSERT_FALSE(ShmHashTable_Find(table, 4, &kv));
+  kv.key = 2;
+  kv.value = 42;
+  ASSERT_TRUE(ShmHashTable_Insert(table, kv, &oldkv));
+  ASSERT_EQ(2U, oldkv.key);
+  ASSERT_EQ(102U, oldkv.value);
+  ASSERT_EQ(4, ShmHashTable_NumElements(table));
+  HW0Environment::AddPoints(5);
+
+  // A second mapping of the same segment (at a different address) sees
+  // the same table, and removed nodes are recycled.
+  ShmHashTable *other = ShmHashTable_Open(name_.c_str());
+  ASSERT_NE(nullptr, other);
+  ASSERT_NE(table->hdr, other->hdr);
+  ASSERT_TRUE(ShmHashTable_Find(other, 2, &kv));
+  ASSERT_EQ(42U, kv.value);
+  ASSERT_TRUE(ShmHashTable_Remove(other, 0, &oldkv));
+  ASSERT_EQ(100U, oldkv.value);
+  ASSERT_FALSE(ShmHashTable_Remove(other, 0, &oldkv));
+  ASSERT_FALSE(ShmHashTable_Find(table, 0, &kv));
+  kv.key = 7;
+  kv.value = 7;
+  ASSERT_FALSE(ShmHashTable_Insert(table, kv, &oldkv));
+  ASSERT_TRUE(ShmHashTable_Find(other, 7, &kv));
+  ASSERT_EQ(4, ShmHashTable_NumElements(other));
+  ASSERT_EQ(4, table->hdr->num_used);
+
+  ShmHashTable_Close(other);
+  ShmHashTable_Close(table);
+  HW0Environment::AddPoints(5);
+}
+
+TEST_F(Test_ShmHashTable, ReadersAndWriter) {
+  HW0Environment::OpenTestCase();
+  ShmHashTable *table = ShmHashTable_Create(name_.c_str(), 101,
+                                            kNumKeys + 1);
+  ASSERT_NE(nullptr, table);
+
+  // Start the readers first, so they overlap with the writer.
+  pid_t readers[kNumReaders];
+  for (int i = 0; i < kNumReaders; i++) {
+    readers[i] = ForkChild(&ReaderMain, name_.c_str(), kNumKeys);
+    ASSERT_LT(0, readers[i]);
+  }
+  pid_t writer = ForkChild(&WriterMain, name_.c_str(), kNumKeys);
+  ASSERT_LT(0, writer);
+
+  // If the writer failed, it never said it was done, so stop the readers
+  // instead of waiting for them to time out.
+  int writer_status = WaitChild(writer);
+  if (writer_status != 0) {
+    for (int i = 0; i < kNumReaders; i++) {
+      kill(readers[i], SIGKILL);
+      WaitChild(readers[i]);
+    }
+  }
+  ASSERT_EQ(0, writer_status);
+  for (int i = 0; i < kNumReaders; i++) {
+    ASSERT_EQ(0, WaitChild(readers[i]));
+  }
+  ASSERT_EQ(kNumKeys / 2 + 1, ShmHashTable_NumElements(table));
+
+  ShmHashTable_Close(table);
+  HW0Environment::AddPoints(10);
+}
+
+TEST_F(Test_ShmHashTable, DeadWriter) {
+  HW0Environment::OpenTestCase();
+  ShmHTKeyValue_t kv, oldkv;
+  ShmHashTable *table = ShmHashTable_Create(name_.c_str(), 7, 10);
+  ASSERT_NE(nullptr, table);
+  for (int i = 0; i < 5; i++) {
+    kv.key = i;
+    kv.value = i;
+    ASSERT_FALSE(ShmHashTable_Insert(table, kv, &oldkv));
+  }
+
+  // A writer that dies in the middle of a change, with the lock held, the
+  // sequence counter odd and the element count off.  Readers don't wait
+  // for it forever, and the table is put right.
+  for (bool reader_first : { true, false }) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      pthread_mutex_lock(&table->hdr->lock);
+      table->hdr->seq++;
+      table->hdr->num_elements += 3;
+      _exit(0);
+    }
+    ASSERT_EQ(0, WaitChild(pid));
+    ASSERT_EQ(1U, table->hdr->seq % 2);
+
+    if (reader_first) {
+      ASSERT_TRUE(ShmHashTable_Find(table, 3, &kv));
+      ASSERT_EQ(3U, kv.value);
+      ASSERT_EQ(0U, table->hdr->seq % 2);
+      ASSERT_EQ(5, ShmHashTable_NumElements(table));
+    }
+    kv.key = 3;
+    kv.value = 33;
+    ASSERT_TRUE(ShmHashTable_Insert(table, kv, &oldkv));
+    ASSERT_EQ(0U, table->hdr->seq % 2);
+    ASSERT_EQ(5, ShmHashTable_NumElements(table));
+    ASSERT_TRUE(ShmHashTable_Find(table, 3, &kv));
+    ASSERT_EQ(33U, kv.value);
+  }
+
+  ShmHashTable_Close(table);
+  HW0Environment::AddPoints(5);
+}
+
+TEST_F(Test_ShmHashTable, LookupThroughput) {
+  HW0Environment::OpenTestCase();
+  constexpr int kBenchKeys = 100000;
+  constexpr int kRounds = 10;
+  ShmHTKeyValue_t kv, oldkv;
+
+  ShmHashTable *table = ShmHashTable_Create(name_.c_str(),
+                                            kBenchKeys / 3, kBenchKeys);
+  ASSERT_NE(nullptr, table);
+  for (int i = 0; i < kBenchKeys; i++) {
+    kv.key = i;
+    kv.value = i;
+    ASSERT_FALSE(ShmHashTable_Insert(table, kv, &oldkv));
+  }
+
+  for (int num_procs = 1; num_procs <= 8; num_procs *= 2) {
+    pid_t pids[8];
+    uint64_t start = get_ns();
+    for (int i = 0; i < num_procs; i++) {
+      pids[i] = ForkChild(&LookupMain, name_.c_str(), kRounds);
+      ASSERT_LT(0, pids[i]);
+    }
+    for (int i = 0; i < num_procs; i++) {
+      ASSERT_EQ(0, WaitChild(pids[i]));
+    }
+    double secs = (get_ns() - start) / 1e9;
+    double lookups = static_cast<double>(num_procs) * kRounds * kBenchKeys;
+    std::cout << "ShmHashTable: " << num_procs << " process(es), "
+              << static_cast<uint64_t>(lookups / secs) << " lookups/s"
+              << std::endl;
+  }
+
+  ShmHashTable_Close(table);
+  HW0Environment::AddPoints(5);
+}
+
+}  // namespace hw0
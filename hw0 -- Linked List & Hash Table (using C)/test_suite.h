@@ -24,7 +24,7 @@ class HW0Environment : public ::testing::Environment {
   virtual void TearDown();
 
  private:
-  static constexpr int HW0_MAXPOINTS = 215;
+  static constexpr int HW0_MAXPOINTS = 290;
   static int total_points_;
   static int curr_test_points_;
 };
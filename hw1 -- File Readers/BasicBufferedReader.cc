@@ -0,0 +1,18 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./BasicBufferedReader.h"
+
+// The named readers are compiled here instead of in every file that uses
+// them.
+template class BasicBufferedReader<'\r', '\n', '\t', ' '>;
+template class BasicBufferedReader<',', '\r', '\n'>;
+template class BasicBufferedReader<'\n'>;
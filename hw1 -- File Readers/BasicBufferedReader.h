@@ -0,0 +1,135 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef BASICBUFFEREDREADER_H_
+#define BASICBUFFEREDREADER_H_
+
+#include <stdio.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./BufferedFileReader.h"
+#include "./DelimSet.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// A BasicBufferedReader is a BufferedFileReader whose delimiters are fixed
+// at compile time, as template arguments.
+//
+// It reads exactly like a BufferedFileReader constructed with the same
+// delimiters, but get_token() and get_line() search the buffer with a
+// StaticDelimSet, so the compiler knows which bytes it is looking for and
+// can build the search into the tokenizing loop. Everything else (refills,
+// readahead, seeking, stats) is BufferedFileReader's.
+//
+// get_token() and get_line() hide BufferedFileReader's, which aren't
+// virtual. Called through a BufferedFileReader& or *, they are
+// BufferedFileReader's: the same tokens, found with the delimiters'
+// DelimSet instead. In UTF-8 mode (see BufferedFileReader::set_utf8())
+// they are always BufferedFileReader's, since its Unicode delimiters
+// aren't in the template arguments.
+//
+// The delimiter sets most readers use have names below, and are compiled
+// once, in BasicBufferedReader.cc.
+///////////////////////////////////////////////////////////////////////////////
+template <char... Delims>
+class BasicBufferedReader : public BufferedFileReader {
+ public:
+  // Constructor for a BasicBufferedReader. Same as the BufferedFileReader
+  // constructor, with the delimiters taken from the template arguments.
+  explicit BasicBufferedReader(const string& fname, size_t buf_size=BUF_SIZE,
+                               bool adaptive=false, bool readahead=false,
+                               bool direct=false);
+
+  // Same as the BufferedFileReader functions of the same names.
+  string get_token();
+  string_view get_token_view();
+  string* get_line(int* len);
+  void get_line(vector<string>* tokens);
+  void get_line(vector<string_view>* tokens);
+
+ private:
+  // The bytes that end a token or a line, as in BufferedFileReader.
+  typedef StaticDelimSet<Delims..., static_cast<char>(EOF)> TokenStops;
+  typedef StaticDelimSet<'\n', static_cast<char>(EOF)> LineEnds;
+};
+
+template <char... Delims>
+BasicBufferedReader<Delims...>::BasicBufferedReader(const string& fname,
+                                                    size_t buf_size,
+                                                    bool adaptive,
+                                                    bool readahead,
+                                                    bool direct)
+  : BufferedFileReader(fname, string{Delims...}, buf_size, adaptive,
+                       readahead, direct) { }
+
+template <char... Delims>
+string BasicBufferedReader<Delims...>::get_token() {
+  if (using_utf8()) {
+    return BufferedFileReader::get_token();
+  }
+  return string(scan_token(TokenStops()));
+}
+
+template <char... Delims>
+string_view BasicBufferedReader<Delims...>::get_token_view() {
+  if (using_utf8()) {
+    return BufferedFileReader::get_token_view();
+  }
+  return scan_token(TokenStops());
+}
+
+template <char... Delims>
+string* BasicBufferedReader<Delims...>::get_line(int* len) {
+  if (using_utf8()) {
+    return BufferedFileReader::get_line(len);
+  }
+  return scan_line(TokenStops(), LineEnds(), len);
+}
+
+template <char... Delims>
+void BasicBufferedReader<Delims...>::get_line(vector<string>* tokens) {
+  if (using_utf8()) {
+    BufferedFileReader::get_line(tokens);
+    return;
+  }
+  scan_line(TokenStops(), LineEnds(), tokens);
+}
+
+template <char... Delims>
+void BasicBufferedReader<Delims...>::get_line(vector<string_view>* tokens) {
+  if (using_utf8()) {
+    BufferedFileReader::get_line(tokens);
+    return;
+  }
+  scan_line(TokenStops(), LineEnds(), tokens);
+}
+
+// BufferedFileReader's default delimiters.
+typedef BasicBufferedReader<'\r', '\n', '\t', ' '> WhitespaceReader;
+
+// Comma separated values, one record per line.
+typedef BasicBufferedReader<',', '\r', '\n'> CsvReader;
+
+// One token per line.
+typedef BasicBufferedReader<'\n'> NewlineReader;
+
+// Compiled in BasicBufferedReader.cc.
+extern template class BasicBufferedReader<'\r', '\n', '\t', ' '>;
+extern template class BasicBufferedReader<',', '\r', '\n'>;
+extern template class BasicBufferedReader<'\n'>;
+
+
+#endif  // BASICBUFFEREDREADER_H_
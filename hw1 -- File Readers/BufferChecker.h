@@ -22,11 +22,19 @@ class BufferChecker {
  public:
   BufferChecker(const BufferedFileReader& bf) : bf_(bf) { }
 
+  // Returns the file offset of the start of the buffer.
+  off_t buffer_offset() const { return bf_.buffer_offset_; }
+
   // Returns true if there is a detectable error
   // False if an error was not detected
   bool check_char_errors(char c, off_t file_offset) {
-    size_t index = file_offset % BufferedFileReader::BUF_SIZE;
-    if (index == BufferedFileReader::BUF_SIZE - 1) {
+    // A character that was just read must still be in the buffer.
+    if (file_offset < bf_.buffer_offset_ ||
+        file_offset >= bf_.buffer_offset_ + bf_.curr_length_) {
+      return true;
+    }
+    size_t index = file_offset - bf_.buffer_offset_;
+    if (index == bf_.capacity_ - 1) {
       // give some flexibility on how the last character is handled
       return false;
     }
@@ -37,17 +45,18 @@ class BufferChecker {
   // Returns true if there is a detectable error
   // False if an error was not detected
   bool check_token_errors(const string& token, off_t file_offset) {
-    size_t end_index = (file_offset + token.length()) % BufferedFileReader::BUF_SIZE;
-    size_t start_index = file_offset % BufferedFileReader::BUF_SIZE;
+    off_t end_offset = file_offset + token.length();
 
     // Check if we can even check if the token is in the buffer.
     // Can't be checked if token is clipped by buffer length, or token length is
     // greater than buffer length, and other edge cases
-    if (start_index > end_index || end_index - start_index != token.length()) {
+    if (file_offset < bf_.buffer_offset_ ||
+        end_offset > bf_.buffer_offset_ + bf_.curr_length_) {
       return false;
     }
 
-    for (off_t i = 0 ; start_index + i < end_index; i++) {
+    size_t start_index = file_offset - bf_.buffer_offset_;
+    for (size_t i = 0 ; i < token.length(); i++) {
       if (token[i] != bf_.buffer_[i + start_index]) {
         return true;
       }
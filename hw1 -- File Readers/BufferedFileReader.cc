@@ -14,32 +14,87 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+
+#include <algorithm>
+#include <charconv>
+#include <system_error>
+
 #include "BufferedFileReader.h"
 
-BufferedFileReader::BufferedFileReader(const string& fname, const string& delims) {
-    this->fd_ = open(fname.c_str(), O_RDONLY);
-    if (this->fd_ == -1) {
-        perror("open failed");
-        this->good_ = false;                  // no file open
-        exit(EXIT_FAILURE);
-    }
-    lseek(this->fd_, 0, SEEK_SET);      // read from the start of the file
-    this->good_ = true;
+constexpr size_t BufferedFileReader::BUF_SIZE;
+constexpr size_t BufferedFileReader::MAX_ADAPTIVE_BUF_SIZE;
+constexpr size_t BufferedFileReader::BUF_ALIGNMENT;
 
-    this->delims_ = delims;
+BufferedFileReader::BufferedFileReader(const string& fname, const string& delims,
+                                       size_t buf_size, bool adaptive,
+                                       bool readahead, bool direct) {
+    this->fd_ = -1;                     // no file open yet
+    this->good_ = false;
+    this->direct_ = direct;
+    this->o_direct_ = false;
+    this->utf8_ = false;
+    if (direct) {
+        // O_DIRECT reads go in whole, aligned blocks.
+        buf_size = (buf_size + BUF_ALIGNMENT - 1) / BUF_ALIGNMENT * BUF_ALIGNMENT;
+    }
+    set_delims(delims);
+    this->buffer_ = nullptr;
+    this->capacity_ = 0;
+    this->initial_capacity_ = buf_size;
+    this->adaptive_ = adaptive && !readahead;  // both buffers stay the
+                                                // same size
     this->curr_length_ = 0;
     this->curr_index_ = 0;
+    this->buffer_offset_ = 0;
+    this->eof_ = false;
     this->fill_num_ = 0;
-    fill_buffer();
+    this->stats_enabled_ = false;
+    this->stats_ = ReaderStats();
+    this->line_offset_ = 0;
+    this->line_number_ = 0;
+    resize_buffer(buf_size);
+
+    this->readahead_ = readahead;
+    this->ahead_buffer_ = nullptr;
+    this->ra_state_ = RA_IDLE;
+    this->ra_stop_ = false;
+    this->ra_fd_ = -1;
+    this->ra_offset_ = 0;
+    this->ra_length_ = 0;
+    this->ra_eof_ = false;
+    this->ra_syscalls_ = 0;
+    this->ra_eintr_ = 0;
+    if (readahead) {
+        void* buf;
+        if (posix_memalign(&buf, BUF_ALIGNMENT, buf_size) != 0) {
+            perror("posix_memalign failed");
+            exit(EXIT_FAILURE);
+        }
+        this->ahead_buffer_ = static_cast<char*>(buf);
+        this->ra_thread_ = std::thread(&BufferedFileReader::readahead_loop,
+                                       this);
+    }
+    open_file(fname);
 }
 
 BufferedFileReader::~BufferedFileReader() {
-    close(this->fd_);
-    this->fd_ = -1;                     // indicates no file open
-    this->good_ = false;                // no file open
-    this->curr_index_ = 0;
-    this->curr_length_ = 0;
+    close_file();
+    if (this->readahead_) {
+        {
+            std::lock_guard<std::mutex> lock(ra_mutex_);
+            ra_stop_ = true;
+        }
+        ra_cv_.notify_all();
+        ra_thread_.join();
+    }
+    free(this->buffer_);
+    free(this->ahead_buffer_);
+    this->buffer_ = nullptr;
+    this->ahead_buffer_ = nullptr;
 }
 
 void BufferedFileReader::open_file(const string& fname) {
@@ -47,95 +102,324 @@ void BufferedFileReader::open_file(const string& fname) {
     if (this->fd_ != -1) {
         close_file();
     }
-    this->fd_ = open(fname.c_str(), O_RDONLY);
+    this->o_direct_ = this->direct_;
+    this->fd_ = open(fname.c_str(), this->direct_ ? O_RDONLY | O_DIRECT : O_RDONLY);
+    if (this->fd_ == -1 && this->direct_ && errno == EINVAL) {
+        // The filesystem doesn't do O_DIRECT (tmpfs, for one).
+        this->o_direct_ = false;
+        this->fd_ = open(fname.c_str(), O_RDONLY);
+    }
     if (this->fd_ == -1) {
         perror("open failed");
         this->good_ = false;                  // no file open
         exit(EXIT_FAILURE);
     }
-    lseek(this->fd_, 0, SEEK_SET);      // read from the start of the file
+    utf8_validator_.reset();            // nothing has been checked yet
+    reset_buffer();                     // read from the start of the file
     this->good_ = true;
     fill_buffer();
 }
 
 void BufferedFileReader::close_file() {
-    close(this->fd_);
+    cancel_readahead();                 // it may be reading from fd_
+    if (this->fd_ != -1) {
+        close(this->fd_);
+    }
     this->fd_ = -1;                     // indicates no file open
+    this->o_direct_ = false;
     this->good_ = false;                // no file open
     this->fill_num_ = 0;
     this->curr_index_ = 0;
     this->curr_length_ = 0;
+    this->buffer_offset_ = 0;
+    this->eof_ = false;
 }
 
 char BufferedFileReader::get_char() {
-    char char_;
-
     // If there is no file open currently, then EOF is returned.
     if (this->fd_ == -1) {
         this->good_ = false;
         return EOF;
     }
 
-    if (curr_index_ != curr_length_) {      // hasn't arrived at the end of buffer
-        char_ = buffer_[curr_index_];
-        curr_index_++;
-    } else {
-        if (curr_length_ != BUF_SIZE) {
+    if (curr_index_ == curr_length_) {      // arrived at the end of buffer
+        if (eof_) {                         // and there is nothing after it
             this->good_ = false;        
             return EOF;
         }
         fill_buffer();
-        char_ = buffer_[curr_index_];
-        curr_index_++;
+        if (curr_length_ == 0) {            // the file ended on a buffer boundary
+            return EOF;
+        }
     }
 
-    return char_;
+    return buffer_[curr_index_++];
+}
+
+size_t BufferedFileReader::read_into(char* dst, size_t n) {
+    // If there is no file open currently, then nothing is read.
+    if (this->fd_ == -1) {
+        this->good_ = false;
+        return 0;
+    }
+
+    size_t total = 0;
+    while (total < n) {
+        if (curr_index_ == curr_length_) {  // arrived at the end of buffer
+            if (eof_) {                     // and there is nothing after it
+                this->good_ = false;
+                break;
+            }
+            // A buffer or more still to go: don't copy it through ours.
+            if (n - total >= capacity_ && !readahead_ && !o_direct_) {
+                total += read_direct(dst + total, n - total);
+                break;
+            }
+            fill_buffer();
+            if (curr_length_ == 0) {        // the file ended on a buffer boundary
+                break;
+            }
+        }
+        size_t len = std::min(n - total,
+                              static_cast<size_t>(curr_length_ - curr_index_));
+        memcpy(dst + total, buffer_ + curr_index_, len);
+        curr_index_ += len;
+        total += len;
+    }
+    return total;
 }
 
 string BufferedFileReader::get_token() {
-    string token = "";
-    while (true) {
-        char c = get_char();
-        if (is_delim(c) || c == -1) {
-            break;
+    if (utf8_) {
+        return string(scan_token(utf8_stops_));
+    }
+    return string(scan_token(token_stops_));
+}
+
+string_view BufferedFileReader::get_token_view() {
+    if (utf8_) {
+        return scan_token(utf8_stops_);
+    }
+    return scan_token(token_stops_);
+}
+
+string* BufferedFileReader::get_line(int* len) {
+    if (utf8_) {
+        return scan_line(utf8_stops_, line_ends_, len);
+    }
+    return scan_line(token_stops_, line_ends_, len);
+}
+
+void BufferedFileReader::get_line(vector<string>* tokens) {
+    if (utf8_) {
+        scan_line(utf8_stops_, line_ends_, tokens);
+        return;
+    }
+    scan_line(token_stops_, line_ends_, tokens);
+}
+
+void BufferedFileReader::get_line(vector<string_view>* tokens) {
+    if (utf8_) {
+        scan_line(utf8_stops_, line_ends_, tokens);
+        return;
+    }
+    scan_line(token_stops_, line_ends_, tokens);
+}
+
+// Returns how many bytes the delimiter that the stop byte read_until()
+// returned ends has, looking back at the token before it: 0 if it doesn't
+// end one after all.
+static int utf8_delim_length(const Utf8Delims& stops, string_view before,
+                             int stop) {
+    if (stop == EOF) {
+        return 1;                       // the end of the file
+    }
+    char tail[3];
+    size_t n = std::min(before.size(), static_cast<size_t>(2));
+    memcpy(tail, before.data() + before.size() - n, n);
+    tail[n] = static_cast<char>(stop);
+    return stops.delim_length(tail, tail + n);
+}
+
+string_view BufferedFileReader::scan_token(const Utf8Delims& token_stops) {
+    string_view token;
+    int stop = read_until(token_stops, &token);
+    int len = utf8_delim_length(token_stops, token, stop);
+
+    // The stop byte ended some other character, so it belongs to the
+    // token: carry on, putting the token together in utf8_token_.
+    if (len == 0) {
+        utf8_token_.assign(token.data(), token.size());
+        while (len == 0) {
+            utf8_token_.push_back(static_cast<char>(stop));
+            stop = read_until(token_stops, &token);
+            utf8_token_.append(token.data(), token.size());
+            len = utf8_delim_length(token_stops, utf8_token_, stop);
         }
-        token += c;
+        token = utf8_token_;
+    }
+    token.remove_suffix(len - 1);       // the delimiter's other bytes
+    if (stats_enabled_) {
+        stats_.tokens++;
     }
     return token;
 }
 
-string* BufferedFileReader::get_line(int* len) {
-    string* line = new string[50];
-    *len = 0;
-    
-    string token = "";
-    while (true) {
-        char c = get_char();
-        if (c == '\n' || c == -1) {
-            line[*len] = token;
-            token = "";
-            *len += 1;
+void BufferedFileReader::set_utf8(bool enable) {
+    bool was_utf8 = utf8_;
+    utf8_ = enable;
+    if (enable && !was_utf8 && this->fd_ != -1) {
+        // Check what is already buffered and not yet read.
+        utf8_validator_.feed(buffer_ + curr_index_, curr_length_ - curr_index_,
+                             buffer_offset_ + curr_index_);
+        if (eof_) {
+            utf8_validator_.finish();
+        }
+    }
+}
+
+// Parses all of token as a T, with std::from_chars(): exact, locale
+// independent, and with no copying or allocation.
+template <class T>
+static BufferedFileReader::ParseStatus parse_number(string_view token,
+                                                    T* value) {
+    const char* begin = token.data();
+    const char* end = begin + token.size();
+
+    // from_chars() takes a '-', but not a '+'.
+    if (begin != end && *begin == '+' && end - begin > 1 && begin[1] != '-') {
+        begin++;
+    }
+    T result;
+    std::from_chars_result parsed = std::from_chars(begin, end, result);
+    if (parsed.ec == std::errc::invalid_argument || parsed.ptr != end) {
+        return BufferedFileReader::PARSE_MALFORMED;
+    }
+    if (parsed.ec == std::errc::result_out_of_range) {
+        return BufferedFileReader::PARSE_OUT_OF_RANGE;
+    }
+    *value = result;
+    return BufferedFileReader::PARSE_OK;
+}
+
+BufferedFileReader::ParseStatus BufferedFileReader::get_double(double* value) {
+    string_view token;
+    if (!next_number_token(&token)) {
+        return PARSE_EOF;
+    }
+    return parse_number(token, value);
+}
+
+BufferedFileReader::ParseStatus BufferedFileReader::get_int64(int64_t* value) {
+    string_view token;
+    if (!next_number_token(&token)) {
+        return PARSE_EOF;
+    }
+    return parse_number(token, value);
+}
+
+size_t BufferedFileReader::parse_doubles(double* values, size_t len,
+                                         ParseStatus* status) {
+    ParseStatus result = PARSE_OK;
+    size_t count = 0;
+    string_view token;
+
+    while (count < len) {
+        if (!next_number_token(&token)) {
+            result = PARSE_EOF;
             break;
-        } else if (is_delim(c)) {       // add token to the heap
-            line[*len] = token;
-            token = "";
-            *len += 1;
-            continue;
         }
-        token += c;
+        result = parse_number(token, &values[count]);
+        if (result != PARSE_OK) {
+            break;
+        }
+        count++;
+    }
+    if (status != nullptr) {
+        *status = result;
+    }
+    return count;
+}
+
+bool BufferedFileReader::find_next(const string& pattern,
+                                   bool case_insensitive, SearchMatch* match) {
+    SubstringFinder finder(pattern, case_insensitive);
+    size_t carry_len = finder.size() - 1;
+
+    if (this->fd_ == -1 || finder.size() == 0) {
+        this->good_ = false;
+        return false;
     }
+    count_lines_to(buffer_offset_ + curr_index_);
+
+    // scratch_ holds the last carry_len bytes searched, from carry_offset:
+    // a match may start in them and end in the next buffer.
+    scratch_.clear();
+    off_t carry_offset = 0;
+    const char* hit;
+    while (true) {
+        const char* begin = buffer_ + curr_index_;
+        const char* end = buffer_ + curr_length_;
 
-    string* token_line = new string[*len + 1];
-    for (int i = 0; i < *len; i++) {
-        token_line[i] = line[i];
+        // Look for a match that starts in the carried bytes, in them and
+        // the first few of the buffer. Any match that starts further on
+        // is wholly in the buffer, and found below.
+        if (!scratch_.empty()) {
+            size_t carried = scratch_.size();
+            scratch_.append(begin, std::min(carry_len,
+                                            static_cast<size_t>(end - begin)));
+            hit = finder.find(scratch_.data(), scratch_.data() + scratch_.size());
+            if (hit < scratch_.data() + carried) {
+                // line_number_ already counts the '\n's after the match.
+                match->offset = carry_offset + (hit - scratch_.data());
+                match->line = line_number_ - SubstringFinder::count_newlines(
+                                  hit, scratch_.data() + carried);
+                break;
+            }
+            scratch_.resize(carried);
+        }
+
+        hit = finder.find(begin, end);
+        if (hit != end) {
+            match->offset = buffer_offset_ + (hit - buffer_);
+            match->line = line_number_ +
+                          SubstringFinder::count_newlines(begin, hit);
+            break;
+        }
+
+        // Nothing here: carry the end of the buffer over, and go on to
+        // the next one.
+        line_number_ += SubstringFinder::count_newlines(begin, end);
+        line_offset_ = buffer_offset_ + curr_length_;
+        if (static_cast<size_t>(end - begin) >= carry_len) {
+            scratch_.assign(end - carry_len, carry_len);
+        } else {
+            scratch_.append(begin, end - begin);
+            if (scratch_.size() > carry_len) {
+                scratch_.erase(0, scratch_.size() - carry_len);
+            }
+        }
+        carry_offset = line_offset_ - scratch_.size();
+        curr_index_ = curr_length_;
+        if (eof_) {
+            this->good_ = false;
+            return false;
+        }
+        fill_buffer();
+        if (curr_length_ == 0) {
+            return false;
+        }
     }
 
-    delete[] line;
-    return token_line;
+    // Carry on from just past the match, which always ends in the buffer.
+    line_offset_ = match->offset;
+    line_number_ = match->line;
+    curr_index_ = match->offset + finder.size() - buffer_offset_;
+    return true;
 }
 
-int BufferedFileReader::tell() {
-    return (fill_num_ - 1) * BUF_SIZE + curr_index_;
+off_t BufferedFileReader::tell() {
+    return buffer_offset_ + curr_index_;
 }
 
 void BufferedFileReader::rewind() {
@@ -144,10 +428,55 @@ void BufferedFileReader::rewind() {
         this->good_=false;
         exit(EXIT_FAILURE);
       }   
-    lseek(fd_, 0, SEEK_SET);   //reset to index 0 of file 
+    reset_buffer();            //reset to index 0 of file 
     this->good_ = true;
+    fill_buffer();
+}
+
+void BufferedFileReader::seek(off_t offset) {
+    // If there is no file open currently, then exit
+    if (this->fd_ == -1) {
+        this->good_ = false;
+        exit(EXIT_FAILURE);
+    }
+
+    // Already buffered: just move the index. The end of the buffer counts
+    // too, since that's where the reader is after reading the last byte.
+    if (offset >= buffer_offset_ && offset <= buffer_offset_ + curr_length_ &&
+        curr_length_ > 0) {
+        curr_index_ = offset - buffer_offset_;
+        this->good_ = true;
+        return;
+    }
+
+    // Otherwise start reading from the new offset. This isn't a sequential
+    // read, so an adaptive buffer doesn't grow on the next fill. With
+    // O_DIRECT, the read has to start at the aligned offset before it.
+    off_t start = o_direct_ ? offset - offset % BUF_ALIGNMENT : offset;
+    cancel_readahead();                 // it's reading the wrong part
+    if (lseek(this->fd_, start, SEEK_SET) == -1) {
+        perror("lseek failed");
+        exit(EXIT_FAILURE);
+    }
+    buffer_offset_ = start;
+    curr_length_ = 0;
+    curr_index_ = 0;
+    eof_ = false;
     fill_num_ = 0;
     fill_buffer();
+    if (start == offset) {
+        return;
+    }
+
+    if (eof_ && offset - start >= curr_length_) {
+        // The offset is at or past the end of the file: leave the reader
+        // there, at EOF, as if it had read up to it.
+        buffer_offset_ = offset;
+        curr_length_ = 0;
+        this->good_ = false;
+    } else {
+        curr_index_ = offset - start;
+    }
 }
 
 bool BufferedFileReader::good() {
@@ -155,7 +484,6 @@ bool BufferedFileReader::good() {
 }
 
 void BufferedFileReader::fill_buffer() {
-    curr_length_ = 0;
     int result;
 
     // If there is no file open currently, then return directly
@@ -164,45 +492,360 @@ void BufferedFileReader::fill_buffer() {
         exit(EXIT_FAILURE);
     }
 
-    char* ptr = buffer_;
-    while (ptr < buffer_ + BUF_SIZE) {
-        result = read(this->fd_, ptr, buffer_ + BUF_SIZE - ptr);
+    // Everything in the buffer has been read, so it now starts where the
+    // old contents ended.
+    buffer_offset_ += curr_length_;
+    curr_length_ = 0;
+    curr_index_ = 0;
+
+    // We drained a whole buffer and came back for more, so the reads are
+    // sequential: an adaptive buffer grows to make the next read() count.
+    // Nothing in the old buffer is needed any more, so no copying.
+    if (adaptive_ && fill_num_ > 0 && capacity_ < MAX_ADAPTIVE_BUF_SIZE) {
+        resize_buffer(std::min(capacity_ * 2, MAX_ADAPTIVE_BUF_SIZE));
+    }
+
+    uint64_t start_ns = stats_enabled_ ? ReaderStats::now_ns() : 0;
+    if (readahead_) {
+        fill_from_readahead();
+    } else {
+        char* ptr = buffer_;
+        int syscalls = 0, eintr = 0;
+        while (ptr < buffer_ + capacity_) {
+            result = read(this->fd_, ptr, buffer_ + capacity_ - ptr);
+            syscalls++;
+            if (result == -1) {
+                if (errno != EINTR) {
+                    perror("read failed");
+                    this->good_ = false;
+                    exit(EXIT_FAILURE);
+                }
+                eintr++;
+                continue;       // EINTR happened, so do nothing and try again
+            } else if (result == 0) {
+                this->eof_ = true;          // a short fill means we hit the end of the file
+                break;
+            }
+            ptr += result;
+            curr_length_ += result;
+            if (o_direct_ && result % BUF_ALIGNMENT != 0) {
+                // Only the last block of the file comes back short, and
+                // reading on from the unaligned offset after it would fail.
+                this->eof_ = true;
+                break;
+            }
+        }
+        if (stats_enabled_) {
+            stats_.read_syscalls += syscalls;
+            stats_.eintr_retries += eintr;
+            stats_.bytes_read += curr_length_;
+        }
+    }
+    if (stats_enabled_) {
+        stats_.add_fill(ReaderStats::now_ns() - start_ns);
+    }
+
+    // Asked to bypass the page cache, but couldn't: drop what we just read
+    // from it instead.
+    if (direct_ && !o_direct_ && curr_length_ > 0) {
+        posix_fadvise(this->fd_, buffer_offset_, curr_length_,
+                      POSIX_FADV_DONTNEED);
+    }
+
+    if (utf8_) {
+        utf8_validator_.feed(buffer_, curr_length_, buffer_offset_);
+        if (eof_ || curr_length_ == 0) {
+            utf8_validator_.finish();
+        }
+    }
+
+    if (curr_length_ == 0) {        // nothing read into the buffer, at the end of the file
+        this->good_ = false;
+        return;
+    }
+
+    this->good_ = true;
+    fill_num_++;
+    return;
+}
+
+size_t BufferedFileReader::read_direct(char* dst, size_t n) {
+    int result;
+
+    // Called with the buffer drained. The bytes go around it, so afterwards
+    // it's empty, and starts just past them.
+    buffer_offset_ += curr_length_;
+    curr_length_ = 0;
+    curr_index_ = 0;
+
+    uint64_t start_ns = stats_enabled_ ? ReaderStats::now_ns() : 0;
+    char* ptr = dst;
+    int syscalls = 0, eintr = 0;
+    while (ptr < dst + n) {
+        result = read(this->fd_, ptr, dst + n - ptr);
+        syscalls++;
         if (result == -1) {
             if (errno != EINTR) {
                 perror("read failed");
                 this->good_ = false;
                 exit(EXIT_FAILURE);
             }
+            eintr++;
             continue;       // EINTR happened, so do nothing and try again
         } else if (result == 0) {
-            this->good_ = false;        // If at the end of the file, good_ is false.
+            this->eof_ = true;
             break;
         }
-        this->good_ = true;
         ptr += result;
-        curr_length_ += result;
     }
-    curr_index_ = 0;
+    size_t len = ptr - dst;
+    if (stats_enabled_) {
+        stats_.read_syscalls += syscalls;
+        stats_.eintr_retries += eintr;
+        stats_.bytes_read += len;
+        stats_.add_fill(ReaderStats::now_ns() - start_ns);
+    }
 
-    if (curr_length_ != BUF_SIZE) {
-        buffer_[curr_length_] = -1;           // mark for end of buffer read
+    if (direct_ && !o_direct_ && len > 0) {
+        posix_fadvise(this->fd_, buffer_offset_, len, POSIX_FADV_DONTNEED);
     }
-    if (curr_length_ == 0) {        // nothing read into the buffer, at the end of the file
+    if (utf8_) {
+        utf8_validator_.feed(dst, len, buffer_offset_);
+        if (eof_) {
+            utf8_validator_.finish();
+        }
+    }
+
+    buffer_offset_ += len;
+    if (eof_) {
         this->good_ = false;
+    }
+    return len;
+}
+
+void BufferedFileReader::resize_buffer(size_t capacity) {
+    void* buf;
+
+    // Page-aligned, so the kernel can copy into whole pages.
+    free(this->buffer_);
+    if (posix_memalign(&buf, BUF_ALIGNMENT, capacity) != 0) {
+        perror("posix_memalign failed");
+        exit(EXIT_FAILURE);
+    }
+    this->buffer_ = static_cast<char*>(buf);
+    this->capacity_ = capacity;
+}
+
+void BufferedFileReader::reset_buffer() {
+    cancel_readahead();                 // it's reading the wrong part
+    lseek(this->fd_, 0, SEEK_SET);      // read from the start of the file
+    this->buffer_offset_ = 0;
+    this->line_offset_ = 0;
+    this->line_number_ = 0;
+    this->curr_length_ = 0;
+    this->curr_index_ = 0;
+    this->eof_ = false;
+    this->fill_num_ = 0;
+    if (this->adaptive_ && this->capacity_ != this->initial_capacity_) {
+        resize_buffer(this->initial_capacity_);
+    }
+}
+
+void BufferedFileReader::fill_from_readahead() {
+    std::unique_lock<std::mutex> lock(ra_mutex_);
+
+    // Nothing is in flight on the first fill after opening or rewinding.
+    if (ra_state_ == RA_IDLE) {
+        request_readahead(buffer_offset_);
+    }
+    ra_cv_.wait(lock, [this] { return ra_state_ == RA_READY; });
+
+    // The thread always reads the bytes right after the old buffer, which
+    // is exactly where this one starts.
+    std::swap(buffer_, ahead_buffer_);
+    curr_length_ = ra_length_;
+    eof_ = ra_eof_;
+    count_readahead();
+    ra_state_ = RA_IDLE;
+
+    // Start on the next buffer while the caller reads this one.
+    if (!eof_) {
+        request_readahead(buffer_offset_ + curr_length_);
+    }
+}
+
+void BufferedFileReader::request_readahead(off_t offset) {
+    // Called with ra_mutex_ held.
+    ra_fd_ = fd_;
+    ra_offset_ = offset;
+    ra_state_ = RA_REQUESTED;
+    ra_cv_.notify_all();
+}
+
+void BufferedFileReader::cancel_readahead() {
+    if (!readahead_) {
         return;
     }
 
-    this->good_ = true;
-    fill_num_++;
-    return;
+    // A read can't be interrupted, so wait for it to finish and then
+    // throw it away.
+    std::unique_lock<std::mutex> lock(ra_mutex_);
+    ra_cv_.wait(lock, [this] { return ra_state_ != RA_REQUESTED; });
+    if (ra_state_ == RA_READY) {
+        count_readahead();
+    }
+    ra_state_ = RA_IDLE;
 }
 
-bool BufferedFileReader::is_delim(char c) {
-    std::size_t found = delims_.find(c);        // found is the position of the first character of the first match
-    if (found != std::string::npos) {             // there is a match
-        return true;
-    } else {
-        return false;
+void BufferedFileReader::count_readahead() {
+    // Called with ra_mutex_ held, and a finished read in ahead_buffer_.
+    if (stats_enabled_) {
+        stats_.read_syscalls += ra_syscalls_;
+        stats_.eintr_retries += ra_eintr_;
+        stats_.bytes_read += ra_length_;
+    }
+}
+
+void BufferedFileReader::readahead_loop() {
+    std::unique_lock<std::mutex> lock(ra_mutex_);
+    while (true) {
+        ra_cv_.wait(lock, [this] {
+            return ra_state_ == RA_REQUESTED || ra_stop_;
+        });
+        if (ra_stop_) {
+            return;
+        }
+
+        // ahead_buffer_ and the request don't change until we say we're
+        // done, so read without holding the lock.
+        int fd = ra_fd_;
+        off_t offset = ra_offset_;
+        char* buf = ahead_buffer_;
+        bool o_direct = o_direct_;
+        size_t length = 0;
+        bool eof = false;
+        int syscalls = 0, eintr = 0;
+        lock.unlock();
+
+        // pread() rather than read(), so the file position doesn't matter.
+        while (length < capacity_) {
+            ssize_t result = pread(fd, buf + length, capacity_ - length,
+                                   offset + length);
+            syscalls++;
+            if (result == -1) {
+                if (errno != EINTR) {
+                    perror("pread failed");
+                    exit(EXIT_FAILURE);
+                }
+                eintr++;
+                continue;       // EINTR happened, so do nothing and try again
+            } else if (result == 0) {
+                eof = true;
+                break;
+            }
+            length += result;
+            if (o_direct && result % BUF_ALIGNMENT != 0) {
+                eof = true;             // the unaligned tail of the file
+                break;
+            }
+        }
+
+        lock.lock();
+        ra_length_ = length;
+        ra_eof_ = eof;
+        ra_syscalls_ = syscalls;
+        ra_eintr_ = eintr;
+        ra_state_ = RA_READY;
+        ra_cv_.notify_all();
+    }
+}
+
+bool BufferedFileReader::next_number_token(string_view* token) {
+    // Skip the empty tokens between delimiters, until a real one or EOF.
+    do {
+        if (!this->good_) {
+            return false;
+        }
+        *token = scan_token(token_stops_);
+    } while (token->empty());
+    return true;
+}
+
+void BufferedFileReader::count_lines_to(off_t offset) {
+    // Counting only goes forward: after a seek back, start over.
+    if (offset < line_offset_) {
+        line_offset_ = 0;
+        line_number_ = 0;
+    }
+
+    // The part before the buffer has to be read again.
+    if (line_offset_ < buffer_offset_) {
+        off_t to = std::min(offset, buffer_offset_);
+        line_number_ += count_file_newlines(line_offset_, to);
+        line_offset_ = to;
+    }
+    if (line_offset_ < offset) {
+        line_number_ += SubstringFinder::count_newlines(
+                            buffer_ + (line_offset_ - buffer_offset_),
+                            buffer_ + (offset - buffer_offset_));
+        line_offset_ = offset;
+    }
+}
+
+uint64_t BufferedFileReader::count_file_newlines(off_t from, off_t to) {
+    const size_t kChunkSize = 64 << 10;
+    void* buf;
+    uint64_t count = 0;
+
+    // pread() leaves the file offset (and so the buffer) alone. Reads
+    // start on a BUF_ALIGNMENT boundary, as O_DIRECT needs.
+    if (posix_memalign(&buf, BUF_ALIGNMENT, kChunkSize) != 0) {
+        perror("posix_memalign failed");
+        exit(EXIT_FAILURE);
+    }
+    const char* chunk = static_cast<const char*>(buf);
+    off_t offset = from - from % BUF_ALIGNMENT;
+    while (offset < to) {
+        ssize_t result = pread(this->fd_, buf, kChunkSize, offset);
+        if (stats_enabled_) {
+            stats_.read_syscalls++;
+        }
+        if (result == -1) {
+            if (errno != EINTR) {
+                perror("pread failed");
+                exit(EXIT_FAILURE);
+            }
+            if (stats_enabled_) {
+                stats_.eintr_retries++;
+            }
+            continue;       // EINTR happened, so do nothing and try again
+        } else if (result == 0) {
+            break;
+        }
+        if (stats_enabled_) {
+            stats_.bytes_read += result;
+        }
+        count += SubstringFinder::count_newlines(
+                     chunk + std::max(from - offset, off_t(0)),
+                     chunk + std::min(static_cast<off_t>(result), to - offset));
+        offset += result;
+        if (o_direct_ && result % BUF_ALIGNMENT != 0) {
+            break;                      // the unaligned end of the file
+        }
     }
+    free(buf);
+    return count;
 }
 
+void BufferedFileReader::set_delims(const string& delims) {
+    delims_ = delims;
+    token_stops_ = DelimSet(delims);
+    token_stops_.add(EOF);
+    utf8_stops_ = Utf8Delims(delims);
+    line_ends_ = DelimSet("\n");
+    line_ends_.add(EOF);
+}
+
+bool BufferedFileReader::is_delim(char c) {
+    return token_stops_.contains(c) && c != EOF;
+}
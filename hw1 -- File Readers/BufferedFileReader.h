@@ -12,9 +12,25 @@
 #ifndef BUFFEREDFILEREADER_H_
 #define BUFFEREDFILEREADER_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "./DelimSet.h"
+#include "./ReaderStats.h"
+#include "./SubstringFinder.h"
+#include "./TokenScanner.h"
+#include "./Utf8.h"
 
 using std::string;
+using std::string_view;
+using std::vector;
 
 ///////////////////////////////////////////////////////////////////////////////
 // A BufferedFileReader is a class for reading files.
@@ -25,6 +41,13 @@ using std::string;
 ///////////////////////////////////////////////////////////////////////////////
 class BufferedFileReader {
  public:
+  // Constants
+  static constexpr size_t BUF_SIZE = 1024;  // the default buffer size.
+  static constexpr size_t MAX_ADAPTIVE_BUF_SIZE = 4 << 20;  // the most an
+                                                            // adaptive buffer
+                                                            // grows to.
+  static constexpr size_t BUF_ALIGNMENT = 4096;  // the buffer's alignment.
+
   // Constructor for a BufferedFileReader. Should open the
   // file and do whatever is necesary to "set-up" the object.
   // After construction, reading from the file should start
@@ -37,12 +60,34 @@ class BufferedFileReader {
   //   be used as delimiters for reading tokens.
   //   NOTE: delims is an optional arguement and is by default
   //   set to white space characters
+  // - buf_size: how many bytes to read from the file at a time.
+  //   Bigger buffers mean fewer read() calls on large files; smaller
+  //   ones waste less memory (and time) on small files. Must be > 0.
+  // - adaptive: if true, buf_size is only the starting size. Each time
+  //   the buffer is drained and refilled, its size doubles, up to
+  //   MAX_ADAPTIVE_BUF_SIZE. Small files never grow the buffer, and large
+  //   ones quickly reach a size that makes read() calls rare. The size
+  //   resets on rewind() and open_file(). Ignored with readahead.
+  // - readahead: if true, a background thread reads the next buffer's
+  //   worth of the file into a second buffer while this one is being
+  //   read, and the two are swapped when this one runs out, so reading
+  //   the file and parsing it overlap. Worth it when the file isn't
+  //   already in the page cache.
+  // - direct: if true, the file is opened with O_DIRECT, so reads go
+  //   straight from the disk into the buffer, and a scan of a big file
+  //   doesn't push everything else out of the page cache. buf_size is
+  //   rounded up to a multiple of BUF_ALIGNMENT, since O_DIRECT reads
+  //   must be aligned. On filesystems without O_DIRECT, the file is read
+  //   normally, and each buffer's pages are dropped from the page cache
+  //   once they're read (see using_direct_io()).
   // 
   //   BufferedFileReader does NOT take ownership of either string.
   //   In other words, it is the caller's responsibility to allocate
   //   and free them. The BufferedFileReader maintains copies
   //   of the strings needed for it's functionality.
-  BufferedFileReader(const string& fname, const string& delims="\r\n\t ");
+  BufferedFileReader(const string& fname, const string& delims="\r\n\t ",
+                     size_t buf_size=BUF_SIZE, bool adaptive=false,
+                     bool readahead=false, bool direct=false);
 
   // Destructor for a BufferedFileReader. Should clean up
   // any allocated resources such as memory or open files.
@@ -76,6 +121,22 @@ class BufferedFileReader {
   //   or if there is no file open currently, then EOF is returned.
   char get_char();
 
+  // Reads the next n bytes of the file into dst, or as many as are left.
+  // Whatever is buffered is copied out first; if at least a whole buffer's
+  // worth is still wanted after that, the rest is read straight into dst,
+  // skipping the buffer. (Not with readahead or O_DIRECT, which need
+  // their own buffers, so those copy a buffer at a time.) In UTF-8 mode,
+  // the bytes are checked as usual.
+  //
+  // Arguments:
+  // - dst: where to put the bytes. Must have room for n of them.
+  // - n: how many bytes to read
+  //
+  // Returns:
+  // - how many bytes were read into dst, which is less than n only at the
+  //   end of the file. 0 if there is no file open currently.
+  size_t read_into(char* dst, size_t n);
+
 
   // The next two functions deal with the reading of "tokens".
   // A token is a sequence of characters whose end is marked by a delimiter
@@ -112,6 +173,22 @@ class BufferedFileReader {
   // - the next token in the file, or the empty string if alrady at EOF.
   string get_token();
 
+  // Same as get_token(), but instead of copying the token into a new
+  // string, returns a view of it in the reader's buffer.
+  //
+  // The view is only valid until the next call that reads from, rewinds,
+  // opens or closes the file. A token that runs across a refill of the
+  // buffer is stitched together in a scratch string that is reused from
+  // token to token, so once that has grown to fit the longest token,
+  // reading tokens allocates nothing.
+  //
+  // Arguments: None
+  //
+  // Returns:
+  // - a view of the next token in the file, or an empty view if already
+  //   at EOF.
+  string_view get_token_view();
+
   // Reads tokens until a new line is encountered and returns
   // those tokens in an array.
   // If we are already at the EOF, then return nullptr.
@@ -144,6 +221,93 @@ class BufferedFileReader {
   // - the length of the array, returned through parameter `len`.
   string* get_line(int* len);
 
+  // Same as get_line(int*), but puts the tokens in a vector the caller
+  // owns instead of a new array, replacing whatever was in it. There is
+  // no limit on how many tokens a line can have.
+  //
+  // Reusing the same vector from line to line reuses its capacity, and
+  // the storage of the strings already in it.
+  //
+  // Arguments:
+  // - tokens: the vector to put the line's tokens in.
+  void get_line(vector<string>* tokens);
+
+  // Same as get_line(vector<string>*), but the tokens are views into the
+  // reader's buffer, like get_token_view(), and are only valid until the
+  // next call that reads from, rewinds, opens or closes the file.
+  // Once the vector and the reader's scratch space have grown to fit the
+  // longest line, reading lines allocates nothing.
+  //
+  // Arguments:
+  // - tokens: the vector to put views of the line's tokens in.
+  void get_line(vector<string_view>* tokens);
+
+  // What the number readers below found.
+  enum ParseStatus {
+    PARSE_OK,            // a number was read
+    PARSE_EOF,           // there were no more tokens to read
+    PARSE_MALFORMED,     // the token wasn't a number, or had more after one
+    PARSE_OUT_OF_RANGE,  // the token was a number too big (or, for a
+                         // double, too small) for the type
+  };
+
+  // Reads the next token from the file as a number, the way strtod() (or
+  // strtoll()) would, but exactly and without copying the token out of
+  // the buffer or allocating anything. A leading '+' is allowed.
+  // Empty tokens, like the one between "\r" and "\n", are skipped, so
+  // numbers can be separated by any run of delimiters.
+  //
+  // A token that isn't a number is still read, so the next call reads
+  // the token after it. Where it was can be found by calling tell()
+  // before the read.
+  // Undefined behaviour if there is no file open currently.
+  //
+  // Arguments:
+  // - value: where to put the number. Left alone unless PARSE_OK is
+  //   returned.
+  //
+  // Returns:
+  // - PARSE_OK, or what went wrong (see ParseStatus).
+  ParseStatus get_double(double* value);
+  ParseStatus get_int64(int64_t* value);
+
+  // Reads up to len numbers into values with get_double(), stopping at the
+  // first token that isn't one, or at the end of the file.
+  //
+  // Arguments:
+  // - values: where to put the numbers
+  // - len: the most numbers to read
+  // - status: if not nullptr, returns PARSE_OK if len numbers were read,
+  //   and otherwise why reading stopped.
+  //
+  // Returns:
+  // - how many numbers were read into values.
+  size_t parse_doubles(double* values, size_t len,
+                       ParseStatus* status=nullptr);
+
+  // Searches the rest of the file for the next occurrence of pattern, and
+  // moves to just past it, so calling find_next() again finds the next
+  // one that doesn't overlap it. Matches that run across a refill of the
+  // buffer are found too. Searching is done a buffer at a time with a
+  // SubstringFinder, not a character at a time.
+  //
+  // Line numbers are counted as the search goes. After a seek() the lines
+  // before the new offset are counted first, which may mean reading them
+  // again (but not through the buffer).
+  // If there is no match, the reader is left at EOF.
+  // Undefined behaviour if there is no file open currently.
+  //
+  // Arguments:
+  // - pattern: what to look for. Must not be empty.
+  // - case_insensitive: whether ASCII letters match either case
+  // - match: returns where the match starts, and on which line
+  //
+  // Returns:
+  // - true if there was a match, false if the end of the file was reached
+  //   without one.
+  bool find_next(const string& pattern, bool case_insensitive,
+                 SearchMatch* match);
+
   // Returns the current position the user is in to the file.
   // Undefined behaviour if there is no file open currently.
   //
@@ -153,8 +317,21 @@ class BufferedFileReader {
   // - The current position we are in the file, which is the
   //   Offset from the start of the file. (e.g, if the user is at
   //   the start of the file, returns 0. If the user has read 2
-  //   characters, return 2. etc.).
-  int tell();
+  //   characters, return 2. etc.). An off_t, so positions past 2 GiB
+  //   are exact.
+  off_t tell();
+
+  // Moves to the given offset in the file, so the next read starts there.
+  // If that part of the file is already in the buffer, the buffer is
+  // reused and nothing is read. Otherwise the buffer is refilled from
+  // the new offset.
+  // Seeking to or past the end of the file leaves the reader at EOF.
+  // Undefined behaviour if there is no file open currently.
+  //
+  // Arguments:
+  // - offset: the offset from the start of the file to move to. Must
+  //   be >= 0.
+  void seek(off_t offset);
 
   // Resets the file to start reading from the beginning
   // of the file that is currently open.
@@ -177,6 +354,55 @@ class BufferedFileReader {
   // - true otherwise
   bool good();
 
+  // Returns whether the file is open with O_DIRECT. False if direct
+  // wasn't asked for, or the file's filesystem doesn't support it.
+  bool using_direct_io() const { return o_direct_; }
+
+  // Turns UTF-8 mode on or off. It starts off. In UTF-8 mode:
+  // - get_token(), get_token_view() and get_line() also split tokens at
+  //   the Unicode white space characters that take more than one byte
+  //   (U+0085, U+00A0, U+1680, U+2000 to U+200A, U+2028, U+2029, U+202F,
+  //   U+205F and U+3000), as well as at the delimiters. ASCII text is
+  //   scanned as fast as without UTF-8 mode.
+  // - every byte read into the buffer, from the current position on, is
+  //   checked to be valid UTF-8, and the file offset of each invalid
+  //   sequence is kept, for utf8_errors(). A Utf8Validator does the
+  //   checking.
+  // Everything else reads bytes, as before.
+  //
+  // Arguments:
+  // - enable: whether or not to use UTF-8 mode
+  void set_utf8(bool enable=true);
+
+  // Returns whether the reader is in UTF-8 mode.
+  bool using_utf8() const { return utf8_; }
+
+  // Returns the file offsets of the invalid UTF-8 sequences read in UTF-8
+  // mode since the file was opened, in increasing order. A sequence cut
+  // off by the end of the file counts once the end has been read. Bytes
+  // read again after a rewind() or seek() aren't reported twice.
+  const vector<off_t>& utf8_errors() const {
+    return utf8_validator_.errors();
+  }
+
+  // Turns counting ReaderStats on or off. They start off. While on, each
+  // refill is also timed, which costs two reads of the clock per refill.
+  //
+  // Arguments:
+  // - enable: whether or not to count
+  void enable_stats(bool enable=true) { stats_enabled_ = enable; }
+
+  // Returns what has been counted since the reader was constructed or
+  // reset_stats() was last called. Opening, rewinding, seeking and closing
+  // don't reset the stats. With readahead, the background thread's reads
+  // are counted when their buffer is handed over (or thrown away).
+  // The constructor fills the buffer before stats can be turned on, so
+  // to count that first refill, call enable_stats() and then open_file().
+  const ReaderStats& stats() const { return stats_; }
+
+  // Zeroes the stats.
+  void reset_stats() { stats_ = ReaderStats(); }
+
   // Ignore These
   // If you want to know more, this is disabling the
   // copy constructor and the assignment operator.
@@ -187,32 +413,198 @@ class BufferedFileReader {
   // Ignore this
   // This is necessary for testing and will be talked about later in the course
   friend class BufferChecker;
+  friend class TokenScanner;
 
- private:
-  // Constants
-  static constexpr uint64_t BUF_SIZE = 1024;  // the size of the buffer.
+ protected:
+  // The token and line readers behind get_token() and get_line(), for any
+  // kind of stop set: the DelimSets above, or the StaticDelimSets of a
+  // BasicBufferedReader. token_stops and line_ends must hold the same
+  // bytes as token_stops_ and line_ends_.
+  template <class Stops>
+  int read_until(const Stops& stops, string_view* token);
+  template <class Stops>
+  string_view scan_token(const Stops& token_stops);
+  template <class TokenStops, class LineEnds>
+  void scan_line(const TokenStops& token_stops, const LineEnds& line_ends,
+                 vector<string_view>* tokens);
+  template <class TokenStops, class LineEnds>
+  string* scan_line(const TokenStops& token_stops, const LineEnds& line_ends,
+                    int* len);
+  template <class TokenStops, class LineEnds>
+  void scan_line(const TokenStops& token_stops, const LineEnds& line_ends,
+                 vector<string>* tokens);
+
+  // In UTF-8 mode, a stop byte may turn out not to end a delimiter, and a
+  // delimiter may take more than one byte, so tokens are read, and lines
+  // split, differently.
+  string_view scan_token(const Utf8Delims& token_stops);
+  template <class TokenStops>
+  static void split_line(const TokenStops& token_stops, string_view line,
+                         vector<string_view>* tokens);
+  static void split_line(const Utf8Delims& token_stops, string_view line,
+                         vector<string_view>* tokens) {
+    token_stops.split(line, tokens);
+  }
 
+ private:
   // fields
   int curr_length_;  // The current number of characters stored in the buffer
                      // To understand the purpose of this, consider when
-                     // a file is less than BUF_SIZE in length.
+                     // a file is less than capacity_ in length.
 
   int curr_index_;   // The current index we are in to the buffer. 
                      // necessary since we many not parse the entire
                      // buffer in one function call.
 
-  char buffer_[BUF_SIZE];  // The buffer we maintiain for reading from
-                           // the file.
+  char* buffer_;     // The buffer we maintiain for reading from
+                     // the file. Aligned to BUF_ALIGNMENT.
+  size_t capacity_;  // The current size of buffer_.
+  size_t initial_capacity_;  // The size buffer_ starts at (and resets to).
+  bool adaptive_;    // Whether capacity_ grows as we read sequentially.
+  bool direct_;      // Whether we were asked to bypass the page cache.
+  bool o_direct_;    // Whether fd_ is open with O_DIRECT, so every read
+                     // must start at an aligned offset.
+
+  off_t buffer_offset_;  // The file offset of buffer_[0].
+  bool eof_;         // Whether the last fill_buffer() reached the end of
+                     // the file, so there is nothing past buffer_.
+
   int fd_;  // The File Descriptor that we use to manage our file.
   string delims_;  // the delimiters used for reading tokens
+  DelimSet token_stops_;  // the bytes that end a token: delims_, plus the
+                          // byte that reads as EOF from get_char()
+  DelimSet line_ends_;    // the bytes that end a line: '\n', plus the
+                          // byte that reads as EOF from get_char()
+  string scratch_;   // where a token or line that spans two fills is put
+                     // back together, so a view of it can be returned
+
+  bool utf8_;        // Whether the reader is in UTF-8 mode
+  Utf8Delims utf8_stops_;  // delims_ and Unicode white space, in UTF-8 mode
+  Utf8Validator utf8_validator_;  // checks what is read, in UTF-8 mode
+  string utf8_token_;  // where a token in which a stop byte turned out not
+                       // to end a delimiter is put together
+  vector<string_view> line_tokens_;  // reused by the get_line()s that
+                                     // return copies of the tokens
   bool good_;  // Whether or not the reader is good to read
 
   int fill_num_;  // record the num of calling fill_buffer()
 
+  bool stats_enabled_;  // Whether stats_ is being counted
+  ReaderStats stats_;   // see stats()
+
+  off_t line_offset_;     // find_next() has counted line_number_ '\n's
+  uint64_t line_number_;  // before this offset
+
+  // Readahead. When readahead_ is set, ra_thread_ fills ahead_buffer_
+  // with the capacity_ bytes that follow buffer_, and fill_buffer()
+  // swaps the two. Everything from ra_state_ down is guarded by ra_mutex_.
+  enum ReadaheadState {
+    RA_IDLE,       // nothing requested, ahead_buffer_ is ours
+    RA_REQUESTED,  // the thread is (or is about to be) reading
+    RA_READY,      // ahead_buffer_ holds ra_length_ bytes from ra_offset_
+  };
+  bool readahead_;
+  char* ahead_buffer_;  // the buffer being read into. Aligned like buffer_.
+  std::thread ra_thread_;
+  std::mutex ra_mutex_;
+  std::condition_variable ra_cv_;
+  ReadaheadState ra_state_;
+  bool ra_stop_;     // tells ra_thread_ to exit
+  int ra_fd_;        // the file to read from
+  off_t ra_offset_;  // where in the file to read from
+  int ra_length_;    // how much was read
+  bool ra_eof_;      // whether the read reached the end of the file
+  int ra_syscalls_;  // how many pread()s the read took
+  int ra_eintr_;     // how many of them were interrupted
+
   // Suggested Helpers
   void fill_buffer();
+  size_t read_direct(char* dst, size_t n);
+  void resize_buffer(size_t capacity);
+  void reset_buffer();
+  void fill_from_readahead();
+  void request_readahead(off_t offset);
+  void cancel_readahead();
+  void count_readahead();
+  void readahead_loop();
+  bool next_number_token(string_view* token);
+  void count_lines_to(off_t offset);
+  uint64_t count_file_newlines(off_t from, off_t to);
+  void set_delims(const string& delims);
   bool is_delim(char c);
 };
 
+template <class Stops>
+int BufferedFileReader::read_until(const Stops& stops, string_view* token) {
+  // If there is no file open currently, then the token is empty.
+  if (this->fd_ == -1) {
+    this->good_ = false;
+    *token = string_view();
+    return EOF;
+  }
+  return TokenScanner::read_until(this, &BufferedFileReader::fill_buffer,
+                                  stops, token);
+}
+
+template <class Stops>
+string_view BufferedFileReader::scan_token(const Stops& token_stops) {
+  string_view token;
+  read_until(token_stops, &token);
+  if (stats_enabled_) {
+    stats_.tokens++;
+  }
+  return token;
+}
+
+template <class TokenStops, class LineEnds>
+void BufferedFileReader::scan_line(const TokenStops& token_stops,
+                                   const LineEnds& line_ends,
+                                   vector<string_view>* tokens) {
+  // Read the whole line first, so every token in it is in one place
+  // (the buffer, or scratch_ if the line crosses a refill), then split it.
+  string_view line;
+  read_until(line_ends, &line);
+
+  split_line(token_stops, line, tokens);
+  if (stats_enabled_) {
+    stats_.tokens += tokens->size();
+    stats_.lines++;
+  }
+}
+
+template <class TokenStops>
+void BufferedFileReader::split_line(const TokenStops& token_stops,
+                                    string_view line,
+                                    vector<string_view>* tokens) {
+  TokenScanner::split_line(token_stops, line, tokens);
+}
+
+template <class TokenStops, class LineEnds>
+string* BufferedFileReader::scan_line(const TokenStops& token_stops,
+                                      const LineEnds& line_ends, int* len) {
+  scan_line(token_stops, line_ends, &line_tokens_);
+  *len = line_tokens_.size();
+
+  string* token_line = new string[*len + 1];
+  for (int i = 0; i < *len; i++) {
+    token_line[i] = string(line_tokens_[i]);
+  }
+  return token_line;
+}
+
+template <class TokenStops, class LineEnds>
+void BufferedFileReader::scan_line(const TokenStops& token_stops,
+                                   const LineEnds& line_ends,
+                                   vector<string>* tokens) {
+  scan_line(token_stops, line_ends, &line_tokens_);
+
+  // Assign over the strings already in the vector, so their storage is
+  // reused instead of being freed and allocated again.
+  tokens->resize(line_tokens_.size());
+  for (size_t i = 0; i < line_tokens_.size(); i++) {
+    (*tokens)[i].assign(line_tokens_[i].data(), line_tokens_[i].size());
+  }
+}
+
 
 #endif  // BUFFEREDFILE_READER_H_
@@ -0,0 +1,204 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./BufferedFileWriter.h"
+
+constexpr size_t BufferedFileWriter::BUF_SIZE;
+constexpr size_t BufferedFileWriter::BUF_ALIGNMENT;
+
+BufferedFileWriter::BufferedFileWriter(const string& fname, size_t buf_size,
+                                       bool sync_on_close) {
+    void* buf;
+
+    this->fd_ = -1;                     // no file open yet
+    this->sync_on_close_ = sync_on_close;
+    this->curr_length_ = 0;
+    this->file_offset_ = 0;
+    if (posix_memalign(&buf, BUF_ALIGNMENT, buf_size) != 0) {
+        perror("posix_memalign failed");
+        exit(EXIT_FAILURE);
+    }
+    this->buffer_ = static_cast<char*>(buf);
+    this->capacity_ = buf_size;
+    open_file(fname);
+}
+
+BufferedFileWriter::~BufferedFileWriter() {
+    close_file();
+    free(this->buffer_);
+    this->buffer_ = nullptr;
+}
+
+void BufferedFileWriter::open_file(const string& fname) {
+    //if the object is already managing a file, that file is closed.
+    if (this->fd_ != -1) {
+        close_file();
+    }
+    this->fd_ = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (this->fd_ == -1) {
+        perror("open failed");
+        exit(EXIT_FAILURE);
+    }
+    this->curr_length_ = 0;
+    this->file_offset_ = 0;
+}
+
+void BufferedFileWriter::close_file() {
+    if (this->fd_ == -1) {
+        return;
+    }
+    if (this->sync_on_close_) {
+        sync();
+    } else {
+        flush();
+    }
+    close(this->fd_);
+    this->fd_ = -1;                     // indicates no file open
+    this->curr_length_ = 0;
+    this->file_offset_ = 0;
+}
+
+void BufferedFileWriter::put_char(char c) {
+    if (this->fd_ == -1) {
+        return;
+    }
+    if (curr_length_ == capacity_) {
+        flush();
+    }
+    buffer_[curr_length_++] = c;
+}
+
+void BufferedFileWriter::put_bytes(const char* data, size_t len) {
+    if (this->fd_ == -1) {
+        return;
+    }
+
+    // Fits in the buffer: just copy it in.
+    if (curr_length_ + len <= capacity_) {
+        memcpy(buffer_ + curr_length_, data, len);
+        curr_length_ += len;
+        return;
+    }
+
+    // Big enough to fill a buffer by itself: write what's buffered and the
+    // new bytes together, without copying them.
+    if (len >= capacity_) {
+        struct iovec iov[2];
+        iov[0].iov_base = buffer_;
+        iov[0].iov_len = curr_length_;
+        iov[1].iov_base = const_cast<char*>(data);
+        iov[1].iov_len = len;
+        write_all(iov, 2);
+        file_offset_ += curr_length_ + len;
+        curr_length_ = 0;
+        return;
+    }
+
+    // Otherwise top up the buffer, write it out, and buffer the rest.
+    size_t room = capacity_ - curr_length_;
+    memcpy(buffer_ + curr_length_, data, room);
+    curr_length_ = capacity_;
+    flush();
+    memcpy(buffer_, data + room, len - room);
+    curr_length_ = len - room;
+}
+
+void BufferedFileWriter::put_token(string_view token, char delim) {
+    put_bytes(token.data(), token.size());
+    put_char(delim);
+}
+
+void BufferedFileWriter::put_line(const string* tokens, int len, char delim) {
+    for (int i = 0; i < len; i++) {
+        if (i > 0) {
+            put_char(delim);
+        }
+        put_bytes(tokens[i].data(), tokens[i].size());
+    }
+    put_char('\n');
+}
+
+void BufferedFileWriter::put_line(const vector<string>& tokens, char delim) {
+    put_line(tokens.data(), tokens.size(), delim);
+}
+
+void BufferedFileWriter::flush() {
+    if (this->fd_ == -1 || curr_length_ == 0) {
+        return;
+    }
+    struct iovec iov;
+    iov.iov_base = buffer_;
+    iov.iov_len = curr_length_;
+    write_all(&iov, 1);
+    file_offset_ += curr_length_;
+    curr_length_ = 0;
+}
+
+void BufferedFileWriter::sync() {
+    if (this->fd_ == -1) {
+        return;
+    }
+    flush();
+    while (fdatasync(this->fd_) == -1) {
+        if (errno != EINTR) {
+            perror("fdatasync failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+off_t BufferedFileWriter::tell() {
+    return file_offset_ + curr_length_;
+}
+
+bool BufferedFileWriter::good() {
+    return this->fd_ != -1;
+}
+
+void BufferedFileWriter::write_all(const struct iovec* iov, int iovcnt) {
+    struct iovec remaining[2];
+    memcpy(remaining, iov, iovcnt * sizeof(struct iovec));
+    struct iovec* next = remaining;
+
+    while (iovcnt > 0) {
+        ssize_t result = writev(this->fd_, next, iovcnt);
+        if (result == -1) {
+            if (errno != EINTR) {
+                perror("writev failed");
+                exit(EXIT_FAILURE);
+            }
+            continue;       // EINTR happened, so do nothing and try again
+        }
+
+        // A short write: skip what was written, and go again.
+        size_t written = result;
+        while (iovcnt > 0 && written >= next->iov_len) {
+            written -= next->iov_len;
+            next++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + written;
+            next->iov_len -= written;
+        }
+    }
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef BUFFEREDFILEWRITER_H_
+#define BUFFEREDFILEWRITER_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// A BufferedFileWriter is a class for writing files.
+//
+// It is the counterpart of BufferedFileReader: writes are collected in a
+// buffer and handed to the kernel with one write() when the buffer fills,
+// instead of one system call per character or token. Writes too big to be
+// worth copying into the buffer go straight to the file, together with
+// whatever is already buffered, in a single writev().
+//
+// Nothing is guaranteed to be in the file until flush() or close_file().
+///////////////////////////////////////////////////////////////////////////////
+class BufferedFileWriter {
+ public:
+  // Constants
+  static constexpr size_t BUF_SIZE = 4096;  // the default buffer size.
+  static constexpr size_t BUF_ALIGNMENT = 4096;  // the buffer's alignment.
+
+  // Constructor for a BufferedFileWriter. Creates the file, or empties
+  // it if it already exists, and starts writing at the front of it.
+  // Undefined behaviour if the file can't be created.
+  //
+  // Arguments:
+  // - fname: The name of the file to be written
+  // - buf_size: how many bytes to collect before writing them to the
+  //   file. Must be > 0.
+  // - sync_on_close: if true, close_file() (and so the destructor) also
+  //   waits for the file's contents to reach the disk with fdatasync(),
+  //   so they survive a crash.
+  BufferedFileWriter(const string& fname, size_t buf_size=BUF_SIZE,
+                     bool sync_on_close=false);
+
+  // Destructor for a BufferedFileWriter. Flushes and closes the file.
+  //
+  // Arguments: None
+  ~BufferedFileWriter();
+
+  // Sets up the BufferedFileWriter to write to the specified file from
+  // the start, creating or emptying it, and closing any file already open
+  // (see close_file()).
+  // Undefined behaviour if the file can't be created.
+  //
+  // Arguments:
+  // - fname: The name of the file to be written
+  void open_file(const string& fname);
+
+  // Flushes and closes the file currently managed by the
+  // BufferedFileWriter, waiting for it to reach the disk if sync_on_close
+  // was set. If there is not a file currently open, then nothing should
+  // happen.
+  //
+  // Arguments: None
+  void close_file();
+
+  // Writes a single character to the file.
+  // Does nothing if there is no file open currently.
+  //
+  // Arguments:
+  // - c: the character to write
+  void put_char(char c);
+
+  // Writes len bytes to the file. If len is at least the size of the
+  // buffer, the bytes aren't copied into it, but written directly
+  // (along with anything already buffered, in one writev()).
+  // Does nothing if there is no file open currently.
+  //
+  // Arguments:
+  // - data: the bytes to write
+  // - len: how many bytes to write
+  void put_bytes(const char* data, size_t len);
+
+  // Writes a token followed by a delimiter, so that the file can be read
+  // back with BufferedFileReader::get_token().
+  // Does nothing if there is no file open currently.
+  //
+  // Arguments:
+  // - token: the token to write
+  // - delim: the delimiter to write after it
+  void put_token(string_view token, char delim=' ');
+
+  // Writes a line of tokens: the tokens separated by delim and followed by
+  // '\n', so that the file can be read back with
+  // BufferedFileReader::get_line().
+  // Does nothing if there is no file open currently.
+  //
+  // Arguments:
+  // - tokens: the array of tokens to write
+  // - len: the length of the array
+  // - delim: the delimiter to write between tokens
+  void put_line(const string* tokens, int len, char delim=' ');
+
+  // Same as put_line(const string*, int, char), for a vector of tokens.
+  void put_line(const vector<string>& tokens, char delim=' ');
+
+  // Writes everything buffered so far to the file.
+  // Does nothing if there is no file open currently.
+  //
+  // Arguments: None
+  void flush();
+
+  // Flushes the file, then waits for its contents to reach the disk
+  // with fdatasync().
+  // Does nothing if there is no file open currently.
+  //
+  // Arguments: None
+  void sync();
+
+  // Returns how many bytes have been written to the file so far,
+  // including the ones still in the buffer.
+  // Undefined behaviour if there is no file open currently.
+  off_t tell();
+
+  // Returns whether or not a file is open for writing.
+  bool good();
+
+  // Disabling the copy constructor and the assignment operator.
+  BufferedFileWriter(const BufferedFileWriter& other) = delete;
+  BufferedFileWriter& operator=(const BufferedFileWriter other) = delete;
+
+ private:
+  // fields
+  char* buffer_;       // The buffer we collect writes in. Aligned to
+                       // BUF_ALIGNMENT.
+  size_t capacity_;    // The size of buffer_.
+  size_t curr_length_;  // How many bytes are in buffer_.
+  off_t file_offset_;  // The file offset of buffer_[0], which is how much
+                       // has been written to the file itself.
+  bool sync_on_close_;  // Whether close_file() calls fdatasync().
+  int fd_;             // The File Descriptor that we use to manage our file.
+
+  // Helpers
+  void write_all(const struct iovec* iov, int iovcnt);
+};
+
+
+#endif  // BUFFEREDFILEWRITER_H_
@@ -0,0 +1,142 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./DelimSet.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DELIMSET_X86 1
+#endif
+
+constexpr int DelimSet::MAX_SIMD_CHARS;
+constexpr int DelimSet::SCALAR_PREFIX;
+
+DelimSet::DelimSet(const string& chars) {
+    bits_[0] = bits_[1] = bits_[2] = bits_[3] = 0;
+    num_chars_ = 0;
+    for (char c : chars) {
+        add(c);
+    }
+}
+
+void DelimSet::add(char c) {
+    unsigned char uc = static_cast<unsigned char>(c);
+    if (contains(c)) {
+        return;
+    }
+    bits_[uc >> 6] |= 1ULL << (uc & 63);
+    if (num_chars_ < MAX_SIMD_CHARS) {
+        chars_[num_chars_] = c;
+    }
+    num_chars_++;
+}
+
+const char* DelimSet::find_scalar(const char* begin, const char* end) const {
+    for (const char* p = begin; p < end; p++) {
+        if (contains(*p)) {
+            return p;
+        }
+    }
+    return end;
+}
+
+#ifdef DELIMSET_X86
+
+// Each of these compares a block against every member of the set and ORs
+// the results together, then uses the movemask bits to find the first hit.
+
+static const char* find_sse2(const char* p, const char* end,
+                             const char* chars, int num_chars) {
+    __m128i needles[DelimSet::MAX_SIMD_CHARS];
+    for (int i = 0; i < num_chars; i++) {
+        needles[i] = _mm_set1_epi8(chars[i]);
+    }
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_setzero_si128();
+        for (int i = 0; i < num_chars; i++) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[i]));
+        }
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return p;
+}
+
+__attribute__((target("avx2")))
+static const char* find_avx2(const char* p, const char* end,
+                             const char* chars, int num_chars) {
+    __m256i needles[DelimSet::MAX_SIMD_CHARS];
+    for (int i = 0; i < num_chars; i++) {
+        needles[i] = _mm256_set1_epi8(chars[i]);
+    }
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hits = _mm256_setzero_si256();
+        for (int i = 0; i < num_chars; i++) {
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[i]));
+        }
+        unsigned mask = _mm256_movemask_epi8(hits);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return p;
+}
+
+#endif  // DELIMSET_X86
+
+bool DelimSet::have_avx2() {
+#ifdef DELIMSET_X86
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif  // DELIMSET_X86
+}
+
+const char* DelimSet::find(const char* begin, const char* end) const {
+    const char* p = begin;
+
+    // Most tokens are short, and setting up the SIMD loops costs more than
+    // looking at a few bytes, so try the table on the first few first.
+    const char* prefix_end = (end - p > SCALAR_PREFIX) ? p + SCALAR_PREFIX : end;
+    for (; p < prefix_end; p++) {
+        if (contains(*p)) {
+            return p;
+        }
+    }
+
+#ifdef DELIMSET_X86
+    if (num_chars_ <= MAX_SIMD_CHARS) {
+        // Each loop stops at the first hit, or with less than a block left.
+        if (have_avx2()) {
+            p = find_avx2(p, end, chars_, num_chars_);
+        }
+        p = find_sse2(p, end, chars_, num_chars_);
+        if (p != end && contains(*p)) {
+            return p;
+        }
+    }
+#endif  // DELIMSET_X86
+
+    // Whatever the SIMD loops left over (less than one block), or
+    // everything, if the set is too big for them.
+    return find_scalar(p, end);
+}
+
+template class StaticDelimSet<'\r', '\n', '\t', ' ', static_cast<char>(EOF)>;
+template class StaticDelimSet<',', '\r', '\n', static_cast<char>(EOF)>;
+template class StaticDelimSet<'\n', static_cast<char>(EOF)>;
@@ -0,0 +1,217 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef DELIMSET_H_
+#define DELIMSET_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using std::string;
+
+///////////////////////////////////////////////////////////////////////////////
+// A DelimSet is a set of byte values (usually a reader's delimiters) that
+// can be tested one byte at a time or searched for in a whole buffer.
+//
+// Membership is a 256-bit table, so contains() is a shift and a mask
+// instead of a std::string::find() over the delimiters.
+//
+// find() scans 16 bytes at a time with SSE2, or 32 at a time with AVX2 on
+// CPUs that have it, as long as the set has at most MAX_SIMD_CHARS bytes
+// in it. The first few bytes of a search, bigger sets, non-x86 machines and
+// the last few bytes of a buffer use the table.
+///////////////////////////////////////////////////////////////////////////////
+class DelimSet {
+ public:
+  // The largest set that find() searches with SIMD.
+  static constexpr int MAX_SIMD_CHARS = 8;
+
+  // How many bytes find() checks with the table before switching to SIMD.
+  static constexpr int SCALAR_PREFIX = 16;
+
+  // Constructs a set holding each of the characters in chars.
+  //
+  // Arguments:
+  // - chars: the bytes to put in the set. Duplicates are ignored.
+  explicit DelimSet(const string& chars = "");
+
+  // Adds a single byte to the set.
+  //
+  // Arguments:
+  // - c: the byte to add
+  void add(char c);
+
+  // Returns whether or not c is in the set.
+  bool contains(char c) const {
+    unsigned char uc = static_cast<unsigned char>(c);
+    return (bits_[uc >> 6] >> (uc & 63)) & 1;
+  }
+
+  // Finds the first byte in [begin, end) that is in the set.
+  //
+  // Arguments:
+  // - begin, end: the range to search
+  //
+  // Returns:
+  // - a pointer to the first byte in the set, or end if there is none.
+  const char* find(const char* begin, const char* end) const;
+
+  // Same as find(), but never uses SIMD. Exposed for testing and
+  // benchmarking.
+  const char* find_scalar(const char* begin, const char* end) const;
+
+  // Returns whether the CPU has AVX2, so find() can use it.
+  static bool have_avx2();
+
+ private:
+  uint64_t bits_[4];  // bit c is set iff byte c is in the set
+  char chars_[MAX_SIMD_CHARS];  // the members, if there are few enough
+  int num_chars_;     // the number of members
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// A StaticDelimSet is a DelimSet whose members are fixed at compile time,
+// as template arguments.
+//
+// contains() is a lookup in a table built by the compiler, and find() runs
+// the same scans as DelimSet::find(), but with the bytes to compare against
+// as constants: there is no loop over the members, and the whole search
+// can be inlined into its caller.
+///////////////////////////////////////////////////////////////////////////////
+template <char... Chars>
+class StaticDelimSet {
+ public:
+  // How many members the set has (counting duplicates).
+  static constexpr int SIZE = sizeof...(Chars);
+
+  // Returns whether or not c is in the set.
+  static constexpr bool contains(char c) {
+    return kTable.members[static_cast<unsigned char>(c)];
+  }
+
+  // Finds the first byte in [begin, end) that is in the set.
+  // Same as DelimSet::find().
+  static inline const char* find(const char* begin, const char* end);
+
+ private:
+  struct Table {
+    bool members[256];
+  };
+
+  static constexpr Table make_table() {
+    Table table = {};
+    ((table.members[static_cast<unsigned char>(Chars)] = true), ...);
+    return table;
+  }
+
+  static constexpr Table kTable = make_table();
+
+#if defined(__x86_64__) || defined(__i386__)
+  static const char* find_sse2(const char* p, const char* end);
+  static const char* find_avx2(const char* p, const char* end);
+#endif
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Each of these compares a block against every member of the set and ORs
+// the results together, then uses the movemask bits to find the first hit.
+// They stop at the first hit, or with less than a block left.
+
+template <char... Chars>
+const char* StaticDelimSet<Chars...>::find_sse2(const char* p,
+                                                const char* end) {
+  while (end - p >= 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hits = _mm_setzero_si128();
+    ((hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(Chars)))),
+     ...);
+    int mask = _mm_movemask_epi8(hits);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+  return p;
+}
+
+template <char... Chars>
+__attribute__((target("avx2")))
+const char* StaticDelimSet<Chars...>::find_avx2(const char* p,
+                                                const char* end) {
+  while (end - p >= 32) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i hits = _mm256_setzero_si256();
+    ((hits = _mm256_or_si256(hits,
+                             _mm256_cmpeq_epi8(block, _mm256_set1_epi8(Chars)))),
+     ...);
+    unsigned mask = _mm256_movemask_epi8(hits);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return p;
+}
+
+#endif
+
+template <char... Chars>
+inline const char* StaticDelimSet<Chars...>::find(const char* begin,
+                                                  const char* end) {
+  const char* p = begin;
+
+  // As in DelimSet::find(), look at the first few bytes one at a time.
+  const char* prefix_end = (end - p > DelimSet::SCALAR_PREFIX)
+                               ? p + DelimSet::SCALAR_PREFIX : end;
+  for (; p < prefix_end; p++) {
+    if (contains(*p)) {
+      return p;
+    }
+  }
+
+#if defined(__x86_64__) || defined(__i386__)
+  if constexpr (0 < SIZE && SIZE <= DelimSet::MAX_SIMD_CHARS) {
+    if (DelimSet::have_avx2()) {
+      p = find_avx2(p, end);
+    }
+    p = find_sse2(p, end);
+    if (p != end && contains(*p)) {
+      return p;
+    }
+  }
+#endif
+
+  for (; p < end; p++) {
+    if (contains(*p)) {
+      return p;
+    }
+  }
+  return end;
+}
+
+// The stop sets of the named BasicBufferedReaders (see
+// BasicBufferedReader.h): their delimiters, plus the byte that reads as
+// EOF, and the line ends. Compiled once, in DelimSet.cc, instead of in every
+// file that uses them.
+extern template class StaticDelimSet<'\r', '\n', '\t', ' ',
+                                     static_cast<char>(EOF)>;
+extern template class StaticDelimSet<',', '\r', '\n', static_cast<char>(EOF)>;
+extern template class StaticDelimSet<'\n', static_cast<char>(EOF)>;
+
+
+#endif  // DELIMSET_H_
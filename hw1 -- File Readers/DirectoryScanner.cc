@@ -0,0 +1,141 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "./DirectoryScanner.h"
+
+constexpr size_t DirectoryScanner::BUF_SIZE;
+
+// Adds the regular files in dir, and in the directories under it, to files.
+static void list_into(const string& dir, vector<string>* files) {
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        perror("opendir failed");
+        exit(EXIT_FAILURE);
+    }
+    vector<string> names;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != nullptr) {
+        string name = entry->d_name;
+        if (name != "." && name != "..") {
+            names.push_back(name);
+        }
+    }
+    closedir(d);
+
+    std::sort(names.begin(), names.end());
+    for (const string& name : names) {
+        string path = dir + "/" + name;
+        struct stat st;
+        if (lstat(path.c_str(), &st) == -1) {
+            perror("lstat failed");
+            exit(EXIT_FAILURE);
+        }
+        if (S_ISDIR(st.st_mode)) {
+            list_into(path, files);
+        } else if (S_ISREG(st.st_mode)) {
+            files->push_back(path);
+        }
+    }
+}
+
+vector<string> DirectoryScanner::list_directory(const string& dir) {
+    vector<string> files;
+    list_into(dir, &files);
+    return files;
+}
+
+DirectoryScanner::DirectoryScanner(const vector<string>& files,
+                                   const string& delims, int num_threads,
+                                   size_t buf_size) {
+    this->files_ = files;
+    this->delims_ = delims;
+    this->num_threads_ = num_threads;
+    this->buf_size_ = buf_size;
+    this->total_bytes_ = 0;
+
+    for (const string& fname : files) {
+        struct stat st;
+        if (stat(fname.c_str(), &st) == -1) {
+            perror("stat failed");
+            exit(EXIT_FAILURE);
+        }
+        this->sizes_.push_back(st.st_size);
+        this->total_bytes_ += st.st_size;
+    }
+
+    // Biggest first; files of the same size in the order they were given.
+    for (int i = 0; i < num_files(); i++) {
+        this->order_.push_back(i);
+    }
+    std::stable_sort(this->order_.begin(), this->order_.end(),
+                     [this](int a, int b) {
+                         return this->sizes_[a] > this->sizes_[b];
+                     });
+}
+
+void DirectoryScanner::for_each_token(const TokenFn& fn) {
+    for_each_file([&fn](int file, BufferedFileReader* reader) {
+        while (reader->good()) {
+            fn(file, reader->get_token_view());
+        }
+    });
+}
+
+void DirectoryScanner::for_each_line(const LineFn& fn) {
+    for_each_file([&fn](int file, BufferedFileReader* reader) {
+        vector<string_view> tokens;
+        while (reader->good()) {
+            reader->get_line(&tokens);
+            fn(file, tokens);
+        }
+    });
+}
+
+void DirectoryScanner::for_each_file(const FileFn& fn) {
+    // The threads take the next file off order_ as they finish one.
+    std::atomic<int> next(0);
+    auto worker = [this, &fn, &next]() {
+        std::unique_ptr<BufferedFileReader> reader;
+        for (int i = next++; i < num_files(); i = next++) {
+            int file = this->order_[i];
+            if (reader == nullptr) {
+                reader.reset(new BufferedFileReader(this->files_[file],
+                                                    this->delims_,
+                                                    this->buf_size_));
+            } else {
+                reader->open_file(this->files_[file]);
+            }
+            fn(file, reader.get());
+        }
+    };
+
+    int num_threads = std::min(this->num_threads_, num_files());
+    vector<std::thread> threads;
+    for (int i = 1; i < num_threads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();                           // this thread is one of the pool
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef DIRECTORYSCANNER_H_
+#define DIRECTORYSCANNER_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./BufferedFileReader.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// A DirectoryScanner tokenizes many files on a fixed pool of threads.
+//
+// Each thread has one BufferedFileReader, which it moves from file to file
+// with open_file(), so a file costs an open() and its reads, not a new
+// reader and buffer. On its own that saves little: next to the open(),
+// read() and close() of even a small file, a reader is cheap to construct.
+// What the pool buys is the threads. They take the files biggest first, so
+// the big ones are under way early and the small ones fill in the gaps at
+// the end, instead of one big file holding everyone up.
+//
+// for_each_token() and for_each_line() call their callback through a
+// std::function for every token or line, which costs about as much again as
+// the tokenizing; for_each_file() is the one to use when that matters.
+//
+// The tokens and lines are exactly the ones BufferedFileReader returns for
+// each file.
+///////////////////////////////////////////////////////////////////////////////
+class DirectoryScanner {
+ public:
+  // The default size of each thread's buffer. It is allocated once per
+  // thread, not once per file, so it can be generous: a small file is
+  // read in one read() whatever the size, and a big one in fewer.
+  static constexpr size_t BUF_SIZE = 64 << 10;
+
+  // Called with each token, and the index of the file it is in. The token
+  // is only valid until the callback returns.
+  typedef std::function<void(int file, string_view token)> TokenFn;
+
+  // Called with each line's tokens, and the index of the file it is in.
+  // The tokens are only valid until the callback returns.
+  typedef std::function<void(int file, const vector<string_view>& tokens)>
+      LineFn;
+
+  // Called with each file, open in a thread's reader, to read however it
+  // likes. The reader is reused for other files once the callback returns.
+  typedef std::function<void(int file, BufferedFileReader* reader)> FileFn;
+
+  // Returns the names of the regular files in a directory and the
+  // directories under it, in name order. Symbolic links aren't followed.
+  // Undefined behaviour if the directory can't be read.
+  //
+  // Arguments:
+  // - dir: the directory to list
+  static vector<string> list_directory(const string& dir);
+
+  // Constructor for a DirectoryScanner. Finds the size of each file, to
+  // decide the order they are read in.
+  // Undefined behaviour if a file name is invalid.
+  //
+  // Arguments:
+  // - files: the names of the files to read, as from list_directory()
+  // - delims: the delimiters for reading tokens, as for
+  //   BufferedFileReader.
+  // - num_threads: how many threads read the files. Must be > 0.
+  // - buf_size: the size of each thread's buffer. Must be > 0.
+  DirectoryScanner(const vector<string>& files,
+                   const string& delims="\r\n\t ", int num_threads=1,
+                   size_t buf_size=BUF_SIZE);
+
+  // Returns how many files there are, and the name and size of file i:
+  // the i-th of the files passed to the constructor.
+  int num_files() const { return files_.size(); }
+  const string& file_name(int i) const { return files_[i]; }
+  off_t file_size(int i) const { return sizes_[i]; }
+
+  // Returns the size of all the files together.
+  off_t total_bytes() const { return total_bytes_; }
+
+  // Reads every file, and calls fn with each token. Calls for the same
+  // file happen in file order, on one thread; calls for different files
+  // happen at the same time, so fn must be safe to call from several
+  // threads.
+  //
+  // Arguments:
+  // - fn: what to call with each token
+  void for_each_token(const TokenFn& fn);
+
+  // Same as for_each_token(), a line at a time.
+  //
+  // Arguments:
+  // - fn: what to call with each line
+  void for_each_line(const LineFn& fn);
+
+  // Same as for_each_token(), a file at a time: fn does the reading. This
+  // costs one call per file instead of one per token.
+  //
+  // Arguments:
+  // - fn: what to call with each file
+  void for_each_file(const FileFn& fn);
+
+  // Disabling the copy constructor and the assignment operator.
+  DirectoryScanner(const DirectoryScanner& other) = delete;
+  DirectoryScanner& operator=(const DirectoryScanner other) = delete;
+
+ private:
+  // fields
+  vector<string> files_;  // the files' names
+  vector<off_t> sizes_;   // the files' sizes, when we were constructed
+  vector<int> order_;     // the files' indexes, biggest file first
+  off_t total_bytes_;     // the sum of sizes_
+  string delims_;         // the delimiters used for reading tokens
+  int num_threads_;       // how many threads read the files
+  size_t buf_size_;       // the size of each thread's buffer
+};
+
+
+#endif  // DIRECTORYSCANNER_H_
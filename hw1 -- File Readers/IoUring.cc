@@ -0,0 +1,170 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./IoUring.h"
+
+IoUring::IoUring() {
+    this->ring_fd_ = -1;
+    this->sq_ring_ = nullptr;
+    this->cq_ring_ = nullptr;
+    this->sqes_ = nullptr;
+    this->to_submit_ = 0;
+}
+
+IoUring::~IoUring() {
+    tear_down();
+}
+
+void IoUring::tear_down() {
+    if (this->sqes_ != nullptr) {
+        munmap(this->sqes_, this->sqes_size_);
+    }
+    if (this->cq_ring_ != nullptr && this->cq_ring_ != this->sq_ring_) {
+        munmap(this->cq_ring_, this->cq_ring_size_);
+    }
+    if (this->sq_ring_ != nullptr) {
+        munmap(this->sq_ring_, this->sq_ring_size_);
+    }
+    if (this->ring_fd_ != -1) {
+        close(this->ring_fd_);
+    }
+    this->ring_fd_ = -1;
+    this->sq_ring_ = nullptr;
+    this->cq_ring_ = nullptr;
+    this->sqes_ = nullptr;
+    this->to_submit_ = 0;
+}
+
+bool IoUring::init(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd == -1) {
+        return false;                   // no io_uring here
+    }
+    this->ring_fd_ = fd;
+
+    // Map the two queues. Newer kernels put both in one mapping.
+    this->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    this->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap && this->cq_ring_size_ > this->sq_ring_size_) {
+        this->sq_ring_size_ = this->cq_ring_size_;
+    }
+    this->sq_ring_ = mmap(nullptr, this->sq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (this->sq_ring_ == MAP_FAILED) {
+        perror("mmap failed");
+        exit(EXIT_FAILURE);
+    }
+    if (single_mmap) {
+        this->cq_ring_ = this->sq_ring_;
+    } else {
+        this->cq_ring_ = mmap(nullptr, this->cq_ring_size_, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (this->cq_ring_ == MAP_FAILED) {
+            perror("mmap failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    this->sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, this->sqes_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        perror("mmap failed");
+        exit(EXIT_FAILURE);
+    }
+    this->sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(this->sq_ring_);
+    this->sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    this->sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    this->sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    this->sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(this->cq_ring_);
+    this->cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    this->cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    this->cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    this->cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+void IoUring::prep_read(int fd, char* buf, unsigned len, off_t offset,
+                        uint64_t user_data) {
+    // Only we write the tail, so a plain load of it is fine.
+    unsigned tail = *this->sq_tail_;
+    unsigned index = tail & *this->sq_mask_;
+    struct io_uring_sqe* sqe = &this->sqes_[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    this->sq_array_[index] = index;
+
+    // Publish the entry before the kernel can see the new tail.
+    __atomic_store_n(this->sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    this->to_submit_++;
+}
+
+int IoUring::submit(unsigned wait_nr) {
+    if (this->to_submit_ == 0 && wait_nr == 0) {
+        return 0;
+    }
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int calls = 0;
+    while (true) {
+        int result = syscall(__NR_io_uring_enter, this->ring_fd_,
+                             this->to_submit_, wait_nr, flags, nullptr, 0);
+        calls++;
+        if (result == -1) {
+            if (errno != EINTR) {
+                perror("io_uring_enter failed");
+                exit(EXIT_FAILURE);
+            }
+            continue;       // EINTR happened, so do nothing and try again
+        }
+        this->to_submit_ -= result;     // how many the kernel took
+        return calls;
+    }
+}
+
+bool IoUring::next_completion(uint64_t* user_data, int* result) {
+    unsigned head = *this->cq_head_;
+    // Acquire, so the entry is read after the kernel wrote it.
+    if (head == __atomic_load_n(this->cq_tail_, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    struct io_uring_cqe* cqe = &this->cqes_[head & *this->cq_mask_];
+    *user_data = cqe->user_data;
+    *result = cqe->res;
+
+    // Hand the entry back to the kernel once we're done reading it.
+    __atomic_store_n(this->cq_head_, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
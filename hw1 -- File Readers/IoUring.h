@@ -0,0 +1,114 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef IOURING_H_
+#define IOURING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+///////////////////////////////////////////////////////////////////////////////
+// An IoUring is a minimal io_uring instance that can only queue reads.
+//
+// It talks to the kernel with the raw io_uring_setup() and io_uring_enter()
+// system calls, so it doesn't need liburing. Reads are queued with
+// prep_read(), handed to the kernel with submit(), and their results come
+// back, in whatever order they finish, from next_completion().
+//
+// On kernels without io_uring (or where it's disabled), init() fails and
+// the caller should do its reads some other way.
+///////////////////////////////////////////////////////////////////////////////
+class IoUring {
+ public:
+  // Constructs an IoUring that isn't set up yet.
+  IoUring();
+
+  // Tears down the ring, if it was set up. Reads still in flight
+  // should be waited for first.
+  ~IoUring();
+
+  // Sets up a ring with room for at least `entries` reads at once.
+  //
+  // Returns:
+  // - true on success, false if io_uring isn't available.
+  bool init(unsigned entries);
+
+  // Returns whether or not init() succeeded (and tear_down() hasn't been
+  // called since).
+  bool ok() const { return ring_fd_ != -1; }
+
+  // Tears down the ring, as the destructor does, so ok() is false. Reads
+  // still in flight should be waited for first.
+  void tear_down();
+
+  // Queues a read of len bytes at offset in fd into buf. Nothing is sent
+  // to the kernel until submit(). Must not be called more times between
+  // submits than there are entries.
+  //
+  // Arguments:
+  // - fd, buf, len, offset: as for pread()
+  // - user_data: handed back with the read's completion
+  void prep_read(int fd, char* buf, unsigned len, off_t offset,
+                 uint64_t user_data);
+
+  // Sends every queued read to the kernel, and waits until at least
+  // wait_nr reads have completed.
+  //
+  // Returns:
+  // - how many times io_uring_enter() was called: 0 if there was nothing
+  //   to do, otherwise 1 plus one for each time it was interrupted.
+  int submit(unsigned wait_nr);
+
+  // Takes the next completed read off the completion queue.
+  //
+  // Arguments:
+  // - user_data: returns the user_data the read was queued with
+  // - result: returns what pread() would have: the number of bytes read,
+  //   or -errno
+  //
+  // Returns:
+  // - false if no read has completed (that hasn't been returned already)
+  bool next_completion(uint64_t* user_data, int* result);
+
+  // Disabling the copy constructor and the assignment operator.
+  IoUring(const IoUring& other) = delete;
+  IoUring& operator=(const IoUring other) = delete;
+
+ private:
+  int ring_fd_;         // the ring, or -1 if not set up
+
+  // The submission queue, shared with the kernel.
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned* sq_mask_;
+  unsigned* sq_array_;
+  io_uring_sqe* sqes_;
+  size_t sqes_size_;
+  unsigned to_submit_;  // reads queued since the last submit()
+
+  // The completion queue, shared with the kernel. It may be the same
+  // mapping as the submission queue.
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned* cq_mask_;
+  io_uring_cqe* cqes_;
+};
+
+
+#endif  // IOURING_H_
@@ -0,0 +1,354 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "./IoUringFileReader.h"
+
+constexpr size_t IoUringFileReader::DEFAULT_BLOCK_SIZE;
+constexpr int IoUringFileReader::DEFAULT_QUEUE_DEPTH;
+constexpr size_t IoUringFileReader::BLOCK_ALIGNMENT;
+
+IoUringFileReader::IoUringFileReader(const string& fname, const string& delims,
+                                     size_t block_size, int queue_depth,
+                                     bool use_io_uring) {
+    this->fd_ = -1;                     // no file open yet
+    this->good_ = false;
+    this->block_size_ = block_size;
+    this->stats_enabled_ = false;
+    this->stats_ = ReaderStats();
+    this->delims_ = delims;
+    this->token_stops_ = DelimSet(delims);
+    this->token_stops_.add(EOF);
+    this->line_ends_ = DelimSet("\n");
+    this->line_ends_.add(EOF);
+
+    this->blocks_.resize(queue_depth);
+    for (Block& block : this->blocks_) {
+        void* buf;
+        if (posix_memalign(&buf, BLOCK_ALIGNMENT, block_size) != 0) {
+            perror("posix_memalign failed");
+            exit(EXIT_FAILURE);
+        }
+        block.data = static_cast<char*>(buf);
+        block.state = BLOCK_EMPTY;
+    }
+
+    // If this fails, ring_.ok() is false and we use pread().
+    if (use_io_uring) {
+        this->ring_.init(queue_depth);
+    }
+    open_file(fname);
+}
+
+IoUringFileReader::~IoUringFileReader() {
+    close_file();                       // waits for the reads in flight
+    for (Block& block : this->blocks_) {
+        free(block.data);
+    }
+}
+
+void IoUringFileReader::open_file(const string& fname) {
+    struct stat st;
+
+    //if the object is already managing a file, that file is closed.
+    if (this->fd_ != -1) {
+        close_file();
+    }
+    this->fd_ = open(fname.c_str(), O_RDONLY);
+    if (this->fd_ == -1) {
+        perror("open failed");
+        this->good_ = false;                  // no file open
+        exit(EXIT_FAILURE);
+    }
+    if (fstat(this->fd_, &st) == -1) {
+        perror("fstat failed");
+        exit(EXIT_FAILURE);
+    }
+    this->file_size_ = st.st_size;
+    start_reads();
+}
+
+void IoUringFileReader::close_file() {
+    drain();                            // the kernel may be using fd_
+    if (this->fd_ != -1) {
+        close(this->fd_);
+    }
+    this->fd_ = -1;                     // indicates no file open
+    this->good_ = false;                // no file open
+    this->curr_block_ = -1;
+    this->buffer_ = nullptr;
+    this->curr_length_ = 0;
+    this->curr_index_ = 0;
+    this->buffer_offset_ = 0;
+    this->eof_ = false;
+}
+
+char IoUringFileReader::get_char() {
+    // If there is no file open currently, then EOF is returned.
+    if (this->fd_ == -1) {
+        this->good_ = false;
+        return EOF;
+    }
+
+    if (curr_index_ == curr_length_) {      // arrived at the end of the block
+        if (eof_) {                         // and there is nothing after it
+            this->good_ = false;
+            return EOF;
+        }
+        next_block();
+        if (curr_length_ == 0) {
+            return EOF;
+        }
+    }
+
+    return buffer_[curr_index_++];
+}
+
+string IoUringFileReader::get_token() {
+    string_view token;
+    read_until(token_stops_, &token);
+    if (stats_enabled_) {
+        stats_.tokens++;
+    }
+    return string(token);
+}
+
+string_view IoUringFileReader::get_token_view() {
+    string_view token;
+    read_until(token_stops_, &token);
+    if (stats_enabled_) {
+        stats_.tokens++;
+    }
+    return token;
+}
+
+string* IoUringFileReader::get_line(int* len) {
+    // Read the whole line first, so every token in it is in one place,
+    // then split it.
+    string_view line;
+    read_until(line_ends_, &line);
+
+    TokenScanner::split_line(token_stops_, line, &line_tokens_);
+    if (stats_enabled_) {
+        stats_.tokens += line_tokens_.size();
+        stats_.lines++;
+    }
+
+    *len = line_tokens_.size();
+    string* token_line = new string[*len + 1];
+    for (int i = 0; i < *len; i++) {
+        token_line[i] = string(line_tokens_[i]);
+    }
+    return token_line;
+}
+
+off_t IoUringFileReader::tell() {
+    return buffer_offset_ + curr_index_;
+}
+
+void IoUringFileReader::rewind() {
+    // If there is no file open currently, then exit
+    if (this->fd_ == -1) {
+        this->good_ = false;
+        exit(EXIT_FAILURE);
+    }
+    drain();                            // throw away the reads in flight
+    start_reads();
+}
+
+bool IoUringFileReader::good() {
+    return this->good_;
+}
+
+void IoUringFileReader::start_reads() {
+    this->next_offset_ = 0;
+    this->curr_block_ = -1;
+    this->buffer_ = nullptr;
+    this->curr_length_ = 0;
+    this->curr_index_ = 0;
+    this->buffer_offset_ = 0;
+    this->eof_ = false;
+    this->good_ = true;
+
+    // Queue up every block at once, and hand them to the kernel together.
+    for (size_t i = 0; i < blocks_.size(); i++) {
+        submit_block(i);
+    }
+    if (ring_.ok()) {
+        count_enters(ring_.submit(0));
+    }
+    next_block();
+}
+
+void IoUringFileReader::submit_block(int i) {
+    Block& block = blocks_[i];
+    if (next_offset_ >= file_size_) {
+        block.state = BLOCK_EMPTY;      // the file ends before this block
+        return;
+    }
+
+    block.offset = next_offset_;
+    block.length = std::min(static_cast<off_t>(block_size_),
+                            file_size_ - next_offset_);
+    block.state = BLOCK_IN_FLIGHT;
+    next_offset_ += block.length;
+
+    // Without io_uring, the read happens in wait_block().
+    if (ring_.ok()) {
+        ring_.prep_read(fd_, block.data, block.length, block.offset, i);
+    }
+}
+
+void IoUringFileReader::wait_block(int i) {
+    Block& block = blocks_[i];
+    size_t length = 0;
+
+    if (ring_.ok()) {
+        reap_until_ready(i);
+        if (block.result == -EINVAL) {
+            // io_uring, but without IORING_OP_READ (Linux before 5.6).
+            // Every other read fails the same way, so wait those out and
+            // use pread() from now on, starting with this block.
+            for (size_t j = 0; j < blocks_.size(); j++) {
+                reap_until_ready(j);
+            }
+            ring_.tear_down();
+        } else if (block.result < 0) {
+            errno = -block.result;
+            perror("io_uring read failed");
+            exit(EXIT_FAILURE);
+        } else {
+            length = block.result;
+        }
+    }
+
+    // Finish the block with pread(): all of it without io_uring, or
+    // whatever a short read left over.
+    while (length < block.length) {
+        ssize_t result = pread(fd_, block.data + length, block.length - length,
+                               block.offset + length);
+        if (stats_enabled_) {
+            stats_.read_syscalls++;
+        }
+        if (result == -1) {
+            if (errno != EINTR) {
+                perror("pread failed");
+                exit(EXIT_FAILURE);
+            }
+            if (stats_enabled_) {
+                stats_.eintr_retries++;
+            }
+            continue;       // EINTR happened, so do nothing and try again
+        } else if (result == 0) {
+            block.length = length;      // the file shrank since we opened it
+            break;
+        }
+        length += result;
+        if (stats_enabled_) {
+            stats_.bytes_read += result;
+        }
+    }
+    block.state = BLOCK_READY;
+}
+
+void IoUringFileReader::reap_until_ready(int i) {
+    // Collect completions (for any block) until this block's arrives.
+    while (blocks_[i].state == BLOCK_IN_FLIGHT) {
+        count_enters(ring_.submit(1));
+        uint64_t user_data;
+        int result;
+        while (ring_.next_completion(&user_data, &result)) {
+            blocks_[user_data].result = result;
+            blocks_[user_data].state = BLOCK_READY;
+            if (stats_enabled_ && result > 0) {
+                stats_.bytes_read += result;
+            }
+        }
+    }
+}
+
+void IoUringFileReader::next_block() {
+    // We're done with the current block, so reuse it for the next part of
+    // the file that isn't already being read. That's the part right after
+    // the block before it, since blocks are read round robin.
+    // Hand it to the kernel right away, so the queue stays full even when
+    // the next block is ready and we don't wait for it.
+    if (curr_block_ != -1 && blocks_[curr_block_].state == BLOCK_READY) {
+        submit_block(curr_block_);
+        if (ring_.ok()) {
+            count_enters(ring_.submit(0));
+        }
+    }
+
+    buffer_offset_ += curr_length_;
+    curr_length_ = 0;
+    curr_index_ = 0;
+    curr_block_ = (curr_block_ + 1) % blocks_.size();
+
+    Block& block = blocks_[curr_block_];
+    if (block.state == BLOCK_EMPTY) {   // nothing left in the file
+        eof_ = true;
+        good_ = false;
+        return;
+    }
+    uint64_t start_ns = stats_enabled_ ? ReaderStats::now_ns() : 0;
+    wait_block(curr_block_);
+    if (stats_enabled_) {
+        stats_.add_fill(ReaderStats::now_ns() - start_ns);
+    }
+
+    buffer_ = block.data;
+    buffer_offset_ = block.offset;
+    curr_length_ = block.length;
+    eof_ = block.offset + static_cast<off_t>(block.length) >= file_size_;
+    good_ = curr_length_ > 0;
+}
+
+void IoUringFileReader::drain() {
+    if (ring_.ok()) {
+        for (size_t i = 0; i < blocks_.size(); i++) {
+            if (blocks_[i].state == BLOCK_IN_FLIGHT) {
+                wait_block(i);
+            }
+        }
+    }
+    for (Block& block : blocks_) {
+        block.state = BLOCK_EMPTY;
+    }
+}
+
+void IoUringFileReader::count_enters(int calls) {
+    if (stats_enabled_ && calls > 0) {
+        stats_.read_syscalls += calls;
+        stats_.eintr_retries += calls - 1;
+    }
+}
+
+int IoUringFileReader::read_until(const DelimSet& stops, string_view* token) {
+    // If there is no file open currently, then the token is empty.
+    if (this->fd_ == -1) {
+        this->good_ = false;
+        *token = string_view();
+        return EOF;
+    }
+    return TokenScanner::read_until(this, &IoUringFileReader::next_block,
+                                    stops, token);
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef IOURINGFILEREADER_H_
+#define IOURINGFILEREADER_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./DelimSet.h"
+#include "./IoUring.h"
+#include "./ReaderStats.h"
+#include "./TokenScanner.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// An IoUringFileReader is a class for reading files.
+//
+// It has the same interface and the same semantics as BufferedFileReader,
+// but instead of one buffer that is refilled with a blocking read() each
+// time it runs out, it has queue_depth blocks, and keeps a read of the
+// file in flight for every block that isn't being read from. The reads are
+// issued through io_uring, so the storage sees queue_depth requests at
+// once, and the blocks are handed to get_char() and friends in file order
+// as they complete.
+//
+// On kernels without io_uring, or whose io_uring can't do reads (before
+// Linux 5.6), each block is read with pread() when it's needed instead.
+//
+// Like MappedFileReader, the reader works from the file's size at open
+// time, so a file that grows while it is open will not show the new bytes.
+///////////////////////////////////////////////////////////////////////////////
+class IoUringFileReader {
+ public:
+  // Constants
+  static constexpr size_t DEFAULT_BLOCK_SIZE = 64 << 10;
+  static constexpr int DEFAULT_QUEUE_DEPTH = 8;
+  static constexpr size_t BLOCK_ALIGNMENT = 4096;  // each block's alignment.
+
+  // Constructor for an IoUringFileReader. Opens the file and starts
+  // reading the front of it.
+  // Undefined behaviour if the file name is invalid.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  //   NOTE: delims is an optional arguement and is by default
+  //   set to white space characters
+  // - block_size: how many bytes each read is for. Must be > 0.
+  // - queue_depth: how many blocks there are, and so how many reads can
+  //   be in flight at once. Must be > 0.
+  // - use_io_uring: if false, always use the pread() fallback.
+  IoUringFileReader(const string& fname, const string& delims="\r\n\t ",
+                    size_t block_size=DEFAULT_BLOCK_SIZE,
+                    int queue_depth=DEFAULT_QUEUE_DEPTH,
+                    bool use_io_uring=true);
+
+  // Destructor for an IoUringFileReader. Waits for any reads still in
+  // flight, closes the file and frees the blocks.
+  //
+  // Arguments: None
+  ~IoUringFileReader();
+
+  // Sets up the IoUringFileReader to start reading from the
+  // front of the specified file, closing any file already open.
+  // Undefined behaviour if the file name is invalid.
+  //
+  // Arguments:
+  // - fname: The name of the file to be opened
+  void open_file(const string& fname);
+
+  // Closes the file currently managed by the IoUringFileReader.
+  // If there is not a file currently open, then nothing should happen.
+  //
+  // Arguments: None
+  void close_file();
+
+  // Gets the next singular character from the file.
+  // Same as BufferedFileReader::get_char().
+  //
+  // Returns:
+  // - the next char in the file. If at the end of the file,
+  //   or if there is no file open currently, then EOF is returned.
+  char get_char();
+
+  // Reads the next token from the file.
+  // Same as BufferedFileReader::get_token().
+  //
+  // Returns:
+  // - the next token in the file, or the empty string if alrady at EOF.
+  string get_token();
+
+  // Same as BufferedFileReader::get_token_view(). The view is only valid
+  // until the next call that reads from, rewinds, opens or closes the file.
+  //
+  // Returns:
+  // - a view of the next token in the file, or an empty view if already
+  //   at EOF.
+  string_view get_token_view();
+
+  // Reads tokens until a new line is encountered and returns
+  // those tokens in an array, which the caller must delete[].
+  // Same as BufferedFileReader::get_line().
+  //
+  // Returns:
+  // - the array of tokens
+  // - the length of the array, returned through parameter `len`.
+  string* get_line(int* len);
+
+  // Returns the current offset from the start of the file.
+  // Same as BufferedFileReader::tell().
+  // Undefined behaviour if there is no file open currently.
+  off_t tell();
+
+  // Resets the file to start reading from the beginning
+  // of the file that is currently open.
+  // Undefined behaviour if there is no file open currently.
+  void rewind();
+
+  // Returns whether or not the file is available for reading.
+  // Same as BufferedFileReader::good().
+  bool good();
+
+  // Returns whether reads go through io_uring (true) or the pread()
+  // fallback (false).
+  bool using_io_uring() const { return ring_.ok(); }
+
+  // Turns counting ReaderStats on or off. They start off.
+  // Same as BufferedFileReader::enable_stats().
+  // A refill is the wait for the next block; reads of blocks further
+  // ahead are counted as they complete.
+  void enable_stats(bool enable=true) { stats_enabled_ = enable; }
+
+  // Returns what has been counted since the reader was constructed or
+  // reset_stats() was last called.
+  const ReaderStats& stats() const { return stats_; }
+
+  // Zeroes the stats.
+  void reset_stats() { stats_ = ReaderStats(); }
+
+  // Disabling the copy constructor and the assignment operator.
+  IoUringFileReader(const IoUringFileReader& other) = delete;
+  IoUringFileReader& operator=(const IoUringFileReader other) = delete;
+
+ private:
+  friend class TokenScanner;    // reads tokens and lines out of the blocks
+
+  // One of the blocks the file is read into.
+  enum BlockState {
+    BLOCK_EMPTY,      // nothing to read: the file ends before it
+    BLOCK_IN_FLIGHT,  // being read (or, without io_uring, to be read)
+    BLOCK_READY,      // holds its bytes
+  };
+  struct Block {
+    char* data;       // block_size_ bytes, aligned to BLOCK_ALIGNMENT
+    off_t offset;     // the file offset of data[0]
+    size_t length;    // how many bytes of the file belong in data
+    int result;       // what the read returned, once it completes
+    BlockState state;
+  };
+
+  // fields
+  vector<Block> blocks_;  // read round robin, so blocks_[(i + 1) % n]
+                          // always holds the bytes after blocks_[i]
+  size_t block_size_;
+  IoUring ring_;          // not set up if we are using pread()
+  int fd_;                // The File Descriptor that we use to manage our file.
+  off_t file_size_;       // the file's size when it was opened
+  off_t next_offset_;     // the file offset the next block to be read
+                          // should start at
+
+  int curr_block_;        // the block being read from, or -1 for none
+  const char* buffer_;    // that block's data
+  int curr_length_;       // how many bytes buffer_ holds
+  int curr_index_;        // the next byte in buffer_ to read
+  off_t buffer_offset_;   // the file offset of buffer_[0]
+  bool eof_;              // whether buffer_ ends at the end of the file
+
+  string delims_;         // the delimiters used for reading tokens
+  DelimSet token_stops_;  // delims_, plus the byte that reads as EOF
+  DelimSet line_ends_;    // '\n', plus the byte that reads as EOF
+  string scratch_;        // where a token or line that spans two blocks is
+                          // put back together
+  vector<string_view> line_tokens_;  // reused by get_line()
+  bool good_;             // Whether or not the reader is good to read
+  bool stats_enabled_;    // Whether stats_ is being counted
+  ReaderStats stats_;     // see stats()
+
+  // Helpers
+  void start_reads();         // queue a read for every block, from the top
+  void submit_block(int i);   // queue a read of the next part of the file
+  void wait_block(int i);     // wait for block i's read to complete
+  void next_block();          // move on to the next block in the file
+  void reap_until_ready(int i);  // collect completions until block i's is in
+  void drain();               // wait for every read in flight
+  void count_enters(int calls);  // count io_uring_enter() calls in stats_
+  int read_until(const DelimSet& stops, string_view* token);
+};
+
+
+#endif  // IOURINGFILEREADER_H_
@@ -0,0 +1,314 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "./LineIndex.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LINEINDEX_X86 1
+#endif
+
+constexpr size_t LineIndex::BLOCK_SIZE;
+constexpr uint32_t LineIndex::VERSION;
+
+// What a sidecar starts with. The line offsets follow it, as 32-bit
+// integers if the file is small enough for that, or 64-bit ones if not.
+struct SidecarHeader {
+  char magic[4];         // "LIDX"
+  uint32_t version;      // LineIndex::VERSION
+  uint64_t file_size;    // the indexed file's size and modification time,
+  int64_t mtime_sec;     // to tell whether it has changed since
+  int64_t mtime_nsec;
+  uint64_t num_offsets;  // num_lines() + 1
+  uint32_t offset_width;  // 4 or 8 bytes per offset
+  uint32_t unused;
+};
+
+static const char kMagic[4] = { 'L', 'I', 'D', 'X' };
+
+// Reads up to len bytes at offset, retrying after EINTR and short reads.
+// Returns how many bytes were read, which is less than len only at the end
+// of the file.
+static size_t read_at(int fd, char* buf, size_t len, off_t offset) {
+    size_t total = 0;
+
+    while (total < len) {
+        ssize_t result = pread(fd, buf + total, len - total, offset + total);
+        if (result == -1) {
+            if (errno != EINTR) {
+                perror("pread failed");
+                exit(EXIT_FAILURE);
+            }
+            continue;       // EINTR happened, so do nothing and try again
+        } else if (result == 0) {
+            break;
+        }
+        total += result;
+    }
+    return total;
+}
+
+// Writes all len bytes, retrying after EINTR and short writes.
+// Returns false if the write failed.
+static bool write_all(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t result = write(fd, buf, len);
+        if (result == -1) {
+            if (errno != EINTR) {
+                return false;
+            }
+            continue;       // EINTR happened, so do nothing and try again
+        }
+        buf += result;
+        len -= result;
+    }
+    return true;
+}
+
+// Each of these appends the offset just past every '\n' in [p, end) to
+// offsets, where base is the file offset of p, and returns where it
+// stopped: with less than one block left.
+
+#ifdef LINEINDEX_X86
+
+static const char* find_newlines_sse2(const char* p, const char* end,
+                                      uint64_t base, vector<uint64_t>* offsets) {
+    const char* begin = p;
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        while (mask != 0) {
+            offsets->push_back(base + (p - begin) + __builtin_ctz(mask) + 1);
+            mask &= mask - 1;           // clear the lowest set bit
+        }
+    }
+    return p;
+}
+
+__attribute__((target("avx2")))
+static const char* find_newlines_avx2(const char* p, const char* end,
+                                      uint64_t base, vector<uint64_t>* offsets) {
+    const char* begin = p;
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline));
+        while (mask != 0) {
+            offsets->push_back(base + (p - begin) + __builtin_ctz(mask) + 1);
+            mask &= mask - 1;           // clear the lowest set bit
+        }
+    }
+    return p;
+}
+
+static bool have_avx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#endif  // LINEINDEX_X86
+
+// Appends the offset just past every '\n' in [p, end) to offsets, where
+// base is the file offset of p.
+static void find_newlines(const char* p, const char* end, uint64_t base,
+                          vector<uint64_t>* offsets) {
+    const char* begin = p;
+#ifdef LINEINDEX_X86
+    if (have_avx2()) {
+        p = find_newlines_avx2(p, end, base, offsets);
+    }
+    p = find_newlines_sse2(p, end, base + (p - begin), offsets);
+#endif  // LINEINDEX_X86
+    for (; p < end; p++) {
+        if (*p == '\n') {
+            offsets->push_back(base + (p - begin) + 1);
+        }
+    }
+}
+
+LineIndex::LineIndex(const string& fname, bool use_sidecar) {
+    struct stat st;
+
+    this->fd_ = open(fname.c_str(), O_RDONLY);
+    if (this->fd_ == -1) {
+        perror("open failed");
+        exit(EXIT_FAILURE);
+    }
+    if (fstat(this->fd_, &st) == -1) {
+        perror("fstat failed");
+        exit(EXIT_FAILURE);
+    }
+
+    this->from_sidecar_ = false;
+    if (use_sidecar && load_sidecar(sidecar_name(fname), st)) {
+        this->from_sidecar_ = true;
+        return;
+    }
+    build();
+    if (use_sidecar) {
+        save_sidecar(sidecar_name(fname), st);
+    }
+}
+
+LineIndex::~LineIndex() {
+    close(this->fd_);
+}
+
+string LineIndex::sidecar_name(const string& fname) {
+    return fname + ".lidx";
+}
+
+void LineIndex::seek_to_line(BufferedFileReader* reader, size_t i) const {
+    reader->seek(line_start(i));
+}
+
+string LineIndex::get_lines(size_t first, size_t count) {
+    size_t last = std::min(first + count, num_lines());
+    if (first >= last) {
+        return string();
+    }
+
+    string lines(line_start(last) - line_start(first), '\0');
+    lines.resize(read_at(this->fd_, &lines[0], lines.size(),
+                         line_start(first)));
+    return lines;
+}
+
+void LineIndex::build() {
+    vector<char> buf(BLOCK_SIZE);
+    uint64_t offset = 0;
+
+    // One pass, front to back, so tell the kernel to read ahead.
+    posix_fadvise(this->fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    this->offsets_.clear();
+    this->offsets_.push_back(0);
+    while (true) {
+        size_t len = read_at(this->fd_, buf.data(), BLOCK_SIZE, offset);
+        if (len == 0) {
+            break;
+        }
+        find_newlines(buf.data(), buf.data() + len, offset, &this->offsets_);
+        offset += len;
+    }
+
+    // The offset past a '\n' at the very end of the file is already there
+    // to mark the end; otherwise the last line ends at the end of the file.
+    if (this->offsets_.back() != offset) {
+        this->offsets_.push_back(offset);
+    }
+}
+
+bool LineIndex::load_sidecar(const string& name, const struct stat& st) {
+    SidecarHeader header;
+    struct stat sidecar_st;
+
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;                   // not indexed yet
+    }
+
+    // Anything that doesn't describe the file as it is now is ignored,
+    // and the file is indexed again.
+    bool ok = fstat(fd, &sidecar_st) == 0 &&
+              read_at(fd, reinterpret_cast<char*>(&header), sizeof(header), 0)
+                  == sizeof(header) &&
+              memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+              header.version == VERSION &&
+              header.file_size == static_cast<uint64_t>(st.st_size) &&
+              header.mtime_sec == st.st_mtim.tv_sec &&
+              header.mtime_nsec == st.st_mtim.tv_nsec &&
+              (header.offset_width == 4 || header.offset_width == 8) &&
+              header.num_offsets > 0 &&
+              static_cast<uint64_t>(sidecar_st.st_size) ==
+                  sizeof(header) + header.num_offsets * header.offset_width;
+    if (!ok) {
+        close(fd);
+        return false;
+    }
+
+    this->offsets_.resize(header.num_offsets);
+    if (header.offset_width == 8) {
+        size_t len = header.num_offsets * sizeof(uint64_t);
+        ok = read_at(fd, reinterpret_cast<char*>(this->offsets_.data()), len,
+                     sizeof(header)) == len;
+    } else {
+        vector<uint32_t> narrow(header.num_offsets);
+        size_t len = header.num_offsets * sizeof(uint32_t);
+        ok = read_at(fd, reinterpret_cast<char*>(narrow.data()), len,
+                     sizeof(header)) == len;
+        std::copy(narrow.begin(), narrow.end(), this->offsets_.begin());
+    }
+    close(fd);
+
+    ok = ok && this->offsets_.front() == 0 &&
+         this->offsets_.back() == static_cast<uint64_t>(st.st_size);
+    if (!ok) {
+        this->offsets_.clear();
+    }
+    return ok;
+}
+
+void LineIndex::save_sidecar(const string& name, const struct stat& st) {
+    SidecarHeader header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = VERSION;
+    header.file_size = st.st_size;
+    header.mtime_sec = st.st_mtim.tv_sec;
+    header.mtime_nsec = st.st_mtim.tv_nsec;
+    header.num_offsets = this->offsets_.size();
+    header.offset_width = this->offsets_.back() <= UINT32_MAX ? 4 : 8;
+
+    // If the file changed while we were reading it, the index may not
+    // match what it is now, so don't save it.
+    if (this->offsets_.back() != static_cast<uint64_t>(st.st_size)) {
+        return;
+    }
+
+    // Write a temporary file and rename it into place, so a reader never
+    // sees half a sidecar. The sidecar is only a cache, so if it can't be
+    // written, the index just isn't saved.
+    string tmp_name = name + "." + std::to_string(getpid()) + ".tmp";
+    int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        return;
+    }
+    bool ok = write_all(fd, reinterpret_cast<const char*>(&header),
+                        sizeof(header));
+    if (header.offset_width == 8) {
+        ok = ok && write_all(fd,
+                             reinterpret_cast<const char*>(this->offsets_.data()),
+                             this->offsets_.size() * sizeof(uint64_t));
+    } else {
+        vector<uint32_t> narrow(this->offsets_.begin(), this->offsets_.end());
+        ok = ok && write_all(fd, reinterpret_cast<const char*>(narrow.data()),
+                             narrow.size() * sizeof(uint32_t));
+    }
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmp_name.c_str(), name.c_str()) == -1) {
+        unlink(tmp_name.c_str());
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef LINEINDEX_H_
+#define LINEINDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#include "./BufferedFileReader.h"
+
+using std::string;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// A LineIndex knows where every line of a file starts, so any line (or run
+// of lines) can be read without scanning the file up to it.
+//
+// Building the index is one pass over the file, finding newlines 16 or 32
+// bytes at a time with SIMD. The result is saved next to the file in a
+// sidecar (see sidecar_name()), along with the file's size and
+// modification time, and later LineIndexes for the same file load the
+// sidecar instead of scanning, unless the file has changed since.
+//
+// Line i starts at offset 0 or just past the i-th '\n'. A file that ends
+// without a '\n' has one more line, the bytes after the last '\n'; an
+// empty file has no lines.
+///////////////////////////////////////////////////////////////////////////////
+class LineIndex {
+ public:
+  // How many bytes the indexing pass reads at a time.
+  static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+  // The sidecar's format version. Sidecars of any other version are
+  // rebuilt.
+  static constexpr uint32_t VERSION = 1;
+
+  // Constructor for a LineIndex. Opens the file, then loads its sidecar,
+  // or, if there is none or it is out of date, indexes the file and
+  // writes a new one.
+  // Undefined behaviour if the file name is invalid.
+  //
+  // Arguments:
+  // - fname: The name of the file to index
+  // - use_sidecar: if false, always index the file, and leave any sidecar
+  //   alone. A sidecar that can't be written (say, in a read-only
+  //   directory) is skipped the same way.
+  explicit LineIndex(const string& fname, bool use_sidecar=true);
+
+  // Destructor for a LineIndex. Closes the file.
+  ~LineIndex();
+
+  // Returns the name of the sidecar that holds fname's index.
+  static string sidecar_name(const string& fname);
+
+  // Returns how many lines the file has.
+  size_t num_lines() const { return offsets_.size() - 1; }
+
+  // Returns the offset of the first byte of line i. line_start(num_lines())
+  // is the size of the file.
+  off_t line_start(size_t i) const { return offsets_[i]; }
+
+  // Returns whether the index was loaded from the sidecar (true) or built
+  // by scanning the file (false).
+  bool from_sidecar() const { return from_sidecar_; }
+
+  // Moves reader to the start of line i, so its next get_line() returns
+  // that line. The reader must have the same file open.
+  //
+  // Arguments:
+  // - reader: the reader to move
+  // - i: the line to move to. Must be <= num_lines().
+  void seek_to_line(BufferedFileReader* reader, size_t i) const;
+
+  // Reads lines [first, first + count) of the file with a single pread(),
+  // and returns them as they are in the file, newlines included. Lines
+  // past the end of the file are left out.
+  //
+  // Arguments:
+  // - first: the first line to read
+  // - count: how many lines to read
+  string get_lines(size_t first, size_t count);
+
+  // Disabling the copy constructor and the assignment operator.
+  LineIndex(const LineIndex& other) = delete;
+  LineIndex& operator=(const LineIndex other) = delete;
+
+ private:
+  // fields
+  int fd_;                 // The File Descriptor that we use to manage our file.
+  vector<uint64_t> offsets_;  // where each line starts, then the file size
+  bool from_sidecar_;      // whether offsets_ came from the sidecar
+
+  // Helpers
+  void build();            // fill offsets_ by scanning the file
+  bool load_sidecar(const string& name, const struct stat& st);
+  void save_sidecar(const string& name, const struct stat& st);
+};
+
+
+#endif  // LINEINDEX_H_
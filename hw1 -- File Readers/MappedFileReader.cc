@@ -0,0 +1,220 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "./MappedFileReader.h"
+
+using std::vector;
+
+MappedFileReader::MappedFileReader(const string& fname, const string& delims) {
+    this->fd_ = -1;
+    this->data_ = nullptr;
+    this->stats_enabled_ = false;
+    this->stats_ = ReaderStats();
+    this->delims_ = delims;
+    this->token_stops_ = DelimSet(delims);
+    this->token_stops_.add(EOF);
+    this->line_stops_ = this->token_stops_;
+    this->line_stops_.add('\n');
+    open_file(fname);
+}
+
+MappedFileReader::~MappedFileReader() {
+    close_file();
+}
+
+void MappedFileReader::open_file(const string& fname) {
+    struct stat st;
+
+    //if the object is already managing a file, that file is closed.
+    if (this->fd_ != -1) {
+        close_file();
+    }
+    this->fd_ = open(fname.c_str(), O_RDONLY);
+    if (this->fd_ == -1) {
+        perror("open failed");
+        this->good_ = false;                  // no file open
+        exit(EXIT_FAILURE);
+    }
+    if (fstat(this->fd_, &st) == -1) {
+        perror("fstat failed");
+        exit(EXIT_FAILURE);
+    }
+    this->size_ = st.st_size;
+    this->pos_ = 0;
+    this->line_offset_ = 0;
+    this->line_number_ = 0;
+    this->good_ = true;
+
+    // mmap rejects zero-length mappings, so an empty file has no mapping
+    // and every read is simply at EOF.
+    if (this->size_ == 0) {
+        this->data_ = nullptr;
+        return;
+    }
+    uint64_t start_ns = stats_enabled_ ? ReaderStats::now_ns() : 0;
+    void* addr = mmap(nullptr, this->size_, PROT_READ, MAP_PRIVATE, this->fd_, 0);
+    if (addr == MAP_FAILED) {
+        perror("mmap failed");
+        exit(EXIT_FAILURE);
+    }
+    this->data_ = static_cast<const char*>(addr);
+
+    // We read front to back, so ask for aggressive readahead and let the
+    // kernel drop pages behind us early.
+    madvise(addr, this->size_, MADV_SEQUENTIAL);
+    madvise(addr, this->size_, MADV_WILLNEED);
+    if (stats_enabled_) {
+        stats_.bytes_read += this->size_;
+        stats_.add_fill(ReaderStats::now_ns() - start_ns);
+    }
+}
+
+void MappedFileReader::close_file() {
+    if (this->data_ != nullptr) {
+        munmap(const_cast<char*>(this->data_), this->size_);
+        this->data_ = nullptr;
+    }
+    if (this->fd_ != -1) {
+        close(this->fd_);
+    }
+    this->fd_ = -1;                     // indicates no file open
+    this->good_ = false;                // no file open
+    this->size_ = 0;
+    this->pos_ = 0;
+    this->line_offset_ = 0;
+    this->line_number_ = 0;
+}
+
+char MappedFileReader::get_char() {
+    // Never touch the mapping at or past size_: the bytes after the end of
+    // the file in the last page are zero, and pages past that would fault.
+    if (this->pos_ >= this->size_) {
+        this->good_ = false;
+        return EOF;
+    }
+    return this->data_[this->pos_++];
+}
+
+string MappedFileReader::get_token() {
+    // Find the end of the token in place, then copy it out in one go.
+    size_t start = this->pos_;
+    scan_token(false);
+    string token(this->data_ + start, this->pos_ - start);
+
+    if (this->pos_ == this->size_) {
+        this->good_ = false;            // ran into the end of the file
+    } else {
+        this->pos_++;                   // consume the delimiter
+    }
+    if (stats_enabled_) {
+        stats_.tokens++;
+    }
+    return token;
+}
+
+string* MappedFileReader::get_line(int* len) {
+    vector<string> line;
+
+    while (true) {
+        size_t start = this->pos_;
+        scan_token(true);
+        line.emplace_back(this->data_ + start, this->pos_ - start);
+
+        if (this->pos_ == this->size_) {
+            this->good_ = false;        // ran into the end of the file
+            break;
+        }
+        char c = this->data_[this->pos_++];
+        if (c == '\n' || c == EOF) {
+            break;
+        }
+    }
+
+    if (stats_enabled_) {
+        stats_.tokens += line.size();
+        stats_.lines++;
+    }
+
+    *len = line.size();
+    string* token_line = new string[*len + 1];
+    for (int i = 0; i < *len; i++) {
+        token_line[i] = std::move(line[i]);
+    }
+    return token_line;
+}
+
+bool MappedFileReader::find_next(const string& pattern, bool case_insensitive,
+                                 SearchMatch* match) {
+    SubstringFinder finder(pattern, case_insensitive);
+
+    if (this->pos_ >= this->size_ || finder.size() == 0) {
+        this->good_ = false;
+        return false;
+    }
+    const char* end = this->data_ + this->size_;
+    const char* hit = finder.find(this->data_ + this->pos_, end);
+    if (hit == end) {
+        this->pos_ = this->size_;
+        this->good_ = false;
+        return false;
+    }
+
+    // Count the lines up to the match, from wherever the last count got to.
+    size_t offset = hit - this->data_;
+    this->line_number_ += SubstringFinder::count_newlines(
+                              this->data_ + this->line_offset_, hit);
+    this->line_offset_ = offset;
+    match->offset = offset;
+    match->line = this->line_number_;
+    this->pos_ = offset + finder.size();
+    return true;
+}
+
+off_t MappedFileReader::tell() {
+    return this->pos_;
+}
+
+void MappedFileReader::rewind() {
+    // If there is no file open currently, then exit
+    if (this->fd_ == -1) {
+        this->good_ = false;
+        exit(EXIT_FAILURE);
+    }
+    this->pos_ = 0;
+    this->line_offset_ = 0;
+    this->line_number_ = 0;
+    this->good_ = true;
+}
+
+bool MappedFileReader::good() {
+    return this->good_;
+}
+
+void MappedFileReader::scan_token(bool stop_at_newline) {
+    // A byte that reads as EOF ends a token, just as the EOF returned by
+    // get_char() does in BufferedFileReader.
+    const DelimSet& stops = stop_at_newline ? line_stops_ : token_stops_;
+    if (this->pos_ < this->size_) {
+        const char* stop = stops.find(this->data_ + this->pos_,
+                                      this->data_ + this->size_);
+        this->pos_ = stop - this->data_;
+    }
+}
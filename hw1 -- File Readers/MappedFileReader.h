@@ -0,0 +1,154 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef MAPPEDFILEREADER_H_
+#define MAPPEDFILEREADER_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <string>
+
+#include "./DelimSet.h"
+#include "./ReaderStats.h"
+#include "./SubstringFinder.h"
+
+using std::string;
+
+///////////////////////////////////////////////////////////////////////////////
+// A MappedFileReader is a class for reading files.
+//
+// It has the same interface and the same semantics as BufferedFileReader,
+// but instead of copying the file into a buffer with read(), it maps the
+// whole file into memory with mmap() and reads straight out of the page
+// cache. There are no read() syscalls and no copies; the kernel pages the
+// file in on demand (and is told to read ahead, since we read sequentially).
+//
+// Because the mapping is a snapshot of the file's size at open time,
+// a file that grows while it is open will not show the new bytes.
+///////////////////////////////////////////////////////////////////////////////
+class MappedFileReader {
+ public:
+  // Constructor for a MappedFileReader. Opens and maps the file.
+  // After construction, reading from the file should start
+  // at the front of the file.
+  // Undefined behaviour if the file name is invalid.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  //   NOTE: delims is an optional arguement and is by default
+  //   set to white space characters
+  MappedFileReader(const string& fname, const string& delims="\r\n\t ");
+
+  // Destructor for a MappedFileReader. Unmaps and closes the file.
+  //
+  // Arguments: None
+  ~MappedFileReader();
+
+  // Sets up the MappedFileReader to start reading from the
+  // front of the specified file, closing any file already open.
+  // Undefined behaviour if the file name is invalid.
+  //
+  // Arguments:
+  // - fname: The name of the file to be opened
+  void open_file(const string& fname);
+
+  // Closes the file currently managed by the MappedFileReader.
+  // If there is not a file currently open, then nothing should happen.
+  //
+  // Arguments: None
+  void close_file();
+
+  // Gets the next singular character from the file.
+  // Same as BufferedFileReader::get_char().
+  //
+  // Returns:
+  // - the next char in the file. If at the end of the file,
+  //   or if there is no file open currently, then EOF is returned.
+  char get_char();
+
+  // Reads the next token from the file.
+  // Same as BufferedFileReader::get_token().
+  //
+  // Returns:
+  // - the next token in the file, or the empty string if alrady at EOF.
+  string get_token();
+
+  // Reads tokens until a new line is encountered and returns
+  // those tokens in an array, which the caller must delete[].
+  // Same as BufferedFileReader::get_line().
+  //
+  // Returns:
+  // - the array of tokens
+  // - the length of the array, returned through parameter `len`.
+  string* get_line(int* len);
+
+  // Searches the rest of the file for the next occurrence of pattern.
+  // Same as BufferedFileReader::find_next(), except that the whole file is
+  // already in memory, so it is searched in one go.
+  bool find_next(const string& pattern, bool case_insensitive,
+                 SearchMatch* match);
+
+  // Returns the current offset from the start of the file.
+  // Same as BufferedFileReader::tell().
+  // Undefined behaviour if there is no file open currently.
+  off_t tell();
+
+  // Resets the file to start reading from the beginning
+  // of the file that is currently open.
+  // Undefined behaviour if there is no file open currently.
+  void rewind();
+
+  // Returns whether or not the file is available for reading.
+  // Same as BufferedFileReader::good().
+  bool good();
+
+  // Turns counting ReaderStats on or off. They start off.
+  // Same as BufferedFileReader::enable_stats().
+  // There are no read() calls: mapping the file counts as one refill of
+  // the whole file, and the page faults that really read it aren't seen.
+  void enable_stats(bool enable=true) { stats_enabled_ = enable; }
+
+  // Returns what has been counted since the reader was constructed or
+  // reset_stats() was last called.
+  const ReaderStats& stats() const { return stats_; }
+
+  // Zeroes the stats.
+  void reset_stats() { stats_ = ReaderStats(); }
+
+  // Disabling the copy constructor and the assignment operator.
+  MappedFileReader(const MappedFileReader& other) = delete;
+  MappedFileReader& operator=(const MappedFileReader other) = delete;
+
+ private:
+  // fields
+  const char* data_;  // The start of the mapping, or nullptr if the
+                      // file is empty (mmap can't map 0 bytes)
+  size_t size_;       // The length of the file (and of the mapping)
+  size_t pos_;        // The offset of the next character to read
+  int fd_;            // The File Descriptor that we use to manage our file.
+  string delims_;     // the delimiters used for reading tokens
+  DelimSet token_stops_;  // delims_, plus the byte that reads as EOF
+  DelimSet line_stops_;   // token_stops_ plus '\n'
+  bool good_;         // Whether or not the reader is good to read
+  bool stats_enabled_;  // Whether stats_ is being counted
+  ReaderStats stats_;   // see stats()
+  size_t line_offset_;    // find_next() has counted line_number_ '\n's
+  uint64_t line_number_;  // before this offset
+
+  // Helpers
+  void scan_token(bool stop_at_newline);  // advance pos_ to the next
+                                          // delimiter (or EOF)
+};
+
+
+#endif  // MAPPEDFILEREADER_H_
@@ -0,0 +1,220 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+#include "./ParallelTokenizer.h"
+
+constexpr size_t ParallelTokenizer::BLOCK_SIZE;
+
+ParallelTokenizer::ParallelTokenizer(const string& fname, const string& delims,
+                                     int num_chunks) {
+    struct stat st;
+
+    this->delims_ = delims;
+    this->stops_ = DelimSet(delims);
+    this->stops_.add(EOF);              // ends a token, as in get_token()
+
+    this->fd_ = open(fname.c_str(), O_RDONLY);
+    if (this->fd_ == -1) {
+        perror("open failed");
+        exit(EXIT_FAILURE);
+    }
+    if (fstat(this->fd_, &st) == -1) {
+        perror("fstat failed");
+        exit(EXIT_FAILURE);
+    }
+    this->file_size_ = st.st_size;
+
+    // Cut the file evenly, then move each cut past the next stop byte, so
+    // every chunk but the last ends with one. A cut can't move back past
+    // the one before it, so a long run without stops makes empty chunks.
+    this->bounds_.resize(num_chunks + 1);
+    this->bounds_[0] = 0;
+    for (int i = 1; i < num_chunks; i++) {
+        off_t cut = this->file_size_ * i / num_chunks;
+        off_t boundary = find_boundary(cut > 0 ? cut - 1 : 0);
+        this->bounds_[i] = std::max(boundary, this->bounds_[i - 1]);
+    }
+    this->bounds_[num_chunks] = this->file_size_;
+
+    this->last_chunk_ = 0;
+    while (this->bounds_[this->last_chunk_ + 1] != this->file_size_) {
+        this->last_chunk_++;
+    }
+}
+
+ParallelTokenizer::~ParallelTokenizer() {
+    close(this->fd_);
+}
+
+void ParallelTokenizer::for_each_token(const TokenFn& fn) {
+    vector<std::thread> threads;
+    for (int i = 0; i < num_chunks(); i++) {
+        threads.emplace_back(&ParallelTokenizer::tokenize_chunk, this, i,
+                             std::cref(fn));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+vector<string> ParallelTokenizer::tokens() {
+    // Each thread only touches its own chunk's vector, so no locking.
+    vector<vector<string>> chunk_tokens(num_chunks());
+    for_each_token([&chunk_tokens](int chunk, string_view token) {
+        chunk_tokens[chunk].emplace_back(token);
+    });
+
+    size_t total = 0;
+    for (const vector<string>& tokens : chunk_tokens) {
+        total += tokens.size();
+    }
+    vector<string> result;
+    result.reserve(total);
+    for (vector<string>& tokens : chunk_tokens) {
+        std::move(tokens.begin(), tokens.end(), std::back_inserter(result));
+    }
+    return result;
+}
+
+unordered_map<string, size_t> ParallelTokenizer::count_tokens() {
+    // Each thread counts into a map and key of its own, local to it, so
+    // no two threads write to neighbouring memory for every token; the
+    // maps only meet when they're merged at the end.
+    vector<unordered_map<string, size_t>> chunk_counts(num_chunks());
+    vector<std::thread> threads;
+    for (int i = 0; i < num_chunks(); i++) {
+        threads.emplace_back([this, i, &chunk_counts]() {
+            unordered_map<string, size_t> counts;
+            string key;                 // reused, so only new tokens allocate
+            tokenize_chunk(i, [&counts, &key](int chunk, string_view token) {
+                key.assign(token.data(), token.size());
+                counts[key]++;
+            });
+            chunk_counts[i] = std::move(counts);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // Merge into the biggest map, so the fewest entries are copied.
+    auto biggest = std::max_element(
+        chunk_counts.begin(), chunk_counts.end(),
+        [](const unordered_map<string, size_t>& a,
+           const unordered_map<string, size_t>& b) {
+            return a.size() < b.size();
+        });
+    unordered_map<string, size_t> result = std::move(*biggest);
+    for (auto it = chunk_counts.begin(); it != chunk_counts.end(); ++it) {
+        if (it == biggest) {
+            continue;
+        }
+        for (const auto& count : *it) {
+            result[count.first] += count.second;
+        }
+    }
+    return result;
+}
+
+off_t ParallelTokenizer::find_boundary(off_t offset) {
+    char buf[4096];
+
+    while (offset < this->file_size_) {
+        size_t len = read_at(buf, std::min(static_cast<off_t>(sizeof(buf)),
+                                           this->file_size_ - offset), offset);
+        if (len == 0) {
+            break;                      // the file shrank since we opened it
+        }
+        const char* stop = this->stops_.find(buf, buf + len);
+        if (stop != buf + len) {
+            return offset + (stop - buf) + 1;
+        }
+        offset += len;
+    }
+    return this->file_size_;
+}
+
+void ParallelTokenizer::tokenize_chunk(int i, const TokenFn& fn) {
+    vector<char> buf(BLOCK_SIZE);
+    string scratch;                     // a token that spans two blocks
+    bool stitched = false;              // whether scratch holds one
+
+    off_t offset = this->bounds_[i];
+    off_t end = this->bounds_[i + 1];
+    while (offset < end) {
+        size_t len = read_at(buf.data(), std::min(static_cast<off_t>(BLOCK_SIZE),
+                                                  end - offset), offset);
+        if (len == 0) {
+            break;                      // the file shrank since we opened it
+        }
+        offset += len;
+
+        const char* p = buf.data();
+        const char* block_end = p + len;
+        while (true) {
+            const char* stop = this->stops_.find(p, block_end);
+            if (stop == block_end) {    // the token goes on into the next block
+                scratch.append(p, stop - p);
+                stitched = true;
+                break;
+            }
+            if (stitched) {
+                scratch.append(p, stop - p);
+                fn(i, scratch);
+                scratch.clear();
+                stitched = false;
+            } else {
+                fn(i, string_view(p, stop - p));
+            }
+            p = stop + 1;
+        }
+    }
+
+    // Every other chunk ends with a stop byte, so only the end of the
+    // file has a token left over. As with get_token(), it may be empty,
+    // unless the whole file is.
+    if (i == this->last_chunk_ && this->file_size_ > 0) {
+        fn(i, scratch);
+    }
+}
+
+size_t ParallelTokenizer::read_at(char* buf, size_t len, off_t offset) {
+    size_t total = 0;
+
+    while (total < len) {
+        ssize_t result = pread(this->fd_, buf + total, len - total,
+                               offset + total);
+        if (result == -1) {
+            if (errno != EINTR) {
+                perror("pread failed");
+                exit(EXIT_FAILURE);
+            }
+            continue;       // EINTR happened, so do nothing and try again
+        } else if (result == 0) {
+            break;
+        }
+        total += result;
+    }
+    return total;
+}
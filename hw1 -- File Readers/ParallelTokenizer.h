@@ -0,0 +1,117 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef PARALLELTOKENIZER_H_
+#define PARALLELTOKENIZER_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "./DelimSet.h"
+
+using std::string;
+using std::string_view;
+using std::unordered_map;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// A ParallelTokenizer splits a file into tokens on several threads.
+//
+// The file is cut into num_chunks byte ranges ("chunks") of about the same
+// size, and each cut is moved forward to just past the next delimiter, so
+// no token is split between two chunks. Each chunk is then tokenized on its
+// own thread, reading its range with pread().
+//
+// The tokens are exactly the ones BufferedFileReader::get_token() returns
+// for the same file and delimiters, including empty ones. tokens() returns
+// them in file order; count_tokens() merges the per-thread counts into one
+// unordered total; for_each_token() hands them to a callback.
+//
+// Like MappedFileReader, the tokenizer works from the file's size when it
+// was opened.
+///////////////////////////////////////////////////////////////////////////////
+class ParallelTokenizer {
+ public:
+  // How many bytes each thread reads at a time.
+  static constexpr size_t BLOCK_SIZE = 64 << 10;
+
+  // Called with each token, and the chunk it is in. The token is only
+  // valid until the callback returns.
+  typedef std::function<void(int chunk, string_view token)> TokenFn;
+
+  // Constructor for a ParallelTokenizer. Opens the file and works out
+  // where the chunks are.
+  // Undefined behaviour if the file name is invalid.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: a string containing all of the characters to
+  //   be used as delimiters for reading tokens.
+  //   NOTE: delims is an optional arguement and is by default
+  //   set to white space characters
+  // - num_chunks: how many chunks (and so threads) to split the file
+  //   into. Must be > 0. Small files can end up with empty chunks.
+  ParallelTokenizer(const string& fname, const string& delims="\r\n\t ",
+                    int num_chunks=1);
+
+  // Destructor for a ParallelTokenizer. Closes the file.
+  ~ParallelTokenizer();
+
+  // Returns how many chunks the file was split into.
+  int num_chunks() const { return bounds_.size() - 1; }
+
+  // Returns the file offset chunk i starts at. Chunk i ends where chunk
+  // i + 1 starts, and chunk_start(num_chunks()) is the size of the file.
+  off_t chunk_start(int i) const { return bounds_[i]; }
+
+  // Tokenizes every chunk at once, each on its own thread, and calls fn
+  // with each token. Calls for the same chunk happen in file order, on one
+  // thread; calls for different chunks happen at the same time, so fn
+  // must be safe to call from several threads.
+  //
+  // Arguments:
+  // - fn: what to call with each token
+  void for_each_token(const TokenFn& fn);
+
+  // Returns every token in the file, in file order.
+  vector<string> tokens();
+
+  // Returns how many times each token appears in the file.
+  unordered_map<string, size_t> count_tokens();
+
+  // Disabling the copy constructor and the assignment operator.
+  ParallelTokenizer(const ParallelTokenizer& other) = delete;
+  ParallelTokenizer& operator=(const ParallelTokenizer other) = delete;
+
+ private:
+  // fields
+  int fd_;               // The File Descriptor that we use to manage our file.
+  off_t file_size_;      // the file's size when it was opened
+  string delims_;        // the delimiters used for reading tokens
+  DelimSet stops_;       // delims_, plus the byte that reads as EOF
+  vector<off_t> bounds_;  // where each chunk starts, then the file size
+  int last_chunk_;       // the chunk that ends the file, which also gets
+                         // the token after the last delimiter
+
+  // Helpers
+  off_t find_boundary(off_t offset);  // the offset just past the first
+                                      // stop byte at or after offset
+  void tokenize_chunk(int i, const TokenFn& fn);
+  size_t read_at(char* buf, size_t len, off_t offset);
+};
+
+
+#endif  // PARALLELTOKENIZER_H_
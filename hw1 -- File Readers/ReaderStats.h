@@ -0,0 +1,52 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef READERSTATS_H_
+#define READERSTATS_H_
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// ReaderStats is what a reader counts about its own work, when asked to
+// with enable_stats(): how often it went to the kernel and for how much,
+// how long its refills took, and how much it handed back to the caller.
+//
+// Comparing fill_ns to the total time spent reading tells whether a job is
+// waiting on I/O or on parsing. Everything is counted per system call,
+// per refill or per token, never per byte, so the stats are cheap enough
+// to leave on. They are plain counters, meant to be read by the thread
+// that reads the file.
+///////////////////////////////////////////////////////////////////////////////
+struct ReaderStats {
+  uint64_t read_syscalls;  // read(), pread() and io_uring_enter() calls
+  uint64_t bytes_read;     // bytes those calls brought in
+  uint64_t eintr_retries;  // calls that were interrupted and retried
+  uint64_t fills;          // times the reader refilled its buffer
+  uint64_t fill_ns;        // time spent refilling, in total
+  uint64_t max_fill_ns;    // the longest single refill
+  uint64_t tokens;         // tokens handed out, including by get_line()
+  uint64_t lines;          // lines handed out
+
+  // Counts one refill that took ns nanoseconds.
+  void add_fill(uint64_t ns) {
+    fills++;
+    fill_ns += ns;
+    if (ns > max_fill_ns) {
+      max_fill_ns = ns;
+    }
+  }
+
+  // Returns a monotonic time in nanoseconds, for timing refills.
+  static uint64_t now_ns();
+};
+
+
+#endif  // READERSTATS_H_
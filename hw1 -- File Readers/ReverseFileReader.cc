@@ -0,0 +1,229 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include "./ReverseFileReader.h"
+
+constexpr size_t ReverseFileReader::BUF_SIZE;
+constexpr size_t ReverseFileReader::BUF_ALIGNMENT;
+
+ReverseFileReader::ReverseFileReader(const string& fname, const string& delims,
+                                     size_t buf_size) {
+    void* buf;
+
+    this->fd_ = -1;                     // no file open yet
+    this->good_ = false;
+    this->token_stops_ = DelimSet(delims);
+    this->token_stops_.add(EOF);
+    this->line_ends_ = DelimSet("\n");
+    this->line_ends_.add(EOF);
+    if (posix_memalign(&buf, BUF_ALIGNMENT, buf_size) != 0) {
+        perror("posix_memalign failed");
+        exit(EXIT_FAILURE);
+    }
+    this->buffer_ = static_cast<char*>(buf);
+    this->capacity_ = buf_size;
+    this->buffer_offset_ = 0;
+    this->curr_length_ = 0;
+    this->pos_ = 0;
+    this->file_size_ = 0;
+    this->stats_enabled_ = false;
+    this->stats_ = ReaderStats();
+    open_file(fname);
+}
+
+ReverseFileReader::~ReverseFileReader() {
+    close_file();
+    free(this->buffer_);
+    this->buffer_ = nullptr;
+}
+
+void ReverseFileReader::open_file(const string& fname) {
+    struct stat st;
+
+    //if the object is already managing a file, that file is closed.
+    if (this->fd_ != -1) {
+        close_file();
+    }
+    this->fd_ = open(fname.c_str(), O_RDONLY);
+    if (this->fd_ == -1) {
+        perror("open failed");
+        exit(EXIT_FAILURE);
+    }
+    if (fstat(this->fd_, &st) == -1) {
+        perror("fstat failed");
+        exit(EXIT_FAILURE);
+    }
+    // We go through the file back to front, so the kernel's readahead,
+    // which guesses forward, would only fetch what we've already read.
+    posix_fadvise(this->fd_, 0, 0, POSIX_FADV_RANDOM);
+
+    this->file_size_ = st.st_size;
+    rewind();
+}
+
+void ReverseFileReader::close_file() {
+    if (this->fd_ == -1) {
+        return;
+    }
+    close(this->fd_);
+    this->fd_ = -1;                     // indicates no file open
+    this->good_ = false;
+    this->file_size_ = 0;
+    this->pos_ = 0;
+    this->curr_length_ = 0;
+}
+
+char ReverseFileReader::prev_char() {
+    if (this->fd_ == -1 || pos_ == 0) {
+        this->good_ = false;
+        return EOF;
+    }
+    // The block holding the byte before pos_ may be gone if the file
+    // shrank after we opened it; then there is nothing left to read.
+    while (pos_ > 0 &&
+           !(buffer_offset_ < pos_ &&
+             pos_ <= buffer_offset_ + static_cast<off_t>(curr_length_))) {
+        fill_block();
+    }
+    if (pos_ == 0) {
+        this->good_ = false;
+        return EOF;
+    }
+    pos_--;
+    return buffer_[pos_ - buffer_offset_];
+}
+
+string ReverseFileReader::prev_token() {
+    read_back_until(token_stops_);
+    if (stats_enabled_) {
+        stats_.tokens++;
+    }
+    return scratch_;
+}
+
+string ReverseFileReader::prev_line() {
+    // A '\n' that ends the file ends the last line, so step over it.
+    if (pos_ == file_size_ && pos_ > 0) {
+        off_t end = pos_;
+        if (prev_char() != '\n' && pos_ == end - 1) {
+            pos_ = end;
+        }
+    }
+    read_back_until(line_ends_);
+    if (stats_enabled_) {
+        stats_.lines++;
+    }
+    return scratch_;
+}
+
+void ReverseFileReader::prev_line(vector<string>* tokens) {
+    string line = prev_line();
+
+    TokenScanner::split_line(token_stops_, line, tokens);
+    if (stats_enabled_) {
+        stats_.tokens += tokens->size();
+    }
+}
+
+off_t ReverseFileReader::tell() {
+    return pos_;
+}
+
+void ReverseFileReader::rewind() {
+    this->pos_ = this->file_size_;
+    this->good_ = this->file_size_ > 0;
+}
+
+bool ReverseFileReader::good() {
+    return this->good_;
+}
+
+void ReverseFileReader::read_back_until(const DelimSet& stops) {
+    // The bytes go into scratch_ last first, as we come to them, and are
+    // turned around at the end, so a token that spans many blocks costs
+    // no more than one that doesn't.
+    scratch_.clear();
+    while (pos_ > 0) {
+        if (!(buffer_offset_ < pos_ &&
+              pos_ <= buffer_offset_ + static_cast<off_t>(curr_length_))) {
+            fill_block();
+            continue;
+        }
+        const char* begin = buffer_;
+        const char* end = buffer_ + (pos_ - buffer_offset_);
+        const char* p = end;
+        while (p != begin && !stops.contains(p[-1])) {
+            p--;
+        }
+        scratch_.append(std::make_reverse_iterator(end),
+                        std::make_reverse_iterator(p));
+        if (p != begin) {
+            pos_ = buffer_offset_ + (p - 1 - begin);  // skip the stop, too
+            std::reverse(scratch_.begin(), scratch_.end());
+            return;
+        }
+        pos_ = buffer_offset_;
+    }
+
+    // We ran into the start of the file.
+    std::reverse(scratch_.begin(), scratch_.end());
+    this->good_ = false;
+}
+
+void ReverseFileReader::fill_block() {
+    uint64_t start_ns = stats_enabled_ ? ReaderStats::now_ns() : 0;
+    off_t offset = (pos_ - 1) / static_cast<off_t>(capacity_) * capacity_;
+    size_t len = std::min(static_cast<off_t>(capacity_), file_size_ - offset);
+    size_t total = 0;
+
+    while (total < len) {
+        ssize_t result = pread(this->fd_, buffer_ + total, len - total,
+                               offset + total);
+        if (result == -1) {
+            if (errno != EINTR) {
+                perror("pread failed");
+                exit(EXIT_FAILURE);
+            }
+            if (stats_enabled_) {
+                stats_.eintr_retries++;
+            }
+            continue;       // EINTR happened, so do nothing and try again
+        } else if (result == 0) {
+            break;
+        }
+        total += result;
+        if (stats_enabled_) {
+            stats_.read_syscalls++;
+            stats_.bytes_read += result;
+        }
+    }
+    this->buffer_offset_ = offset;
+    this->curr_length_ = total;
+
+    // If the file shrank since we opened it, what's past its end now is
+    // gone: carry on from there.
+    pos_ = std::min(pos_, offset + static_cast<off_t>(total));
+    if (stats_enabled_) {
+        stats_.add_fill(ReaderStats::now_ns() - start_ns);
+    }
+}
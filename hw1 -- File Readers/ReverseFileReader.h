@@ -0,0 +1,156 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef REVERSEFILEREADER_H_
+#define REVERSEFILEREADER_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <string>
+#include <vector>
+
+#include "./DelimSet.h"
+#include "./ReaderStats.h"
+#include "./TokenScanner.h"
+
+using std::string;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// A ReverseFileReader is a class for reading files from the end to the
+// start, like tail(1) does.
+//
+// It reads the file in fixed-size, aligned blocks with pread(), starting
+// with the last one and working toward the front, so reading the last few
+// lines or tokens of a file touches only the blocks they are in, however
+// big the file is. Tokens and lines that span blocks are put back
+// together.
+//
+// Like MappedFileReader, the reader works from the file's size when it was
+// opened.
+///////////////////////////////////////////////////////////////////////////////
+class ReverseFileReader {
+ public:
+  // Constants
+  static constexpr size_t BUF_SIZE = 64 << 10;  // the default block size.
+  static constexpr size_t BUF_ALIGNMENT = 4096;  // the buffer's alignment.
+
+  // Constructor for a ReverseFileReader. Opens the file, ready to read
+  // backwards from its end.
+  // Undefined behaviour if the file name is invalid.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  // - delims: the delimiters for reading tokens, as for
+  //   BufferedFileReader.
+  // - buf_size: how many bytes to read from the file at a time. Blocks
+  //   start at multiples of buf_size. Must be > 0.
+  ReverseFileReader(const string& fname, const string& delims="\r\n\t ",
+                    size_t buf_size=BUF_SIZE);
+
+  // Destructor for a ReverseFileReader. Closes the file.
+  ~ReverseFileReader();
+
+  // Sets up the reader to read the specified file backwards from its end,
+  // closing any file already open.
+  // Undefined behaviour if the file name is invalid.
+  //
+  // Arguments:
+  // - fname: The name of the file to be opened
+  void open_file(const string& fname);
+
+  // Closes the file. If there is not a file currently open, then nothing
+  // should happen.
+  void close_file();
+
+  // Returns the character before the current position, and moves back
+  // over it.
+  //
+  // Returns:
+  // - the character, or EOF if already at the start of the file or if
+  //   there is no file open currently.
+  char prev_char();
+
+  // Returns the token that ends at the current position, and moves back
+  // past it and the delimiter before it. The tokens come out as exactly
+  // the ones BufferedFileReader::get_token() returns, in reverse order,
+  // empty ones included (so a file that ends with a delimiter ends with
+  // an empty token).
+  // Returns the empty string if already at the start of the file.
+  // Undefined behaviour if there is no file open currently.
+  string prev_token();
+
+  // Returns the line that ends at the current position, without its '\n',
+  // and moves back past it and the '\n' before it. A '\n' at the very end
+  // of the file ends the last line, rather than starting an empty one, so
+  // the first call returns the file's last line, as with tail(1).
+  // Returns the empty string if already at the start of the file.
+  // Undefined behaviour if there is no file open currently.
+  string prev_line();
+
+  // Same as prev_line(), but splits the line into tokens at the
+  // delimiters, in the order they are in the file, as
+  // BufferedFileReader::get_line() would.
+  //
+  // Arguments:
+  // - tokens: the vector to put the line's tokens in.
+  void prev_line(vector<string>* tokens);
+
+  // Returns the current position: the offset of the first byte that has
+  // been read, so everything before it is still to be read. Starts at the
+  // size of the file.
+  // Undefined behaviour if there is no file open currently.
+  off_t tell();
+
+  // Moves back to the end of the file, to read it all again.
+  // Undefined behaviour if there is no file open currently.
+  void rewind();
+
+  // Returns whether or not there is more to read: false once the start of
+  // the file has been reached, or if there is no file open.
+  bool good();
+
+  // Turns counting ReaderStats on or off, and returns and zeroes them, as
+  // for BufferedFileReader.
+  void enable_stats(bool enable=true) { stats_enabled_ = enable; }
+  const ReaderStats& stats() const { return stats_; }
+  void reset_stats() { stats_ = ReaderStats(); }
+
+  // Disabling the copy constructor and the assignment operator.
+  ReverseFileReader(const ReverseFileReader& other) = delete;
+  ReverseFileReader& operator=(const ReverseFileReader other) = delete;
+
+ private:
+  // fields
+  char* buffer_;       // the block we read into. Aligned to BUF_ALIGNMENT.
+  size_t capacity_;    // the size of buffer_, and of every block
+  off_t buffer_offset_;  // the file offset of buffer_[0]
+  size_t curr_length_;   // how many bytes of the block are in buffer_
+  off_t pos_;          // the current position (see tell())
+  off_t file_size_;    // the file's size when it was opened
+  int fd_;             // The File Descriptor that we use to manage our file.
+  DelimSet token_stops_;  // the bytes that end a token (delims, plus the
+                          // byte that reads as EOF)
+  DelimSet line_ends_;    // the bytes that end a line: '\n', plus the
+                          // byte that reads as EOF
+  string scratch_;     // where the token or line being read is put
+                       // together, back to front
+  bool good_;          // Whether or not the reader is good to read
+  bool stats_enabled_;  // Whether stats_ is being counted
+  ReaderStats stats_;   // see stats()
+
+  // Helpers
+  void fill_block();   // read the block that holds the byte before pos_
+  void read_back_until(const DelimSet& stops);
+};
+
+
+#endif  // REVERSEFILEREADER_H_
@@ -0,0 +1,221 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "./SharedFileReader.h"
+
+constexpr size_t SharedFileReader::BUF_SIZE;
+constexpr size_t SharedFileReader::BUF_ALIGNMENT;
+constexpr off_t SharedFileReader::TO_EOF;
+
+SharedFileReader::SharedFileReader(const string& fname) {
+    struct stat st;
+
+    this->fd_ = open(fname.c_str(), O_RDONLY);
+    if (this->fd_ == -1) {
+        perror("open failed");
+        exit(EXIT_FAILURE);
+    }
+    if (fstat(this->fd_, &st) == -1) {
+        perror("fstat failed");
+        exit(EXIT_FAILURE);
+    }
+    this->file_size_ = st.st_size;
+}
+
+SharedFileReader::~SharedFileReader() {
+    close(this->fd_);
+}
+
+size_t SharedFileReader::read_at(char* buf, size_t len, off_t offset,
+                                 ReaderStats* stats) const {
+    size_t total = 0;
+
+    while (total < len) {
+        ssize_t result = pread(this->fd_, buf + total, len - total,
+                               offset + total);
+        if (stats != nullptr) {
+            stats->read_syscalls++;
+        }
+        if (result == -1) {
+            if (errno != EINTR) {
+                perror("pread failed");
+                exit(EXIT_FAILURE);
+            }
+            if (stats != nullptr) {
+                stats->eintr_retries++;
+            }
+            continue;       // EINTR happened, so do nothing and try again
+        } else if (result == 0) {
+            break;
+        }
+        total += result;
+    }
+    if (stats != nullptr) {
+        stats->bytes_read += total;
+    }
+    return total;
+}
+
+SharedFileReader::Handle::Handle(const SharedFileReader& file, off_t begin,
+                                 off_t end, const string& delims,
+                                 size_t buf_size) {
+    void* buf;
+
+    this->file_ = &file;
+    if (posix_memalign(&buf, BUF_ALIGNMENT, buf_size) != 0) {
+        perror("posix_memalign failed");
+        exit(EXIT_FAILURE);
+    }
+    this->buffer_ = static_cast<char*>(buf);
+    this->capacity_ = buf_size;
+    this->end_ = end;
+    this->token_stops_ = DelimSet(delims);
+    this->token_stops_.add(EOF);
+    this->line_ends_ = DelimSet("\n");
+    this->line_ends_.add(EOF);
+    this->stats_enabled_ = false;
+    this->stats_ = ReaderStats();
+
+    // Start with an empty buffer that ends at begin, so the first fill
+    // reads from there.
+    this->buffer_offset_ = begin;
+    this->curr_length_ = 0;
+    this->curr_index_ = 0;
+    this->eof_ = false;
+    fill_buffer();
+}
+
+SharedFileReader::Handle::~Handle() {
+    free(this->buffer_);
+    this->buffer_ = nullptr;
+}
+
+char SharedFileReader::Handle::get_char() {
+    if (curr_index_ == curr_length_) {
+        if (eof_) {
+            this->good_ = false;
+            return EOF;
+        }
+        fill_buffer();
+        if (curr_length_ == 0) {
+            return EOF;
+        }
+    }
+    return buffer_[curr_index_++];
+}
+
+string SharedFileReader::Handle::get_token() {
+    return string(get_token_view());
+}
+
+string_view SharedFileReader::Handle::get_token_view() {
+    string_view token;
+    read_until(token_stops_, &token);
+    if (stats_enabled_) {
+        stats_.tokens++;
+    }
+    return token;
+}
+
+void SharedFileReader::Handle::get_line(vector<string>* tokens) {
+    get_line(&line_tokens_);
+
+    // Assign over the strings already in the vector, so their storage is
+    // reused instead of being freed and allocated again.
+    tokens->resize(line_tokens_.size());
+    for (size_t i = 0; i < line_tokens_.size(); i++) {
+        (*tokens)[i].assign(line_tokens_[i].data(), line_tokens_[i].size());
+    }
+}
+
+void SharedFileReader::Handle::get_line(vector<string_view>* tokens) {
+    // Read the whole line first, so every token in it is in one place
+    // (the buffer, or scratch_ if the line crosses a refill), then split it.
+    string_view line;
+    read_until(line_ends_, &line);
+
+    TokenScanner::split_line(token_stops_, line, tokens);
+    if (stats_enabled_) {
+        stats_.tokens += tokens->size();
+        stats_.lines++;
+    }
+}
+
+bool SharedFileReader::Handle::good() {
+    return this->good_;
+}
+
+off_t SharedFileReader::Handle::tell() {
+    return buffer_offset_ + curr_index_;
+}
+
+void SharedFileReader::Handle::seek(off_t offset) {
+    // Already buffered: just move the index. The end of the buffer counts
+    // too, since that's where the Handle is after reading the last byte.
+    if (offset >= buffer_offset_ && offset <= buffer_offset_ + curr_length_ &&
+        curr_length_ > 0) {
+        curr_index_ = offset - buffer_offset_;
+        this->good_ = true;
+        return;
+    }
+
+    buffer_offset_ = offset;
+    curr_length_ = 0;
+    curr_index_ = 0;
+    eof_ = false;
+    fill_buffer();
+}
+
+void SharedFileReader::Handle::fill_buffer() {
+    // Everything in the buffer has been read, so it now starts where the
+    // old contents ended.
+    buffer_offset_ += curr_length_;
+    curr_length_ = 0;
+    curr_index_ = 0;
+
+    // Don't read past the end of the range.
+    size_t len = capacity_;
+    if (end_ != TO_EOF) {
+        len = std::min(len, static_cast<size_t>(
+                                std::max(end_ - buffer_offset_, off_t(0))));
+    }
+
+    uint64_t start_ns = stats_enabled_ ? ReaderStats::now_ns() : 0;
+    if (len > 0) {
+        curr_length_ = file_->read_at(buffer_, len, buffer_offset_,
+                                      stats_enabled_ ? &stats_ : nullptr);
+    }
+    if (stats_enabled_) {
+        stats_.add_fill(ReaderStats::now_ns() - start_ns);
+    }
+
+    // A short fill means we hit the end of the file, and a full one may
+    // have reached the end of the range.
+    eof_ = static_cast<size_t>(curr_length_) < capacity_ ||
+           (end_ != TO_EOF && buffer_offset_ + curr_length_ >= end_);
+    this->good_ = curr_length_ > 0;
+}
+
+int SharedFileReader::Handle::read_until(const DelimSet& stops,
+                                         string_view* token) {
+    return TokenScanner::read_until(this, &Handle::fill_buffer, stops, token);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef SHAREDFILEREADER_H_
+#define SHAREDFILEREADER_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./DelimSet.h"
+#include "./ReaderStats.h"
+#include "./TokenScanner.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// A SharedFileReader is one open file that several threads read at once.
+//
+// The file is opened once. Each thread reads it through its own Handle,
+// which has its own buffer and its own position in the file, and reads
+// like a BufferedFileReader. Handles fill their buffers with pread(), which
+// never touches the file offset the descriptor shares, so they don't race
+// with each other and need no locking.
+//
+// A Handle can be limited to a range of the file, so that threads can
+// split a file between them, or read the same part of it over each other.
+// The SharedFileReader must outlive its Handles.
+///////////////////////////////////////////////////////////////////////////////
+class SharedFileReader {
+ public:
+  // Constants
+  static constexpr size_t BUF_SIZE = 1024;  // a Handle's default buffer size.
+  static constexpr size_t BUF_ALIGNMENT = 4096;  // the buffers' alignment.
+  static constexpr off_t TO_EOF = -1;  // a range that runs to the end of
+                                       // the file, however long it gets.
+
+  // Constructor for a SharedFileReader. Opens the file.
+  // Undefined behaviour if the file name is invalid.
+  //
+  // Arguments:
+  // - fname: The name of the file to be read
+  explicit SharedFileReader(const string& fname);
+
+  // Destructor for a SharedFileReader. Closes the file.
+  ~SharedFileReader();
+
+  // Returns the file's size when it was opened.
+  off_t size() const { return file_size_; }
+
+  // Reads up to len bytes from offset into buf, as one or more pread()s.
+  // Safe to call from any number of threads at once.
+  //
+  // Arguments:
+  // - buf: where to put the bytes
+  // - len: how many bytes to read
+  // - offset: the file offset to read from
+  // - stats: if not nullptr, the pread()s are counted in it
+  //
+  // Returns:
+  // - how many bytes were read: less than len only at the end of the file.
+  size_t read_at(char* buf, size_t len, off_t offset,
+                 ReaderStats* stats=nullptr) const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // A Handle is one thread's reader of a SharedFileReader. It reads exactly
+  // like a BufferedFileReader over the same bytes, with the same
+  // delimiters. A Handle belongs to one thread at a time.
+  /////////////////////////////////////////////////////////////////////////////
+  class Handle {
+   public:
+    // Constructor for a Handle. Reading starts at begin.
+    //
+    // Arguments:
+    // - file: the file to read. Must outlive the Handle.
+    // - begin, end: the range of the file the Handle reads. Reaching end
+    //   is reaching the end of file. end may be TO_EOF.
+    // - delims: the delimiters for reading tokens, as for
+    //   BufferedFileReader.
+    // - buf_size: how many bytes to read from the file at a time.
+    //   Must be > 0.
+    Handle(const SharedFileReader& file, off_t begin=0, off_t end=TO_EOF,
+           const string& delims="\r\n\t ", size_t buf_size=BUF_SIZE);
+
+    // Destructor for a Handle. Frees its buffer; the file stays open.
+    ~Handle();
+
+    // Same as the BufferedFileReader functions of the same names, with
+    // the end of the Handle's range as the end of the file.
+    char get_char();
+    string get_token();
+    string_view get_token_view();
+    void get_line(vector<string>* tokens);
+    void get_line(vector<string_view>* tokens);
+    bool good();
+
+    // Returns the file offset the Handle will read from next.
+    off_t tell();
+
+    // Moves to the given file offset, so the next read starts there. As
+    // with BufferedFileReader::seek(), the buffer is reused if the offset
+    // is in it. Seeking to or past the end of the range leaves the Handle
+    // at EOF.
+    //
+    // Arguments:
+    // - offset: the file offset to move to. Must be >= 0.
+    void seek(off_t offset);
+
+    // Turn counting, return and zero the Handle's ReaderStats, as for
+    // BufferedFileReader. Each Handle counts its own.
+    void enable_stats(bool enable=true) { stats_enabled_ = enable; }
+    const ReaderStats& stats() const { return stats_; }
+    void reset_stats() { stats_ = ReaderStats(); }
+
+    // Disabling the copy constructor and the assignment operator.
+    Handle(const Handle& other) = delete;
+    Handle& operator=(const Handle other) = delete;
+
+   private:
+    friend class TokenScanner;  // reads tokens and lines out of buffer_
+
+    // fields
+    const SharedFileReader* file_;  // the file we read from
+    char* buffer_;         // our buffer. Aligned to BUF_ALIGNMENT.
+    size_t capacity_;      // the size of buffer_
+    int curr_length_;      // how many bytes are in buffer_
+    int curr_index_;       // the next byte in buffer_ to hand out
+    off_t buffer_offset_;  // the file offset of buffer_[0]
+    off_t end_;            // the end of our range, or TO_EOF
+    bool eof_;             // whether the last fill reached the end of the
+                           // range, so there is nothing past buffer_
+    bool good_;            // whether or not we are good to read
+    DelimSet token_stops_;  // the bytes that end a token (delims, plus the
+                            // byte that reads as EOF from get_char())
+    DelimSet line_ends_;   // the bytes that end a line ('\n', plus EOF)
+    string scratch_;       // where a token or line that spans two fills
+                           // is put back together
+    vector<string_view> line_tokens_;  // reused by get_line(vector<string>*)
+    bool stats_enabled_;   // Whether stats_ is being counted
+    ReaderStats stats_;    // see stats()
+
+    // Helpers
+    void fill_buffer();
+    int read_until(const DelimSet& stops, string_view* token);
+  };
+
+  // Disabling the copy constructor and the assignment operator.
+  SharedFileReader(const SharedFileReader& other) = delete;
+  SharedFileReader& operator=(const SharedFileReader other) = delete;
+
+ private:
+  // fields
+  int fd_;             // The File Descriptor every Handle reads through.
+  off_t file_size_;    // the file's size when it was opened
+};
+
+
+#endif  // SHAREDFILEREADER_H_
@@ -17,6 +17,8 @@
 #include "./SimpleFileReader.h"
 
 SimpleFileReader::SimpleFileReader(const string& fname) {
+    this->stats_enabled_ = false;
+    this->stats_ = ReaderStats();
     this->fd_ = open(fname.c_str(), O_RDONLY);
     if (this->fd_ == -1) {
         perror("open failed");
@@ -69,14 +71,24 @@ char SimpleFileReader::get_char() {
         this->good_ = false;
         return EOF;
     }
-    result = read(this->fd_, &char_, 1);
-    if (result == -1) {
-        if (errno != EINTR) {
+    uint64_t start_ns = stats_enabled_ ? ReaderStats::now_ns() : 0;
+    int syscalls = 0;
+    do {
+        result = read(this->fd_, &char_, 1);
+        syscalls++;
+        if (result == -1 && errno != EINTR) {
             perror("read failed");
             this->good_ = false;
             exit(EXIT_FAILURE);
         }
-    } else if (result == 0) {
+    } while (result == -1);     // EINTR happened, so try again
+    if (stats_enabled_) {
+        stats_.read_syscalls += syscalls;
+        stats_.eintr_retries += syscalls - 1;
+        stats_.bytes_read += result;
+        stats_.add_fill(ReaderStats::now_ns() - start_ns);
+    }
+    if (result == 0) {
         this->good_ = false;        // If at the end of the file, then EOF is returned.
         return EOF;
     }
@@ -85,25 +97,33 @@ char SimpleFileReader::get_char() {
     return char_;
 }
 
-string SimpleFileReader::get_chars(size_t n) {  
-    char* buf = new char[n+1];
+string SimpleFileReader::get_chars(size_t n) {
+    string res(n, '\0');
+    res.resize(read_into(&res[0], n));
+    return res;
+}
+
+size_t SimpleFileReader::read_into(char* dst, size_t n) {
     int result;
 
     if (this->fd_ == -1) {
         this->good_ = false;
-        delete[] buf;
         exit(EXIT_FAILURE);
     }
 
-    char* ptr = buf;
-    while (ptr < buf + n) {
-        result = read(this->fd_, ptr, buf + n - ptr);
+    uint64_t start_ns = stats_enabled_ ? ReaderStats::now_ns() : 0;
+    int syscalls = 0, eintr = 0;
+    char* ptr = dst;
+    while (ptr < dst + n) {
+        result = read(this->fd_, ptr, dst + n - ptr);
+        syscalls++;
         if (result == -1) {
             if (errno != EINTR) {
                 perror("read failed");
                 this->good_ = false;
                 exit(EXIT_FAILURE);
             }
+            eintr++;
             continue;       // EINTR happened, so do nothing and try again
         } else if (result == 0) {
             this->good_ = false;        // If at the end of the file, good_ is false.
@@ -112,12 +132,13 @@ string SimpleFileReader::get_chars(size_t n) {
         this->good_ = true;
         ptr += result;
     }
-
-    int bytes_left = buf + n - ptr;
-    buf[n - bytes_left] = '\0';
-    string res = buf;
-    delete[] buf;
-    return res;
+    if (stats_enabled_) {
+        stats_.read_syscalls += syscalls;
+        stats_.eintr_retries += eintr;
+        stats_.bytes_read += ptr - dst;
+        stats_.add_fill(ReaderStats::now_ns() - start_ns);
+    }
+    return ptr - dst;
 }
 
 int SimpleFileReader::tell() {
@@ -14,6 +14,8 @@
 
 #include <string>
 
+#include "./ReaderStats.h"
+
 using std::string;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -79,6 +81,20 @@ class SimpleFileReader {
   //   all of the characters read before reaching the end.
   string get_chars(size_t n);
 
+  // Reads the next n characters of the file into dst, with as few read()
+  // calls as the kernel allows, instead of building a string like
+  // get_chars() does.
+  // Undefined behaviour if there is no file open currently.
+  //
+  // Arguments:
+  // - dst: where to put the characters. Must have room for n of them.
+  // - n: how many characters to read
+  //
+  // Returns:
+  // - how many characters were read into dst, which is less than n only
+  //   if the end of the file was reached.
+  size_t read_into(char* dst, size_t n);
+
   // Returns the current position the user is in to the file.
   // Undefined behaviour if there is no file open currently.
   //
@@ -112,6 +128,19 @@ class SimpleFileReader {
   // - true otherwise
   bool good();
 
+  // Turns counting ReaderStats on or off. They start off.
+  // Same as BufferedFileReader::enable_stats().
+  // Every read() counts as a refill, so with stats on, get_char() reads
+  // the clock twice per character.
+  void enable_stats(bool enable=true) { stats_enabled_ = enable; }
+
+  // Returns what has been counted since the reader was constructed or
+  // reset_stats() was last called.
+  const ReaderStats& stats() const { return stats_; }
+
+  // Zeroes the stats.
+  void reset_stats() { stats_ = ReaderStats(); }
+
   // Ignore These
   // If you want to know more, this is disabling the
   // copy constructor and the assignment operator.
@@ -123,6 +152,8 @@ class SimpleFileReader {
   // fields
   int fd_;  // The File Descriptor that we use to manage our file.
   bool good_;  // Whether or not the reader is good to read
+  bool stats_enabled_;  // Whether stats_ is being counted
+  ReaderStats stats_;   // see stats()
 };
 
 
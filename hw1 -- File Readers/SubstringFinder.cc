@@ -0,0 +1,212 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <string.h>
+
+#include "./DelimSet.h"
+#include "./SubstringFinder.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SUBSTRINGFINDER_X86 1
+#endif
+
+// Returns c lower-cased, if it is an ASCII letter.
+static inline unsigned char fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? c | 0x20 : c;
+}
+
+// Returns whether c is an ASCII letter.
+static inline bool is_letter(unsigned char c) {
+    return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+SubstringFinder::SubstringFinder(const string& pattern, bool case_insensitive) {
+    this->pattern_ = pattern;
+    this->case_insensitive_ = case_insensitive;
+    this->first_fold_ = 0;
+    this->last_fold_ = 0;
+    if (case_insensitive) {
+        for (char& c : this->pattern_) {
+            c = fold(c);
+        }
+        if (!pattern.empty()) {
+            this->first_fold_ = is_letter(pattern.front()) ? 0x20 : 0;
+            this->last_fold_ = is_letter(pattern.back()) ? 0x20 : 0;
+        }
+    }
+}
+
+bool SubstringFinder::matches_at(const char* p) const {
+    if (!case_insensitive_) {
+        return memcmp(p, pattern_.data(), pattern_.size()) == 0;
+    }
+    for (size_t i = 0; i < pattern_.size(); i++) {
+        if (fold(p[i]) != static_cast<unsigned char>(pattern_[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* SubstringFinder::find_scalar(const char* p, const char* end) const {
+    size_t m = pattern_.size();
+    unsigned char first = pattern_.front();
+    unsigned char last = pattern_.back();
+    for (; end - p >= static_cast<ptrdiff_t>(m); p++) {
+        if ((static_cast<unsigned char>(p[0]) | first_fold_) == first &&
+            (static_cast<unsigned char>(p[m - 1]) | last_fold_) == last &&
+            matches_at(p)) {
+            return p;
+        }
+    }
+    return end;
+}
+
+#ifdef SUBSTRINGFINDER_X86
+
+// Each of these checks every position in a block at once: bit i of the
+// mask is set if the byte at p + i could start a match, going by its first
+// and last bytes. Those candidates are checked in full, and the loop stops
+// at the first real match, or when the last bytes of the next block would
+// run past end. Either way it returns where it stopped.
+
+static const char* find_sse2(const char* p, const char* end,
+                             const SubstringFinder& finder, const char* pattern,
+                             unsigned char first_fold, unsigned char last_fold,
+                             bool* found) {
+    size_t m = finder.size();
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[m - 1]);
+    const __m128i first_or = _mm_set1_epi8(first_fold);
+    const __m128i last_or = _mm_set1_epi8(last_fold);
+    for (; end - p >= static_cast<ptrdiff_t>(m - 1 + 16); p += 16) {
+        __m128i head = _mm_or_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), first_or);
+        __m128i tail = _mm_or_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + m - 1)),
+            last_or);
+        unsigned mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first),
+                          _mm_cmpeq_epi8(tail, last)));
+        while (mask != 0) {
+            const char* candidate = p + __builtin_ctz(mask);
+            if (finder.matches_at(candidate)) {
+                *found = true;
+                return candidate;
+            }
+            mask &= mask - 1;           // clear the lowest set bit
+        }
+    }
+    return p;
+}
+
+__attribute__((target("avx2")))
+static const char* find_avx2(const char* p, const char* end,
+                             const SubstringFinder& finder, const char* pattern,
+                             unsigned char first_fold, unsigned char last_fold,
+                             bool* found) {
+    size_t m = finder.size();
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last = _mm256_set1_epi8(pattern[m - 1]);
+    const __m256i first_or = _mm256_set1_epi8(first_fold);
+    const __m256i last_or = _mm256_set1_epi8(last_fold);
+    for (; end - p >= static_cast<ptrdiff_t>(m - 1 + 32); p += 32) {
+        __m256i head = _mm256_or_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), first_or);
+        __m256i tail = _mm256_or_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + m - 1)),
+            last_or);
+        unsigned mask = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(head, first),
+                             _mm256_cmpeq_epi8(tail, last)));
+        while (mask != 0) {
+            const char* candidate = p + __builtin_ctz(mask);
+            if (finder.matches_at(candidate)) {
+                *found = true;
+                return candidate;
+            }
+            mask &= mask - 1;           // clear the lowest set bit
+        }
+    }
+    return p;
+}
+
+#endif  // SUBSTRINGFINDER_X86
+
+const char* SubstringFinder::find(const char* begin, const char* end) const {
+    const char* p = begin;
+
+    if (pattern_.empty()) {
+        return begin;
+    }
+
+#ifdef SUBSTRINGFINDER_X86
+    bool found = false;
+    if (DelimSet::have_avx2()) {
+        p = find_avx2(p, end, *this, pattern_.data(), first_fold_, last_fold_,
+                      &found);
+    }
+    if (!found) {
+        p = find_sse2(p, end, *this, pattern_.data(), first_fold_, last_fold_,
+                      &found);
+    }
+    if (found) {
+        return p;
+    }
+#endif  // SUBSTRINGFINDER_X86
+
+    // Whatever the SIMD loops left over: the last block or so.
+    return find_scalar(p, end);
+}
+
+#ifdef SUBSTRINGFINDER_X86
+
+static size_t count_newlines_sse2(const char** p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+    for (; end - *p >= 16; *p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(*p));
+        count += __builtin_popcount(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+    }
+    return count;
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t count_newlines_avx2(const char** p, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    for (; end - *p >= 32; *p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(*p));
+        count += __builtin_popcount(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+    }
+    return count;
+}
+
+#endif  // SUBSTRINGFINDER_X86
+
+size_t SubstringFinder::count_newlines(const char* begin, const char* end) {
+    const char* p = begin;
+    size_t count = 0;
+
+#ifdef SUBSTRINGFINDER_X86
+    if (DelimSet::have_avx2()) {
+        count += count_newlines_avx2(&p, end);
+    }
+    count += count_newlines_sse2(&p, end);
+#endif  // SUBSTRINGFINDER_X86
+    for (; p < end; p++) {
+        count += *p == '\n';
+    }
+    return count;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef SUBSTRINGFINDER_H_
+#define SUBSTRINGFINDER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
+
+using std::string;
+
+// Where a reader's find_next() found its pattern.
+struct SearchMatch {
+  off_t offset;   // the file offset of the match's first byte
+  uint64_t line;  // the line the match starts on, counting from 0, as in
+                  // LineIndex: the number of '\n's before offset
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// A SubstringFinder searches buffers for a fixed pattern.
+//
+// find() compares 16 bytes at a time with SSE2 (32 with AVX2) against the
+// pattern's first byte, and the bytes m - 1 further on against its last
+// byte, where m is the pattern's length. Only positions where both match
+// are compared in full, with memcmp(), so most of a buffer is skipped
+// without looking at it byte by byte. Short buffers and non-x86 machines
+// take the same path one byte at a time.
+//
+// Case-insensitive searches fold ASCII letters only.
+///////////////////////////////////////////////////////////////////////////////
+class SubstringFinder {
+ public:
+  // Constructs a finder for pattern.
+  //
+  // Arguments:
+  // - pattern: the bytes to look for
+  // - case_insensitive: whether ASCII letters match either case
+  explicit SubstringFinder(const string& pattern,
+                           bool case_insensitive=false);
+
+  // Returns the length of the pattern.
+  size_t size() const { return pattern_.size(); }
+
+  // Finds the first match of the pattern that is entirely in [begin, end).
+  // An empty pattern matches at begin.
+  //
+  // Arguments:
+  // - begin, end: the range to search
+  //
+  // Returns:
+  // - a pointer to the first byte of the match, or end if there is none.
+  const char* find(const char* begin, const char* end) const;
+
+  // Returns whether the size() bytes at p match the pattern.
+  bool matches_at(const char* p) const;
+
+  // Returns how many '\n's there are in [begin, end).
+  static size_t count_newlines(const char* begin, const char* end);
+
+ private:
+  string pattern_;        // the pattern, lower-cased if case_insensitive_
+  bool case_insensitive_;
+  unsigned char first_fold_;  // ORed into a byte before comparing it with
+  unsigned char last_fold_;   // the first or last byte of the pattern: 0x20
+                              // for a case-insensitive letter, else 0
+
+  // Helpers
+  const char* find_scalar(const char* p, const char* end) const;
+};
+
+
+#endif  // SUBSTRINGFINDER_H_
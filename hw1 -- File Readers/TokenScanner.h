@@ -0,0 +1,134 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef TOKENSCANNER_H_
+#define TOKENSCANNER_H_
+
+#include <stdio.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// TokenScanner is the token and line scanning that the buffered readers
+// share, so they all read exactly the same tokens, and a fix to one is a
+// fix to all of them.
+//
+// read_until() works on a reader's own fields, which the readers that use
+// it name the same way (and make TokenScanner a friend to reach):
+// - buffer_, curr_length_ and curr_index_: the bytes in the buffer, how
+//   many there are, and the next one to read
+// - eof_: whether there is nothing in the file after the buffer
+// - good_: whether the reader is good to read
+// - scratch_: a string where a token that runs across a refill is put
+//   back together
+// The reader's refill function is passed in. It must move the buffer on
+// to the bytes that follow it, and leave curr_length_ 0 if there are none.
+///////////////////////////////////////////////////////////////////////////////
+class TokenScanner {
+ public:
+  // Reads up to the next byte in stops, which it consumes, refilling the
+  // buffer as often as it takes. The token is a view of the buffer, or of
+  // the reader's scratch_ if it ran across a refill, and is only valid
+  // until the reader next reads.
+  //
+  // Arguments:
+  // - reader: the reader to read from
+  // - refill: the reader's refill function
+  // - stops: the bytes that end the token. Anything with a
+  //   find(begin, end) like DelimSet's.
+  // - token: returns the bytes before the stop byte
+  //
+  // Returns:
+  // - the stop byte, as an unsigned char, or EOF if the file ended first
+  template <class Reader, class Stops>
+  static int read_until(Reader* reader, void (Reader::*refill)(),
+                        const Stops& stops, string_view* token);
+
+  // Splits a line into the tokens between the bytes in token_stops. There
+  // is always at least one token, if only an empty one.
+  //
+  // Arguments:
+  // - token_stops: the bytes that end a token
+  // - line: the line to split
+  // - tokens: returns the tokens, as string_views into line or as strings
+  template <class TokenStops, class Token>
+  static void split_line(const TokenStops& token_stops, string_view line,
+                         vector<Token>* tokens);
+};
+
+template <class Reader, class Stops>
+int TokenScanner::read_until(Reader* reader, void (Reader::*refill)(),
+                             const Stops& stops, string_view* token) {
+  const char* start = reader->buffer_ + reader->curr_index_;
+  bool stitched = false;              // whether the token is in scratch_
+  while (true) {
+    if (reader->curr_index_ == reader->curr_length_) {  // end of the buffer
+      // The token runs off the end of the buffer. Save what we have of it
+      // before the refill overwrites it.
+      if (!stitched) {
+        reader->scratch_.clear();
+        stitched = true;
+      }
+      reader->scratch_.append(start,
+                              reader->buffer_ + reader->curr_index_ - start);
+      if (reader->eof_) {
+        reader->good_ = false;
+        *token = reader->scratch_;
+        return EOF;
+      }
+      (reader->*refill)();
+      if (reader->curr_length_ == 0) {
+        *token = reader->scratch_;
+        return EOF;
+      }
+      start = reader->buffer_;
+    }
+
+    // Find the stop byte in the rest of the buffer with one scan.
+    const char* end = reader->buffer_ + reader->curr_length_;
+    const char* stop = stops.find(reader->buffer_ + reader->curr_index_, end);
+    reader->curr_index_ = stop - reader->buffer_;
+    if (stop != end) {
+      if (stitched) {
+        reader->scratch_.append(start, stop - start);
+        *token = reader->scratch_;
+      } else {
+        *token = string_view(start, stop - start);
+      }
+      reader->curr_index_++;          // consume the stop byte
+      return static_cast<unsigned char>(*stop);
+    }
+  }
+}
+
+template <class TokenStops, class Token>
+void TokenScanner::split_line(const TokenStops& token_stops,
+                              string_view line, vector<Token>* tokens) {
+  tokens->clear();
+  const char* p = line.data();
+  const char* end = p + line.size();
+  while (true) {
+    const char* stop = token_stops.find(p, end);
+    tokens->emplace_back(p, stop - p);
+    if (stop == end) {
+      break;
+    }
+    p = stop + 1;
+  }
+}
+
+
+#endif  // TOKENSCANNER_H_
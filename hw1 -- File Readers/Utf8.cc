@@ -0,0 +1,541 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "./Utf8.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UTF8_X86 1
+#endif
+
+// What check_sequence() found at the start of a range.
+enum SequenceStatus { SEQ_VALID, SEQ_INVALID, SEQ_TRUNCATED };
+
+// Checks the sequence that starts at p. Sets *len to its length if it is
+// valid, to the length of its maximal subpart if it is invalid, or to how
+// much of it there is if end cuts it off.
+static inline SequenceStatus check_sequence(const unsigned char* p,
+                                            const unsigned char* end,
+                                            int* len) {
+    unsigned char c = p[0];
+    unsigned char lo = 0x80, hi = 0xBF;  // the range of the second byte
+    int need;
+
+    if (c < 0x80) {
+        *len = 1;
+        return SEQ_VALID;
+    } else if (c < 0xC2) {              // a continuation, or overlong
+        *len = 1;
+        return SEQ_INVALID;
+    } else if (c < 0xE0) {
+        need = 1;
+    } else if (c < 0xF0) {
+        need = 2;
+        lo = (c == 0xE0) ? 0xA0 : lo;   // overlong
+        hi = (c == 0xED) ? 0x9F : hi;   // a surrogate
+    } else if (c < 0xF5) {
+        need = 3;
+        lo = (c == 0xF0) ? 0x90 : lo;   // overlong
+        hi = (c == 0xF4) ? 0x8F : hi;   // past U+10FFFF
+    } else {
+        *len = 1;
+        return SEQ_INVALID;
+    }
+
+    for (int i = 1; i <= need; i++) {
+        if (p + i == end) {
+            *len = i;
+            return SEQ_TRUNCATED;
+        }
+        if (p[i] < lo || p[i] > hi) {
+            *len = i;
+            return SEQ_INVALID;
+        }
+        lo = 0x80;
+        hi = 0xBF;
+    }
+    *len = need + 1;
+    return SEQ_VALID;
+}
+
+static inline bool is_continuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// Returns the start of the sequence that ends at p - 1, or runs past it,
+// given that the text before p is valid apart from, perhaps, a sequence
+// cut off at p. (Or begin, if that comes first.)
+static inline const char* back_to_boundary(const char* begin, const char* p) {
+    if (p == begin) {
+        return p;
+    }
+    const char* q = p - 1;
+    for (int i = 0; i < 3 && q > begin && is_continuation(*q); i++) {
+        q--;
+    }
+    return q;
+}
+
+#ifdef UTF8_X86
+
+// These return how far from p the text is known to be valid UTF-8: up to
+// a sequence boundary, short of the block where they found a problem, or
+// of the last block, which is too short for them.
+
+static const char* skip_valid_sse2(const char* p, const char* end) {
+    // ASCII only: anything else is left to check_sequence().
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (_mm_movemask_epi8(block) != 0) {
+            break;
+        }
+    }
+    return p;
+}
+
+// What can go wrong with a pair of bytes, as bits. The first two tables
+// below give the bits each possible high and low nibble of a pair's first
+// byte allows, and the third those the high nibble of its second byte
+// allows; an error is a bit all three allow.
+static constexpr uint8_t TOO_SHORT = 1 << 0;   // a lead byte, then not a
+                                               // continuation
+static constexpr uint8_t TOO_LONG = 1 << 1;    // ASCII, then a continuation
+static constexpr uint8_t OVERLONG_3 = 1 << 2;  // 11100000 100_____
+static constexpr uint8_t TOO_LARGE = 1 << 3;   // 11110100 1001____, and up
+static constexpr uint8_t SURROGATE = 1 << 4;   // 11101101 101_____
+static constexpr uint8_t OVERLONG_2 = 1 << 5;  // 1100000_ 10______
+static constexpr uint8_t TOO_LARGE_1000 = 1 << 6;  // 11110101 1000____, up
+static constexpr uint8_t OVERLONG_4 = 1 << 6;  // 11110000 1000____
+static constexpr uint8_t TWO_CONTS = 1 << 7;   // two continuations, which
+                                               // is fine in a 3 or 4 byte
+                                               // sequence
+static constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+// The tables, indexed by a nibble.
+alignas(16) static const uint8_t kByte1High[16] = {
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,     // 0_______ ________
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,  // 10______ ________
+    TOO_SHORT | OVERLONG_2,                      // 1100____ ________
+    TOO_SHORT,                                   // 1101____ ________
+    TOO_SHORT | OVERLONG_3 | SURROGATE,          // 1110____ ________
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,  // 1111____
+};
+alignas(16) static const uint8_t kByte1Low[16] = {
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,  // ____0000 ________
+    CARRY | OVERLONG_2,                            // ____0001 ________
+    CARRY,                                         // ____001_ ________
+    CARRY,
+    CARRY | TOO_LARGE,                             // ____0100 ________
+    CARRY | TOO_LARGE | TOO_LARGE_1000,            // ____0101 ________
+    CARRY | TOO_LARGE | TOO_LARGE_1000,            // ____011_ ________
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,            // ____1___ ________
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,  // ____1101 ________
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+alignas(16) static const uint8_t kByte2High[16] = {
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,  // ________ 0_______
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 |
+        OVERLONG_4,                              // ________ 1000____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,  // 1001____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,   // 101_____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,  // ________ 11______
+};
+
+// Returns table[n] for each nibble n in nibbles.
+__attribute__((target("avx2")))
+static inline __m256i lookup(const uint8_t* table, __m256i nibbles) {
+    __m128i half = _mm_load_si128(reinterpret_cast<const __m128i*>(table));
+    return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(half), nibbles);
+}
+
+// Returns the block of bytes n before each byte of input, which reach back
+// into prev.
+template <int N>
+__attribute__((target("avx2")))
+static inline __m256i prev_bytes(__m256i input, __m256i prev) {
+    return _mm256_alignr_epi8(input,
+                              _mm256_permute2x128_si256(prev, input, 0x21),
+                              16 - N);
+}
+
+// Returns a block with a bit set wherever input, the block after prev,
+// isn't valid UTF-8, ignoring sequences cut off at its end.
+__attribute__((target("avx2")))
+static inline __m256i check_block(__m256i input, __m256i prev) {
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+
+    // The errors between each byte and the one before it...
+    __m256i prev1 = prev_bytes<1>(input, prev);
+    __m256i byte_1_high = lookup(kByte1High, _mm256_and_si256(
+        _mm256_srli_epi16(prev1, 4), low_nibble));
+    __m256i byte_1_low = lookup(kByte1Low,
+                                _mm256_and_si256(prev1, low_nibble));
+    __m256i byte_2_high = lookup(kByte2High, _mm256_and_si256(
+        _mm256_srli_epi16(input, 4), low_nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high,
+                                                        byte_1_low),
+                                       byte_2_high);
+
+    // ...except that two continuations in a row are right where a byte
+    // two or three back starts a 3 or 4 byte sequence, and wrong anywhere
+    // else.
+    __m256i prev2 = prev_bytes<2>(input, prev);
+    __m256i prev3 = prev_bytes<3>(input, prev);
+    __m256i must_continue = _mm256_or_si256(
+        _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80)),
+        _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0 - 0x80)));
+    __m256i must_continue_80 = _mm256_and_si256(must_continue,
+                                                _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(must_continue_80, special);
+}
+
+__attribute__((target("avx2")))
+static const char* skip_valid_avx2(const char* p, const char* end) {
+    // Non-zero where one of the last three bytes of a block starts a
+    // sequence too long to end in it.
+    const __m256i max_complete = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1),
+        static_cast<char>(0xC0 - 1));
+    __m256i prev = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+
+    for (; end - p >= 32; p += 32) {
+        __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        if (_mm256_movemask_epi8(input) == 0) {
+            // All ASCII: fine, unless the last block left a sequence open.
+            if (!_mm256_testz_si256(prev_incomplete, prev_incomplete)) {
+                break;
+            }
+        } else {
+            __m256i error = check_block(input, prev);
+            if (!_mm256_testz_si256(error, error)) {
+                break;
+            }
+            prev_incomplete = _mm256_subs_epu8(input, max_complete);
+        }
+        prev = input;
+    }
+    return p;
+}
+
+#endif  // UTF8_X86
+
+// Returns how far from p the text is known to be valid, up to the start
+// of a sequence.
+static inline const char* skip_valid(const char* p, const char* end) {
+#ifdef UTF8_X86
+    const char* q = DelimSet::have_avx2() ? skip_valid_avx2(p, end)
+                                          : skip_valid_sse2(p, end);
+    return back_to_boundary(p, q);
+#else
+    return p;
+#endif  // UTF8_X86
+}
+
+// Finds the first sequence in [begin, end) that is invalid or cut off by
+// end, and sets *len and *status for it, or returns end. With simd set,
+// the SIMD loops skip what they can, and check_sequence() looks at a few
+// blocks' worth of bytes from wherever they stop, which is where the
+// problem is, or the end.
+static const char* scan(const char* begin, const char* end, bool simd,
+                        int* len, SequenceStatus* status) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(begin);
+    const unsigned char* uend = reinterpret_cast<const unsigned char*>(end);
+
+    while (p < uend) {
+        const unsigned char* limit = uend;
+        if (simd) {
+            p = reinterpret_cast<const unsigned char*>(
+                skip_valid(reinterpret_cast<const char*>(p), end));
+            limit = (uend - p > 64) ? p + 64 : uend;
+        }
+        while (p < limit) {
+            *status = check_sequence(p, uend, len);
+            if (*status != SEQ_VALID) {
+                return reinterpret_cast<const char*>(p);
+            }
+            p += *len;
+        }
+    }
+    return end;
+}
+
+const char* Utf8Validator::find_invalid(const char* begin, const char* end,
+                                        int* len) {
+    SequenceStatus status;
+    return scan(begin, end, true, len, &status);
+}
+
+const char* Utf8Validator::find_invalid_scalar(const char* begin,
+                                               const char* end, int* len) {
+    SequenceStatus status;
+    return scan(begin, end, false, len, &status);
+}
+
+Utf8Validator::Utf8Validator() {
+    reset();
+}
+
+void Utf8Validator::reset() {
+    this->pending_len_ = 0;
+    this->pending_offset_ = 0;
+    this->next_offset_ = 0;
+    this->errors_.clear();
+}
+
+void Utf8Validator::feed(const char* data, size_t len, off_t offset) {
+    const char* p = data;
+    const char* end = data + len;
+
+    if (offset != next_offset_) {
+        // Starting over somewhere else, maybe in the middle of a sequence.
+        pending_len_ = 0;
+        for (int i = 0; i < 3 && offset > 0 && p < end && is_continuation(*p);
+             i++) {
+            p++;
+        }
+    }
+    next_offset_ = offset + len;
+
+    // Finish the sequence the last call cut off, with the first few bytes.
+    if (pending_len_ > 0) {
+        unsigned char seq[6];
+        int taken = std::min(static_cast<size_t>(3), len);
+        memcpy(seq, pending_, pending_len_);
+        memcpy(seq + pending_len_, data, taken);
+        int seq_len;
+        SequenceStatus status = check_sequence(seq, seq + pending_len_ + taken,
+                                               &seq_len);
+        if (status == SEQ_TRUNCATED) {
+            memcpy(pending_ + pending_len_, data, taken);  // still cut off
+            pending_len_ += taken;
+            return;
+        }
+        if (status == SEQ_INVALID) {
+            add_error(pending_offset_);
+        }
+        p += seq_len - pending_len_;
+        pending_len_ = 0;
+    }
+
+    while (p < end) {
+        int bad_len;
+        SequenceStatus status;
+        const char* bad = scan(p, end, true, &bad_len, &status);
+        if (bad == end) {
+            break;
+        }
+        if (status == SEQ_TRUNCATED) {
+            memcpy(pending_, bad, end - bad);   // finish it next time
+            pending_len_ = end - bad;
+            pending_offset_ = offset + (bad - data);
+            break;
+        }
+        add_error(offset + (bad - data));
+        p = bad + bad_len;
+    }
+}
+
+void Utf8Validator::finish() {
+    if (pending_len_ > 0) {
+        add_error(pending_offset_);
+        pending_len_ = 0;
+    }
+}
+
+void Utf8Validator::add_error(off_t offset) {
+    // Bytes fed again after a seek() backwards aren't reported twice.
+    if (errors_.empty() || offset > errors_.back()) {
+        errors_.push_back(offset);
+    }
+}
+
+// The last bytes of the multibyte white space characters.
+static const char kSpaceLastBytes[] = {
+    '\x80', '\x81', '\x82', '\x83', '\x84', '\x85', '\x86', '\x87', '\x88',
+    '\x89', '\x8A', '\x9F', '\xA0', '\xA8', '\xA9', '\xAF'
+};
+
+Utf8Delims::Utf8Delims(const string& delims) {
+    this->delims_ = DelimSet(delims);
+    this->delims_.add(EOF);
+    this->stops_ = this->delims_;
+    for (char c : kSpaceLastBytes) {
+        this->stops_.add(c);
+    }
+
+    // Bytes from 0x80 up are all found by their high bit, so only the
+    // ASCII delimiters need comparing.
+    this->num_needles_ = 0;
+    for (int c = 0; c < 0x80; c++) {
+        if (this->delims_.contains(c)) {
+            if (this->num_needles_ == DelimSet::MAX_SIMD_CHARS) {
+                this->num_needles_ = -1;
+                break;
+            }
+            this->needles_[this->num_needles_++] = c;
+        }
+    }
+}
+
+#ifdef UTF8_X86
+
+// Each of these finds the first byte from p on that is one of the needles
+// or has its high bit set, and is a stop, a block at a time. They stop at
+// the first one, or with less than a block left, and return where.
+
+static const char* find_sse2(const char* p, const char* end,
+                             const DelimSet& stops, const char* needles,
+                             int num_needles, bool* found) {
+    __m128i vneedles[DelimSet::MAX_SIMD_CHARS];
+    for (int i = 0; i < num_needles; i++) {
+        vneedles[i] = _mm_set1_epi8(needles[i]);
+    }
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_setzero_si128();
+        for (int i = 0; i < num_needles; i++) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, vneedles[i]));
+        }
+        unsigned mask = _mm_movemask_epi8(_mm_or_si128(hits, block));
+        while (mask != 0) {
+            const char* candidate = p + __builtin_ctz(mask);
+            if (stops.contains(*candidate)) {
+                *found = true;
+                return candidate;
+            }
+            mask &= mask - 1;           // clear the lowest set bit
+        }
+    }
+    return p;
+}
+
+__attribute__((target("avx2")))
+static const char* find_avx2(const char* p, const char* end,
+                             const DelimSet& stops, const char* needles,
+                             int num_needles, bool* found) {
+    __m256i vneedles[DelimSet::MAX_SIMD_CHARS];
+    for (int i = 0; i < num_needles; i++) {
+        vneedles[i] = _mm256_set1_epi8(needles[i]);
+    }
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hits = _mm256_setzero_si256();
+        for (int i = 0; i < num_needles; i++) {
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, vneedles[i]));
+        }
+        unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(hits, block));
+        while (mask != 0) {
+            const char* candidate = p + __builtin_ctz(mask);
+            if (stops.contains(*candidate)) {
+                *found = true;
+                return candidate;
+            }
+            mask &= mask - 1;           // clear the lowest set bit
+        }
+    }
+    return p;
+}
+
+#endif  // UTF8_X86
+
+const char* Utf8Delims::find(const char* begin, const char* end) const {
+    const char* p = begin;
+
+    // Most tokens are short: try the table on the first few bytes first,
+    // as DelimSet::find() does.
+    const char* prefix_end = (end - p > DelimSet::SCALAR_PREFIX)
+                                 ? p + DelimSet::SCALAR_PREFIX : end;
+    for (; p < prefix_end; p++) {
+        if (stops_.contains(*p)) {
+            return p;
+        }
+    }
+
+#ifdef UTF8_X86
+    if (num_needles_ >= 0) {
+        bool found = false;
+        if (DelimSet::have_avx2()) {
+            p = find_avx2(p, end, stops_, needles_, num_needles_, &found);
+        }
+        if (!found) {
+            p = find_sse2(p, end, stops_, needles_, num_needles_, &found);
+        }
+        if (found) {
+            return p;
+        }
+    }
+#endif  // UTF8_X86
+
+    return stops_.find_scalar(p, end);
+}
+
+int Utf8Delims::delim_length(const char* begin, const char* stop) const {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(stop);
+    unsigned char c = *s;
+
+    if (delims_.contains(*stop)) {
+        return 1;
+    }
+    if (c < 0x80) {
+        return 0;
+    }
+    if (stop - begin >= 1 && s[-1] == 0xC2 && (c == 0x85 || c == 0xA0)) {
+        return 2;                       // U+0085, U+00A0
+    }
+    if (stop - begin >= 2) {
+        unsigned char b0 = s[-2], b1 = s[-1];
+        if ((b0 == 0xE1 && b1 == 0x9A && c == 0x80) ||         // U+1680
+            (b0 == 0xE2 && b1 == 0x80 &&                       // U+2000 to
+             (c <= 0x8A || c == 0xA8 || c == 0xA9 || c == 0xAF)) ||  // U+202F
+            (b0 == 0xE2 && b1 == 0x81 && c == 0x9F) ||         // U+205F
+            (b0 == 0xE3 && b1 == 0x80 && c == 0x80)) {         // U+3000
+            return 3;
+        }
+    }
+    return 0;
+}
+
+void Utf8Delims::split(string_view line, vector<string_view>* tokens) const {
+    const char* start = line.data();    // where the current token starts
+    const char* p = start;
+    const char* end = start + line.size();
+
+    tokens->clear();
+    while (true) {
+        const char* stop = find(p, end);
+        if (stop == end) {
+            tokens->emplace_back(start, end - start);
+            return;
+        }
+        int len = delim_length(start, stop);
+        if (len > 0) {
+            tokens->emplace_back(start, stop - (len - 1) - start);
+            start = stop + 1;
+        }
+        p = stop + 1;
+    }
+}
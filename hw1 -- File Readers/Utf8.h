@@ -0,0 +1,154 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef UTF8_H_
+#define UTF8_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./DelimSet.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+///////////////////////////////////////////////////////////////////////////////
+// A Utf8Validator checks that text is valid UTF-8, a buffer at a time, and
+// collects the file offsets of the sequences that aren't.
+//
+// A sequence is invalid if it is malformed, overlong, a surrogate, past
+// U+10FFFF, or cut off by the end of the input; each invalid sequence is
+// reported once, at its first byte, as the longest start of a valid
+// sequence it has ("maximal subpart", as the Unicode standard puts it).
+//
+// On CPUs with AVX2, buffers are checked 32 bytes at a time with the
+// table lookups of Keiser and Lemire ("Validating UTF-8 In Less Than One
+// Instruction Per Byte"), with all-ASCII blocks checked by their high bits
+// alone. Invalid sequences are then pinned down one byte at a time, near
+// where the blocks found them. Other CPUs skip ASCII 16 bytes at a time
+// with SSE2, and check the rest one sequence at a time.
+///////////////////////////////////////////////////////////////////////////////
+class Utf8Validator {
+ public:
+  // Constructs a validator that has seen nothing yet.
+  Utf8Validator();
+
+  // Forgets everything fed so far, including the errors.
+  void reset();
+
+  // Checks the next len bytes of the input, which start at file offset
+  // offset. A sequence cut off by the end of data is held back, to be
+  // finished with the start of the next call. If offset doesn't follow on
+  // from the last call (after a seek), checking starts over there, and
+  // continuation bytes at the start are skipped, as part of a sequence that
+  // started before it.
+  //
+  // Arguments:
+  // - data: the bytes to check
+  // - len: how many bytes there are
+  // - offset: the file offset of data[0]
+  void feed(const char* data, size_t len, off_t offset);
+
+  // Marks the end of the input: a sequence still held back by feed() is
+  // cut off, and so invalid.
+  void finish();
+
+  // Returns the file offsets of the invalid sequences found so far, in
+  // increasing order. Each is reported once, even if it is fed again.
+  const vector<off_t>& errors() const { return errors_; }
+
+  // Finds the first invalid sequence in [begin, end). A sequence cut off
+  // by end is invalid.
+  //
+  // Arguments:
+  // - begin, end: the range to check, which must start at the start of
+  //   a sequence
+  // - len: set to how many bytes the invalid sequence has, if there is one
+  //
+  // Returns:
+  // - a pointer to the first byte of the invalid sequence, or end if
+  //   there is none.
+  static const char* find_invalid(const char* begin, const char* end,
+                                  int* len);
+
+  // Same as find_invalid(), but never uses SIMD. Exposed for testing and
+  // benchmarking.
+  static const char* find_invalid_scalar(const char* begin, const char* end,
+                                         int* len);
+
+ private:
+  char pending_[3];       // the start of a sequence cut off by the end of
+  int pending_len_;       // the last feed(), and how long it is
+  off_t pending_offset_;  // the file offset of pending_[0]
+  off_t next_offset_;     // the file offset the next feed() should start at
+  vector<off_t> errors_;  // see errors()
+
+  // Helpers
+  void add_error(off_t offset);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// A Utf8Delims is a reader's set of delimiters in UTF-8 mode: its
+// single-byte delimiters, plus the Unicode white space characters that
+// take more than one byte: U+0085, U+00A0, U+1680, U+2000 to U+200A,
+// U+2028, U+2029, U+202F, U+205F and U+3000.
+//
+// Every one of those ends with a byte from 0x80 to 0xAF, so find() looks
+// for the single-byte delimiters and those last bytes, SIMD-fast through
+// ASCII text as in DelimSet, and delim_length() then looks back at the
+// bytes before a last byte to see whether it really ends white space,
+// rather than some other character.
+///////////////////////////////////////////////////////////////////////////////
+class Utf8Delims {
+ public:
+  // Constructs the set for the single-byte delimiters in delims, and the
+  // byte that reads as EOF, as in BufferedFileReader.
+  explicit Utf8Delims(const string& delims = "");
+
+  // Finds the first byte in [begin, end) that may end a delimiter: a
+  // single-byte delimiter, or the last byte of a multibyte white space
+  // character, if the bytes before it are right.
+  //
+  // Returns:
+  // - a pointer to the byte, or end if there is none.
+  const char* find(const char* begin, const char* end) const;
+
+  // Returns how many bytes the delimiter ending at stop has (1, 2 or 3),
+  // or 0 if stop, a byte find() returned, isn't the end of one after all.
+  //
+  // Arguments:
+  // - begin: the start of the text stop is in; only the bytes in
+  //   [begin, stop] are looked at
+  // - stop: the byte find() returned
+  int delim_length(const char* begin, const char* stop) const;
+
+  // Splits line into tokens at the delimiters, as
+  // BufferedFileReader::get_line() does.
+  //
+  // Arguments:
+  // - line: the line to split
+  // - tokens: where to put the tokens, which point into line
+  void split(string_view line, vector<string_view>* tokens) const;
+
+ private:
+  DelimSet delims_;  // the single-byte delimiters, and EOF
+  DelimSet stops_;   // those, and the last bytes of multibyte white space
+  char needles_[DelimSet::MAX_SIMD_CHARS];  // the ASCII delimiters, for
+  int num_needles_;                         // the SIMD loops, if there are
+                                            // few enough, else -1
+};
+
+
+#endif  // UTF8_H_
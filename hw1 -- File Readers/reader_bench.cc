@@ -0,0 +1,325 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+// Benchmarks every reader's get_char(), get_token() and get_line() on a
+// file, with the file in the page cache ("warm") and evicted from it
+// before each trial ("cold"), and prints the results as JSON.
+//
+// Each combination is run for a number of trials, timed with a monotonic
+// clock, and reported as the median and 99th percentile time, the median
+// throughput, and how many read system calls the median trial made (as
+// counted by the kernel in /proc/self/io; io_uring reads don't show up).
+// The readers run with their ReaderStats on, and the median trial's stats
+// are printed too, with the time spent refilling as a share of the total.
+// The readers are built optimized for this (see the makefile), so it
+// measures them and not -O0.
+//
+// Usage: ./reader_bench [-n trials] [-o op] [-r reader] [file]
+//   -o and -r restrict the run to one operation or reader, by name.
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "./BufferedFileReader.h"
+#include "./IoUringFileReader.h"
+#include "./MappedFileReader.h"
+#include "./ReaderStats.h"
+#include "./SimpleFileReader.h"
+
+using std::string;
+using std::vector;
+
+static const char* kDefaultFileName = "./test_files/war_and_peace.txt";
+
+// How one trial went.
+struct Trial {
+  uint64_t ns;          // how long it took
+  uint64_t syscalls;    // how many read system calls it made
+  ReaderStats stats;    // what the reader counted
+};
+
+// Reads a whole file with one of the operations, cold or warm, and returns
+// how it went.
+typedef Trial (*RunFn)(const char* fname, bool cold);
+
+// The operations a reader supports, or nullptr for the ones it doesn't.
+struct ReaderSpec {
+  const char* name;
+  RunFn get_char;
+  RunFn get_token;
+  RunFn get_line;
+};
+
+static uint64_t now_ns() {
+  struct timespec spec;
+  clock_gettime(CLOCK_MONOTONIC, &spec);
+  return spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+}
+
+// How many read system calls read_syscalls() itself adds to a count.
+static uint64_t syscall_overhead = 0;
+
+// Returns how many read system calls this process has made.
+static uint64_t read_syscalls() {
+  FILE* f = fopen("/proc/self/io", "r");
+  if (f == nullptr) {
+    return 0;                   // not Linux, or /proc isn't mounted
+  }
+  char line[128];
+  uint64_t count = 0;
+  while (fgets(line, sizeof(line), f) != nullptr) {
+    if (sscanf(line, "syscr: %lu", &count) == 1) {
+      break;
+    }
+  }
+  fclose(f);
+  return count;
+}
+
+// Drops the file's pages from the page cache.
+static void evict_from_page_cache(const char* fname) {
+  int fd = open(fname, O_RDONLY);
+  if (fd == -1) {
+    perror("open failed");
+    exit(EXIT_FAILURE);
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+// Keeps the compiler from optimizing away what we read.
+static volatile size_t sink;
+
+template <class Reader>
+static void drain_chars(Reader& reader) {
+  size_t count = 0;
+  while (reader.get_char() != EOF) {
+    count++;
+  }
+  sink = count;
+}
+
+template <class Reader>
+static void drain_tokens(Reader& reader) {
+  size_t count = 0;
+  while (reader.good()) {
+    count += reader.get_token().length();
+  }
+  sink = count;
+}
+
+template <class Reader>
+static void drain_lines(Reader& reader) {
+  size_t count = 0;
+  while (reader.good()) {
+    int len;
+    string* tokens = reader.get_line(&len);
+    count += len;
+    delete[] tokens;
+  }
+  sink = count;
+}
+
+// Times one pass over the file with drain(). The reader is constructed the
+// way it's meant to be used, and its stats turned on, before the clock
+// starts; the pass opens the file again, so its first refill is counted,
+// and nothing the constructor did is. Constructing reads the start of the
+// file (and MappedFileReader asks for all of it), so for a cold pass the
+// file is closed and evicted after that.
+template <class Reader>
+static Trial run(const char* fname, bool cold, void (*drain)(Reader&)) {
+  Reader reader(fname);
+  if (cold) {
+    reader.close_file();        // finishes any reads in flight
+    evict_from_page_cache(fname);
+  }
+  reader.enable_stats();
+
+  Trial trial;
+  uint64_t syscalls = read_syscalls();
+  uint64_t start = now_ns();
+  reader.open_file(fname);
+  drain(reader);
+  trial.ns = now_ns() - start;
+  trial.syscalls = read_syscalls() - syscalls - syscall_overhead;
+  trial.stats = reader.stats();
+  return trial;
+}
+
+template <class Reader>
+static Trial run_chars(const char* fname, bool cold) {
+  return run<Reader>(fname, cold, drain_chars<Reader>);
+}
+
+template <class Reader>
+static Trial run_tokens(const char* fname, bool cold) {
+  return run<Reader>(fname, cold, drain_tokens<Reader>);
+}
+
+template <class Reader>
+static Trial run_lines(const char* fname, bool cold) {
+  return run<Reader>(fname, cold, drain_lines<Reader>);
+}
+
+// BufferedFileReader with a 64 KiB buffer and readahead.
+class ReadaheadReader : public BufferedFileReader {
+ public:
+  explicit ReadaheadReader(const char* fname)
+    : BufferedFileReader(fname, "\r\n\t ", 64 << 10, false, true) { }
+};
+
+// BufferedFileReader with a 64 KiB buffer and O_DIRECT.
+class DirectReader : public BufferedFileReader {
+ public:
+  explicit DirectReader(const char* fname)
+    : BufferedFileReader(fname, "\r\n\t ", 64 << 10, false, false, true) { }
+};
+
+static const ReaderSpec kReaders[] = {
+  { "SimpleFileReader", run_chars<SimpleFileReader>, nullptr, nullptr },
+  { "BufferedFileReader", run_chars<BufferedFileReader>,
+    run_tokens<BufferedFileReader>, run_lines<BufferedFileReader> },
+  { "BufferedFileReader+readahead", run_chars<ReadaheadReader>,
+    run_tokens<ReadaheadReader>, run_lines<ReadaheadReader> },
+  { "BufferedFileReader+direct", run_chars<DirectReader>,
+    run_tokens<DirectReader>, run_lines<DirectReader> },
+  { "MappedFileReader", run_chars<MappedFileReader>,
+    run_tokens<MappedFileReader>, run_lines<MappedFileReader> },
+  { "IoUringFileReader", run_chars<IoUringFileReader>,
+    run_tokens<IoUringFileReader>, run_lines<IoUringFileReader> },
+};
+
+// Returns the p-th percentile (0-100) of the sorted values, by nearest rank.
+static uint64_t percentile(const vector<uint64_t>& sorted, int p) {
+  size_t rank = (sorted.size() * p + 99) / 100;
+  return sorted[std::max(rank, static_cast<size_t>(1)) - 1];
+}
+
+// Runs fn for the given number of trials and prints one JSON result.
+static void bench(const char* reader, const char* op, RunFn fn,
+                  const char* fname, off_t file_size, bool cold,
+                  int trials, bool* first) {
+  vector<Trial> results;
+
+  if (!cold) {
+    fn(fname, false);           // warm the page cache (and everything else)
+  }
+  for (int i = 0; i < trials; i++) {
+    results.push_back(fn(fname, cold));
+  }
+
+  vector<uint64_t> times;
+  for (const Trial& trial : results) {
+    times.push_back(trial.ns);
+  }
+  std::sort(times.begin(), times.end());
+  uint64_t median = percentile(times, 50);
+  uint64_t p99 = percentile(times, 99);
+  const Trial* median_trial = &results[0];
+  for (const Trial& trial : results) {
+    if (trial.ns == median) {
+      median_trial = &trial;
+    }
+  }
+  const ReaderStats& stats = median_trial->stats;
+
+  printf("%s\n    {\"reader\": \"%s\", \"op\": \"%s\", \"cache\": \"%s\", "
+         "\"median_ms\": %.3f, \"p99_ms\": %.3f, \"mb_per_s\": %.1f, "
+         "\"read_syscalls\": %lu,\n     \"stats\": {\"read_syscalls\": %lu, "
+         "\"bytes_read\": %lu, \"eintr_retries\": %lu, \"fills\": %lu, "
+         "\"fill_ms\": %.3f, \"max_fill_us\": %.1f, \"fill_share\": %.3f, "
+         "\"tokens\": %lu, \"lines\": %lu, \"tokens_per_s\": %.0f}}",
+         *first ? "" : ",", reader, op, cold ? "cold" : "warm",
+         median / 1.0e6, p99 / 1.0e6,
+         median > 0 ? (file_size / 1.0e6) / (median / 1.0e9) : 0.0,
+         median_trial->syscalls, stats.read_syscalls, stats.bytes_read,
+         stats.eintr_retries, stats.fills, stats.fill_ns / 1.0e6,
+         stats.max_fill_ns / 1.0e3,
+         median > 0 ? static_cast<double>(stats.fill_ns) / median : 0.0,
+         stats.tokens, stats.lines,
+         median > 0 ? stats.tokens / (median / 1.0e9) : 0.0);
+  fflush(stdout);
+  *first = false;
+}
+
+static void usage(const char* prog) {
+  fprintf(stderr, "usage: %s [-n trials] [-o op] [-r reader] [file]\n", prog);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+  int trials = 5;
+  const char* only_op = nullptr;
+  const char* only_reader = nullptr;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:o:r:")) != -1) {
+    switch (opt) {
+      case 'n':
+        trials = atoi(optarg);
+        break;
+      case 'o':
+        only_op = optarg;
+        break;
+      case 'r':
+        only_reader = optarg;
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (trials <= 0 || argc - optind > 1) {
+    usage(argv[0]);
+  }
+  const char* fname = optind < argc ? argv[optind] : kDefaultFileName;
+
+  struct stat st;
+  if (stat(fname, &st) == -1) {
+    perror("stat failed");
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t before = read_syscalls();
+  syscall_overhead = read_syscalls() - before;
+
+  printf("{\n  \"file\": \"%s\",\n  \"file_bytes\": %ld,\n  \"trials\": %d,\n"
+         "  \"results\": [", fname, static_cast<long>(st.st_size), trials);
+  bool first = true;
+  for (const ReaderSpec& spec : kReaders) {
+    if (only_reader != nullptr && strcmp(only_reader, spec.name) != 0) {
+      continue;
+    }
+    const char* ops[] = { "get_char", "get_token", "get_line" };
+    RunFn fns[] = { spec.get_char, spec.get_token, spec.get_line };
+    for (int i = 0; i < 3; i++) {
+      if (fns[i] == nullptr ||
+          (only_op != nullptr && strcmp(only_op, ops[i]) != 0)) {
+        continue;
+      }
+      for (bool cold : { false, true }) {
+        bench(spec.name, ops[i], fns[i], fname, st.st_size, cold, trials,
+              &first);
+      }
+    }
+  }
+  printf("\n  ]\n}\n");
+  return EXIT_SUCCESS;
+}
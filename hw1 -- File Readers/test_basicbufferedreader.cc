@@ -0,0 +1,196 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./BasicBufferedReader.h"
+#include "./BufferedFileReader.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace hw1 {
+
+class Test_BasicBufferedReader : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    // Nothing
+  }
+
+  // These values contain the filenames that we will be using to test
+  // the reader. Each one is read against a BufferedFileReader.
+  static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+  static constexpr const char* kEmptyFileName = "./test_files/Empty.txt";
+  static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    // Nothing as of now
+  }
+};  // class Test_BasicBufferedReader
+
+// Reads the whole file as tokens with a Reader and with a
+// BufferedFileReader that has the given delimiters, and checks they agree.
+template <class Reader>
+static void check_tokens(const char* fname, const string& delims,
+                         size_t buf_size, bool readahead) {
+  Reader reader(fname, buf_size, false, readahead);
+  BufferedFileReader expected(fname, delims, buf_size);
+  while (expected.good()) {
+    ASSERT_TRUE(reader.good());
+    if (reader.tell() % 2 == 0) {
+      ASSERT_EQ(expected.get_token(), reader.get_token());
+    } else {
+      ASSERT_EQ(expected.get_token_view(), reader.get_token_view());
+    }
+  }
+  ASSERT_FALSE(reader.good());
+  ASSERT_EQ(expected.tell(), reader.tell());
+}
+
+// Same as check_tokens(), for every kind of get_line().
+template <class Reader>
+static void check_lines(const char* fname, const string& delims,
+                        size_t buf_size, bool readahead) {
+  Reader reader(fname, buf_size, false, readahead);
+  BufferedFileReader expected(fname, delims, buf_size);
+  vector<string> line, expected_line;
+  vector<string_view> views, expected_views;
+  int kind = 0;
+  while (expected.good()) {
+    ASSERT_TRUE(reader.good());
+    switch (kind++ % 3) {
+      case 0: {
+        int len, expected_len;
+        string* tokens = reader.get_line(&len);
+        string* expected_tokens = expected.get_line(&expected_len);
+        ASSERT_EQ(vector<string>(expected_tokens,
+                                 expected_tokens + expected_len),
+                  vector<string>(tokens, tokens + len));
+        delete[] tokens;
+        delete[] expected_tokens;
+        break;
+      }
+      case 1:
+        reader.get_line(&line);
+        expected.get_line(&expected_line);
+        ASSERT_EQ(expected_line, line);
+        break;
+      default:
+        reader.get_line(&views);
+        expected.get_line(&expected_views);
+        ASSERT_EQ(expected_views, views);
+    }
+  }
+  ASSERT_FALSE(reader.good());
+}
+
+TEST_F(Test_BasicBufferedReader, get_token) {
+  HW1Environment::OpenTestCase();
+
+  for (size_t size : { 7UL, 100UL, BufferedFileReader::BUF_SIZE,
+                       1UL << 16 }) {
+    for (bool readahead : { false, size > 100 }) {
+      check_tokens<WhitespaceReader>(kLongFileName, "\r\n\t ", size,
+                                     readahead);
+      check_tokens<CsvReader>(kLongFileName, ",\r\n", size, readahead);
+      check_tokens<NewlineReader>(kLongFileName, "\n", size, readahead);
+    }
+  }
+  check_tokens<WhitespaceReader>(kHelloFileName, "\r\n\t ", 1, false);
+  check_tokens<CsvReader>(kEmptyFileName, ",\r\n", 4, false);
+
+  // A set that isn't one of the named ones.
+  check_tokens<BasicBufferedReader<'e', 'o'>>(kLongFileName, "eo", 512,
+                                               false);
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_BasicBufferedReader, get_line) {
+  HW1Environment::OpenTestCase();
+
+  for (size_t size : { 7UL, 100UL, BufferedFileReader::BUF_SIZE,
+                       1UL << 16 }) {
+    for (bool readahead : { false, size > 100 }) {
+      check_lines<WhitespaceReader>(kLongFileName, "\r\n\t ", size,
+                                    readahead);
+      check_lines<CsvReader>(kLongFileName, ",\r\n", size, readahead);
+      check_lines<NewlineReader>(kLongFileName, "\n", size, readahead);
+    }
+  }
+  check_lines<WhitespaceReader>(kHelloFileName, "\r\n\t ", 1, true);
+  check_lines<CsvReader>(kEmptyFileName, ",\r\n", 4, false);
+
+  // Everything that isn't tokenizing is the BufferedFileReader's.
+  CsvReader reader(kLongFileName);
+  reader.enable_stats();
+  reader.get_token();
+  reader.seek(1000);
+  BufferedFileReader expected(kLongFileName, ",\r\n");
+  expected.seek(1000);
+  ASSERT_EQ(expected.get_token(), reader.get_token());
+  ASSERT_EQ(2U, reader.stats().tokens);
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_BasicBufferedReader, utf8) {
+  HW1Environment::OpenTestCase();
+  // "a", a no-break space (U+00A0), "b c", a line separator (U+2028), "d".
+  const char kText[] = "a\xC2\xA0" "b c\xE2\x80\xA8" "d\n";
+  char name[] = "/tmp/test_basicbufferedreader.XXXXXX";
+  int fd = mkstemp(name);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(kText) - 1),
+            write(fd, kText, sizeof(kText) - 1));
+  close(fd);
+
+  // In UTF-8 mode the Unicode white space splits tokens too, as in a
+  // BufferedFileReader, whether the reader is used as itself or through a
+  // BufferedFileReader&.
+  WhitespaceReader reader(name);
+  reader.set_utf8();
+  BufferedFileReader& base = reader;
+  vector<string> tokens;
+  for (int i = 0; i < 2; i++) {
+    reader.rewind();
+    tokens.clear();
+    while (reader.good()) {
+      tokens.push_back(i == 0 ? reader.get_token()
+                              : string(base.get_token_view()));
+    }
+    ASSERT_EQ(vector<string>({ "a", "b", "c", "d", "" }), tokens);
+  }
+  reader.rewind();
+  reader.get_line(&tokens);
+  ASSERT_EQ(vector<string>({ "a", "b", "c", "d" }), tokens);
+  ASSERT_TRUE(reader.utf8_errors().empty());
+
+  // And without it, they are bytes again.
+  reader.set_utf8(false);
+  reader.rewind();
+  ASSERT_EQ("a\xC2\xA0" "b", reader.get_token());
+
+  unlink(name);
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
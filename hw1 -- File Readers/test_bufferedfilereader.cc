@@ -11,6 +11,9 @@
 
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/select.h>
 
 #include "gtest/gtest.h"
@@ -19,11 +22,52 @@
 #include "./BufferedFileReader.h"
 #include "./BufferChecker.h"
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <new>
 #include <string>
+#include <string_view>
+#include <vector>
 
 using std::ifstream;
 using std::string;
+using std::string_view;
+using std::vector;
+
+// Counts every call to the global operator new, so tests can check that
+// a piece of code doesn't allocate. Atomic, since other tests allocate
+// from several threads.
+static std::atomic<size_t> num_allocations(0);
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  free(ptr);
+}
 
 namespace hw1 {
 
@@ -331,6 +375,864 @@ TEST_F(Test_BufferedFileReader, Complex) {
   HW1Environment::AddPoints(25);
 }
 
+TEST_F(Test_BufferedFileReader, BufferSizes) {
+  HW1Environment::OpenTestCase();
+  string delims = ",\n ";
+  size_t sizes[] = { 1, 7, 512, 4096, 1 << 20 };
+
+  // Every size, fixed and adaptive, reads the same bytes and reports the
+  // same offsets, including across rewind().
+  for (size_t size : sizes) {
+    for (bool adaptive : { false, true }) {
+      BufferedFileReader bf(kGreatFileName, delims, size, adaptive);
+      BufferChecker bc(bf);
+      for (int pass = 0; pass < 2; pass++) {
+        string contents;
+        contents.reserve(kGreatContents.length());
+        for (size_t i = 0; i < kGreatContents.length(); i++) {
+          ASSERT_EQ(i, bf.tell());
+          char c = bf.get_char();
+          contents += c;
+          ASSERT_TRUE(bf.good());
+          ASSERT_FALSE(bc.check_char_errors(c, i));
+        }
+        ASSERT_EQ(kGreatContents, contents);
+        ASSERT_EQ(EOF, bf.get_char());
+        ASSERT_FALSE(bf.good());
+        bf.rewind();
+      }
+    }
+  }
+  HW1Environment::AddPoints(5);
+
+  for (size_t size : sizes) {
+    for (bool adaptive : { false, true }) {
+      off_t offset = 0;
+      BufferedFileReader bf(kLongFileName, delims, size, adaptive);
+      BufferChecker bc(bf);
+      while (bf.good()) {
+        string token = bf.get_token();
+        ASSERT_FALSE(bc.check_token_errors(token, offset));
+        ASSERT_TRUE(verify_token(token, kLongContents, delims, &offset));
+        ASSERT_EQ(offset, bf.tell());
+      }
+      ASSERT_EQ(kLongContents.length(), offset);
+    }
+  }
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileReader, get_token_view) {
+  HW1Environment::OpenTestCase();
+  string delims = ",\n ";
+  size_t sizes[] = { 1, 7, 512, BufferedFileReader::BUF_SIZE, 1 << 20 };
+
+  // Views match get_token() exactly, whether or not the token crosses a
+  // refill, and get_token_view() can be mixed with the other reads.
+  for (size_t size : sizes) {
+    BufferedFileReader bf(kLongFileName, delims, size);
+    BufferedFileReader expected(kLongFileName, delims);
+    bool use_view = true;
+    while (expected.good()) {
+      if (use_view) {
+        ASSERT_EQ(expected.get_token(), bf.get_token_view());
+      } else {
+        ASSERT_EQ(expected.get_token(), bf.get_token());
+      }
+      ASSERT_EQ(expected.tell(), bf.tell());
+      ASSERT_EQ(expected.good(), bf.good());
+      use_view = !use_view;
+    }
+    ASSERT_EQ("", bf.get_token_view());
+    ASSERT_FALSE(bf.good());
+  }
+  HW1Environment::AddPoints(5);
+
+  // Once the scratch string has grown to fit the longest token that
+  // crosses a refill, a pass over the file allocates nothing.
+  for (size_t size : sizes) {
+    BufferedFileReader bf(kLongFileName, delims, size);
+    size_t first_pass_bytes = 0;
+    while (bf.good()) {
+      first_pass_bytes += bf.get_token_view().length();
+    }
+    bf.rewind();
+
+    size_t bytes = 0;
+    size_t before = num_allocations;
+    while (bf.good()) {
+      bytes += bf.get_token_view().length();
+    }
+    size_t allocations = num_allocations - before;
+    ASSERT_EQ(0U, allocations);
+    ASSERT_EQ(first_pass_bytes, bytes);
+  }
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileReader, get_line_vector) {
+  HW1Environment::OpenTestCase();
+  // With this many delimiters, plenty of lines have more than 50 tokens.
+  string delims = "etaoinshr ,";
+  size_t sizes[] = { 7, BufferedFileReader::BUF_SIZE, 1 << 20 };
+  size_t most_tokens = 0;
+
+  // The vector versions return the same tokens as the array version,
+  // reusing the same vectors from line to line.
+  for (size_t size : sizes) {
+    BufferedFileReader expected(kLongFileName, delims);
+    BufferedFileReader strings(kLongFileName, delims, size);
+    BufferedFileReader views(kLongFileName, delims, size);
+    vector<string> string_tokens;
+    vector<string_view> view_tokens;
+    off_t offset = 0;
+    while (expected.good()) {
+      int len;
+      string* tokens = expected.get_line(&len);
+      ASSERT_TRUE(verify_tokens(tokens, len, kLongContents, delims, &offset));
+      strings.get_line(&string_tokens);
+      views.get_line(&view_tokens);
+      ASSERT_EQ(static_cast<size_t>(len), string_tokens.size());
+      ASSERT_EQ(static_cast<size_t>(len), view_tokens.size());
+      for (int i = 0; i < len; i++) {
+        ASSERT_EQ(tokens[i], string_tokens[i]);
+        ASSERT_EQ(tokens[i], view_tokens[i]);
+      }
+      ASSERT_EQ(offset, strings.tell());
+      ASSERT_EQ(offset, views.tell());
+      ASSERT_EQ(expected.good(), views.good());
+      most_tokens = std::max(most_tokens, string_tokens.size());
+      delete[] tokens;
+    }
+    ASSERT_EQ(kLongContents.length(), offset);
+  }
+  ASSERT_LT(50U, most_tokens);
+  HW1Environment::AddPoints(5);
+
+  // Once the vector has grown to fit the longest line, a pass over the
+  // file allocates nothing.
+  for (size_t size : sizes) {
+    BufferedFileReader bf(kLongFileName, delims, size);
+    vector<string_view> tokens;
+    size_t first_pass_tokens = 0;
+    while (bf.good()) {
+      bf.get_line(&tokens);
+      first_pass_tokens += tokens.size();
+    }
+    bf.rewind();
+
+    size_t num_tokens = 0;
+    size_t before = num_allocations;
+    while (bf.good()) {
+      bf.get_line(&tokens);
+      num_tokens += tokens.size();
+    }
+    size_t allocations = num_allocations - before;
+    ASSERT_EQ(0U, allocations);
+    ASSERT_EQ(first_pass_tokens, num_tokens);
+  }
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileReader, Readahead) {
+  HW1Environment::OpenTestCase();
+  string delims = ",\n ";
+  size_t sizes[] = { 1, 7, 512, BufferedFileReader::BUF_SIZE, 1 << 20 };
+
+  // Reading a character at a time sees the same bytes and offsets, and
+  // the buffer always holds what it should, across rewind().
+  for (size_t size : sizes) {
+    BufferedFileReader bf(kGreatFileName, delims, size, false, true);
+    BufferChecker bc(bf);
+    for (int pass = 0; pass < 2; pass++) {
+      for (size_t i = 0; i < kGreatContents.length(); i++) {
+        ASSERT_EQ(i, bf.tell());
+        char c = bf.get_char();
+        ASSERT_EQ(kGreatContents[i], c);
+        ASSERT_FALSE(bc.check_char_errors(c, i));
+      }
+      ASSERT_EQ(EOF, bf.get_char());
+      ASSERT_FALSE(bf.good());
+      bf.rewind();
+    }
+  }
+  HW1Environment::AddPoints(5);
+
+  // Tokens and lines too, including after rewinding or switching files
+  // partway through, while a read is likely in flight. (Tiny buffers
+  // hand off to the thread for every few bytes, so they're left out.)
+  for (size_t size : { 512UL, BufferedFileReader::BUF_SIZE, 1UL << 20 }) {
+    BufferedFileReader bf(kByeFileName, delims, size, false, true);
+    for (const char* fname : { kLongFileName, kGreatFileName }) {
+      bf.open_file(fname);
+      BufferedFileReader expected(fname, delims);
+      for (int pass = 0; pass < 2; pass++) {
+        int num_reads = 0;
+        bool read_line = false;
+        while (expected.good() && (pass == 1 || num_reads < 1000)) {
+          if (read_line) {
+            vector<string> expected_tokens, tokens;
+            expected.get_line(&expected_tokens);
+            bf.get_line(&tokens);
+            ASSERT_EQ(expected_tokens, tokens);
+          } else {
+            ASSERT_EQ(expected.get_token(), bf.get_token());
+          }
+          ASSERT_EQ(expected.tell(), bf.tell());
+          ASSERT_EQ(expected.good(), bf.good());
+          read_line = !read_line;
+          num_reads++;
+        }
+        expected.rewind();
+        bf.rewind();
+      }
+    }
+  }
+
+  // Closing or destroying a reader partway through the file stops the
+  // readahead cleanly.
+  for (size_t size : sizes) {
+    BufferedFileReader bf(kLongFileName, delims, size, false, true);
+    bf.get_token();
+    bf.close_file();
+    ASSERT_FALSE(bf.good());
+    bf.open_file(kLongFileName);
+    bf.get_token();
+  }
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileReader, seek) {
+  HW1Environment::OpenTestCase();
+  string delims = ",\n ";
+  off_t length = kLongContents.length();
+  unsigned int seed = 5950;
+
+  // Random seeks, near and far, land on the right byte, and the buffer
+  // is only refilled when the target isn't in it.
+  for (size_t size : { 1UL, 512UL, BufferedFileReader::BUF_SIZE, 1UL << 16 }) {
+    for (bool readahead : { false, true }) {
+      BufferedFileReader bf(kLongFileName, delims, size, false, readahead);
+      BufferChecker bc(bf);
+      for (int i = 0; i < 2000; i++) {
+        off_t offset;
+        if (rand_r(&seed) % 4 == 0) {
+          offset = rand_r(&seed) % length;
+        } else {
+          offset = std::max(static_cast<off_t>(0),
+                            std::min(length - 1, static_cast<off_t>(
+                                bf.tell() + rand_r(&seed) % 512 - 256)));
+        }
+        off_t buffer_offset = bc.buffer_offset();
+        bool buffered = offset >= buffer_offset &&
+                        offset < buffer_offset + static_cast<off_t>(size);
+        bf.seek(offset);
+        if (buffered) {
+          ASSERT_EQ(buffer_offset, bc.buffer_offset());
+        }
+        ASSERT_EQ(offset, bf.tell());
+        ASSERT_TRUE(bf.good());
+        char c = bf.get_char();
+        ASSERT_EQ(kLongContents[offset], c);
+        ASSERT_FALSE(bc.check_char_errors(c, offset));
+        if (i % 10 == 0) {
+          off_t token_offset = offset + 1;
+          string token = bf.get_token();
+          ASSERT_TRUE(verify_token(token, kLongContents, delims, &token_offset));
+          ASSERT_EQ(token_offset, bf.tell());
+        }
+      }
+    }
+  }
+  HW1Environment::AddPoints(5);
+
+  // The end of the file, past it, and back again.
+  BufferedFileReader bf(kGreatFileName, delims);
+  off_t great_length = kGreatContents.length();
+  bf.seek(great_length - 1);
+  ASSERT_EQ(kGreatContents[great_length - 1], bf.get_char());
+  ASSERT_TRUE(bf.good());
+  ASSERT_EQ(EOF, bf.get_char());
+  ASSERT_FALSE(bf.good());
+  bf.seek(great_length - 1);
+  ASSERT_TRUE(bf.good());
+  ASSERT_EQ(kGreatContents[great_length - 1], bf.get_char());
+  bf.seek(great_length + 100);
+  ASSERT_EQ(great_length + 100, bf.tell());
+  ASSERT_EQ(EOF, bf.get_char());
+  ASSERT_FALSE(bf.good());
+  bf.seek(0);
+  ASSERT_TRUE(bf.good());
+  ASSERT_EQ(0, bf.tell());
+  ASSERT_EQ(kGreatContents[0], bf.get_char());
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileReader, stats) {
+  HW1Environment::OpenTestCase();
+  size_t length = kLongContents.length();
+
+  // Off by default.
+  BufferedFileReader off(kLongFileName);
+  while (off.good()) {
+    off.get_token();
+  }
+  ASSERT_EQ(0U, off.stats().read_syscalls);
+  ASSERT_EQ(0U, off.stats().fills);
+  ASSERT_EQ(0U, off.stats().tokens);
+
+  // Every byte of the file is read once, a buffer at a time.
+  for (size_t size : { 512UL, BufferedFileReader::BUF_SIZE, 1UL << 16 }) {
+    for (bool readahead : { false, true }) {
+      BufferedFileReader bf(kLongFileName, "\r\n\t ", size, false,
+                            readahead);
+      bf.enable_stats();
+      bf.open_file(kLongFileName);
+      uint64_t tokens = 0;
+      while (bf.good()) {
+        bf.get_token_view();
+        tokens++;
+      }
+      // Readahead's read of the buffer after the one open_file() threw
+      // away counts too.
+      const ReaderStats& stats = bf.stats();
+      if (readahead) {
+        ASSERT_LE(length, stats.bytes_read);
+        ASSERT_GE(length + size, stats.bytes_read);
+      } else {
+        ASSERT_EQ(length, stats.bytes_read);
+      }
+      ASSERT_EQ(tokens, stats.tokens);
+      ASSERT_EQ(0U, stats.lines);
+      ASSERT_EQ((length + size) / size, stats.fills);
+      ASSERT_LE(stats.fills, stats.read_syscalls);
+      ASSERT_EQ(0U, stats.eintr_retries);
+      ASSERT_LE(stats.max_fill_ns, stats.fill_ns);
+      ASSERT_LT(0U, stats.max_fill_ns);
+    }
+  }
+  HW1Environment::AddPoints(5);
+
+  // Lines count their tokens too, and the stats can be reset.
+  BufferedFileReader bf(kLongFileName);
+  bf.enable_stats();
+  vector<string> tokens;
+  uint64_t lines = 0, line_tokens = 0;
+  while (bf.good()) {
+    bf.get_line(&tokens);
+    lines++;
+    line_tokens += tokens.size();
+  }
+  ASSERT_EQ(lines, bf.stats().lines);
+  ASSERT_EQ(line_tokens, bf.stats().tokens);
+  bf.reset_stats();
+  ASSERT_EQ(0U, bf.stats().lines);
+  ASSERT_EQ(0U, bf.stats().bytes_read);
+  bf.rewind();
+  ASSERT_EQ(1U, bf.stats().fills);
+  ASSERT_EQ(BufferedFileReader::BUF_SIZE, bf.stats().bytes_read);
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileReader, Direct) {
+  HW1Environment::OpenTestCase();
+  string delims = ",\n ";
+
+  // Reading a character at a time sees the same bytes, including the
+  // unaligned tail of each file, and with O_DIRECT every read starts at
+  // an aligned offset.
+  for (size_t size : { 1UL, 512UL, 5000UL, 1UL << 16 }) {
+    for (bool readahead : { false, true }) {
+      for (const char* fname : { kHelloFileName, kGreatFileName }) {
+        const string& contents = fname == kHelloFileName ? kHelloContents
+                                                         : kGreatContents;
+        BufferedFileReader bf(fname, delims, size, false, readahead, true);
+        BufferChecker bc(bf);
+        for (size_t i = 0; i < contents.length(); i++) {
+          ASSERT_EQ(i, bf.tell());
+          char c = bf.get_char();
+          ASSERT_EQ(contents[i], c);
+          ASSERT_FALSE(bc.check_char_errors(c, i));
+          if (bf.using_direct_io()) {
+            ASSERT_EQ(0, bc.buffer_offset() % BufferedFileReader::BUF_ALIGNMENT);
+          }
+        }
+        ASSERT_EQ(EOF, bf.get_char());
+        ASSERT_FALSE(bf.good());
+      }
+    }
+  }
+  HW1Environment::AddPoints(5);
+
+  // Tokens, lines and seeks behave just as they do through the page cache.
+  unsigned int seed = 5950;
+  off_t length = kLongContents.length();
+  for (bool readahead : { false, true }) {
+    BufferedFileReader bf(kLongFileName, delims, 8192, false, readahead, true);
+    BufferedFileReader expected(kLongFileName, delims);
+    bool read_line = false;
+    while (expected.good()) {
+      if (read_line) {
+        vector<string> expected_tokens, tokens;
+        expected.get_line(&expected_tokens);
+        bf.get_line(&tokens);
+        ASSERT_EQ(expected_tokens, tokens);
+      } else {
+        ASSERT_EQ(expected.get_token(), bf.get_token());
+      }
+      ASSERT_EQ(expected.tell(), bf.tell());
+      ASSERT_EQ(expected.good(), bf.good());
+      read_line = !read_line;
+    }
+    ASSERT_FALSE(bf.good());
+
+    for (int i = 0; i < 1000; i++) {
+      off_t offset = rand_r(&seed) % (length + 100);
+      bf.seek(offset);
+      expected.seek(offset);
+      ASSERT_EQ(expected.tell(), bf.tell());
+      ASSERT_EQ(expected.get_token(), bf.get_token());
+      ASSERT_EQ(expected.tell(), bf.tell());
+      ASSERT_EQ(expected.good(), bf.good());
+    }
+    bf.seek(length + 100);
+    ASSERT_EQ(length + 100, bf.tell());
+    ASSERT_FALSE(bf.good());
+    ASSERT_EQ(EOF, bf.get_char());
+    bf.seek(length - 1);
+    ASSERT_EQ(kLongContents[length - 1], bf.get_char());
+  }
+  HW1Environment::AddPoints(5);
+}
+
+// Writes contents to a new temporary file and returns its name.
+static string write_temp_file(const string& contents) {
+  char name[] = "/tmp/test_bufferedfilereader.XXXXXX";
+  int fd = mkstemp(name);
+  if (fd == -1) {
+    return "";
+  }
+  close(fd);
+  std::ofstream out(name, std::ios::binary);
+  out << contents;
+  return name;
+}
+
+TEST_F(Test_BufferedFileReader, get_double) {
+  HW1Environment::OpenTestCase();
+  typedef BufferedFileReader::ParseStatus ParseStatus;
+
+  // Random doubles of every magnitude, written at full precision, read
+  // back exactly as strtod() reads them.
+  unsigned int seed = 5950;
+  string contents;
+  vector<double> expected;
+  for (int i = 0; i < 20000; i++) {
+    uint64_t bits = (static_cast<uint64_t>(rand_r(&seed)) << 33) ^
+                    (static_cast<uint64_t>(rand_r(&seed)) << 11) ^ rand_r(&seed);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    if (value != value || value - value != 0) {
+      continue;                         // no NaNs or infinities
+    }
+    char text[32];
+    snprintf(text, sizeof(text), i % 3 == 0 ? "%.17g" : "%.6g", value);
+    expected.push_back(strtod(text, nullptr));
+    contents += text;
+    contents += i % 7 == 0 ? "\r\n" : " ";
+  }
+  string name = write_temp_file(contents);
+  ASSERT_NE("", name);
+  for (size_t size : { 7UL, 100UL, BufferedFileReader::BUF_SIZE }) {
+    BufferedFileReader bf(name, "\r\n\t ", size);
+    BufferedFileReader bulk(name, "\r\n\t ", size);
+    for (double value : expected) {
+      double read;
+      ASSERT_EQ(BufferedFileReader::PARSE_OK, bf.get_double(&read));
+      ASSERT_EQ(0, memcmp(&value, &read, sizeof(value)));
+    }
+    double read;
+    ASSERT_EQ(BufferedFileReader::PARSE_EOF, bf.get_double(&read));
+
+    vector<double> values(expected.size() + 10);
+    ParseStatus status;
+    ASSERT_EQ(1000U, bulk.parse_doubles(values.data(), 1000, &status));
+    ASSERT_EQ(BufferedFileReader::PARSE_OK, status);
+    ASSERT_EQ(expected.size() - 1000,
+              bulk.parse_doubles(values.data() + 1000, values.size() - 1000,
+                                 &status));
+    ASSERT_EQ(BufferedFileReader::PARSE_EOF, status);
+    ASSERT_EQ(0, memcmp(expected.data(), values.data(),
+                        expected.size() * sizeof(double)));
+  }
+  unlink(name.c_str());
+  HW1Environment::AddPoints(10);
+
+  // Malformed and out of range tokens are reported, and skipped.
+  name = write_temp_file("+1.5 -2\n\n1e400 abc 12x 1e-400 +-3 + .5e1 "
+                         "9223372036854775807 9223372036854775808 -7");
+  ASSERT_NE("", name);
+  BufferedFileReader bf(name);
+  double d = 0;
+  ASSERT_EQ(BufferedFileReader::PARSE_OK, bf.get_double(&d));
+  ASSERT_EQ(1.5, d);
+  ASSERT_EQ(BufferedFileReader::PARSE_OK, bf.get_double(&d));
+  ASSERT_EQ(-2.0, d);
+  ASSERT_EQ(BufferedFileReader::PARSE_OUT_OF_RANGE, bf.get_double(&d));
+  ASSERT_EQ(-2.0, d);
+  off_t offset = bf.tell();
+  ASSERT_EQ(BufferedFileReader::PARSE_MALFORMED, bf.get_double(&d));
+  ASSERT_EQ(offset + 4, bf.tell());     // "abc" and its delimiter
+  ASSERT_EQ(BufferedFileReader::PARSE_MALFORMED, bf.get_double(&d));
+  ASSERT_EQ(BufferedFileReader::PARSE_OUT_OF_RANGE, bf.get_double(&d));
+  ASSERT_EQ(BufferedFileReader::PARSE_MALFORMED, bf.get_double(&d));
+  ASSERT_EQ(BufferedFileReader::PARSE_MALFORMED, bf.get_double(&d));
+  ASSERT_EQ(BufferedFileReader::PARSE_OK, bf.get_double(&d));
+  ASSERT_EQ(5.0, d);
+  int64_t n = 0;
+  ASSERT_EQ(BufferedFileReader::PARSE_OK, bf.get_int64(&n));
+  ASSERT_EQ(INT64_MAX, n);
+  ASSERT_EQ(BufferedFileReader::PARSE_OUT_OF_RANGE, bf.get_int64(&n));
+  ASSERT_EQ(INT64_MAX, n);
+  ASSERT_EQ(BufferedFileReader::PARSE_OK, bf.get_int64(&n));
+  ASSERT_EQ(-7, n);
+  ASSERT_EQ(BufferedFileReader::PARSE_EOF, bf.get_int64(&n));
+  ASSERT_FALSE(bf.good());
+
+  bf.rewind();
+  double values[10];
+  BufferedFileReader::ParseStatus status;
+  ASSERT_EQ(2U, bf.parse_doubles(values, 10, &status));
+  ASSERT_EQ(BufferedFileReader::PARSE_OUT_OF_RANGE, status);
+  ASSERT_EQ(0U, bf.parse_doubles(values, 10, &status));
+  ASSERT_EQ(BufferedFileReader::PARSE_MALFORMED, status);
+  unlink(name.c_str());
+  HW1Environment::AddPoints(5);
+}
+
+// Returns the offset and line of every non-overlapping match of pattern in
+// contents, found the obvious way.
+static vector<std::pair<off_t, uint64_t>> naive_matches(
+    const string& contents, const string& pattern, bool case_insensitive) {
+  vector<std::pair<off_t, uint64_t>> matches;
+  string haystack = contents, needle = pattern;
+  if (case_insensitive) {
+    for (char& c : haystack) {
+      c = tolower(c);
+    }
+    for (char& c : needle) {
+      c = tolower(c);
+    }
+  }
+  uint64_t line = 0;
+  size_t counted = 0;
+  for (size_t pos = haystack.find(needle); pos != string::npos;
+       pos = haystack.find(needle, pos + needle.size())) {
+    line += std::count(contents.begin() + counted, contents.begin() + pos, '\n');
+    counted = pos;
+    matches.emplace_back(pos, line);
+  }
+  return matches;
+}
+
+TEST_F(Test_BufferedFileReader, find_next) {
+  HW1Environment::OpenTestCase();
+
+  // Short and long patterns, one with newlines in it, and one in either
+  // case; found the same through every size of buffer, so some matches
+  // span refills, and long patterns span several.
+  const struct {
+    const char* pattern;
+    bool case_insensitive;
+  } searches[] = {
+    { "war", false }, { "WAR", true }, { "e", false },
+    { "Prince Andrew", false }, { ".\n\n", false },
+    { "the rest of the world", true },
+  };
+  for (size_t size : { 1UL, 7UL, 100UL, BufferedFileReader::BUF_SIZE }) {
+    for (bool readahead : { false, size == 100 }) {
+      for (const auto& search : searches) {
+        auto expected = naive_matches(kLongContents, search.pattern,
+                                      search.case_insensitive);
+        ASSERT_LT(0U, expected.size());
+        BufferedFileReader bf(kLongFileName, "\r\n\t ", size, false,
+                              readahead);
+        SearchMatch match;
+        for (const auto& expected_match : expected) {
+          ASSERT_TRUE(bf.find_next(search.pattern, search.case_insensitive,
+                                   &match));
+          ASSERT_EQ(expected_match.first, match.offset);
+          ASSERT_EQ(expected_match.second, match.line);
+          ASSERT_EQ(match.offset + strlen(search.pattern), bf.tell());
+        }
+        ASSERT_FALSE(bf.find_next(search.pattern, search.case_insensitive,
+                                  &match));
+        ASSERT_FALSE(bf.good());
+      }
+    }
+  }
+  HW1Environment::AddPoints(10);
+
+  // Searching picks up wherever the reader is, and line numbers stay
+  // right after other reads and seeks, in either direction.
+  auto expected = naive_matches(kLongContents, "Natasha", false);
+  BufferedFileReader bf(kLongFileName, "\r\n\t ", 4096);
+  unsigned int seed = 5950;
+  SearchMatch match;
+  for (int i = 0; i < 200; i++) {
+    off_t offset = rand_r(&seed) % kLongContents.size();
+    if (i % 2 == 0) {
+      bf.seek(offset);
+    } else {
+      vector<string> tokens;
+      bf.get_line(&tokens);
+      offset = bf.tell();
+    }
+    auto next = std::lower_bound(expected.begin(), expected.end(),
+                                 std::make_pair(offset, uint64_t(0)));
+    if (next == expected.end()) {
+      ASSERT_FALSE(bf.find_next("Natasha", false, &match));
+      bf.rewind();
+      continue;
+    }
+    ASSERT_TRUE(bf.find_next("Natasha", false, &match));
+    ASSERT_EQ(next->first, match.offset);
+    ASSERT_EQ(next->second, match.line);
+  }
+  HW1Environment::AddPoints(5);
+
+  // Line numbers stay right past 2 GiB: "War and Peace" after a hole (of
+  // zeroes, so no newlines), searched from inside it.
+  const off_t kHoleSize = (2LL << 30) + 12345;
+  string name = write_temp_file("");
+  ASSERT_NE("", name);
+  int fd = open(name.c_str(), O_WRONLY);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(static_cast<ssize_t>(kLongContents.size()),
+            pwrite(fd, kLongContents.data(), kLongContents.size(), kHoleSize));
+  close(fd);
+  BufferedFileReader big(name, "\r\n\t ", BufferedFileReader::BUF_SIZE);
+  big.seek(kHoleSize - 100);
+  for (const auto& expected_match : expected) {
+    ASSERT_TRUE(big.find_next("Natasha", false, &match));
+    ASSERT_EQ(kHoleSize + expected_match.first, match.offset);
+    ASSERT_EQ(expected_match.second, match.line);
+  }
+  unlink(name.c_str());
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileReader, utf8) {
+  HW1Environment::OpenTestCase();
+
+  // Words made of characters of every length, some of whose bytes look
+  // like the ends of white space characters, separated by ASCII and
+  // Unicode white space, with invalid bytes here and there. The same text
+  // with each Unicode space swapped for ' ' reads back as the same tokens
+  // and lines without UTF-8 mode.
+  const char* chars[] = {
+    "a", "Z", "\xC3\xA9", "\xE2\x82\xAC", "\xE2\x80\x8B", "\xE2\x80\x90",
+    "\xE6\x97\xA5", "\xF0\x9F\x98\x80", "\xC2\xA9", "\xC4\x80",
+    "\xE3\x80\x81", "\xE2\x82\x80",
+  };
+  const char* spaces[] = {
+    " ", "\t", "\n", "\xC2\xA0", "\xC2\x85", "\xE1\x9A\x80", "\xE2\x80\x80",
+    "\xE2\x80\x83", "\xE2\x80\x8A", "\xE2\x80\xA8", "\xE2\x80\xA9",
+    "\xE2\x80\xAF", "\xE2\x81\x9F", "\xE3\x80\x80",
+  };
+  unsigned int seed = 5950;
+  string contents, ascii;
+  vector<off_t> errors;
+  for (int i = 0; i < 20000; i++) {
+    int len = rand_r(&seed) % 6;
+    for (int j = 0; j < len; j++) {
+      const char* c = chars[rand_r(&seed) % (sizeof(chars) / sizeof(chars[0]))];
+      if (rand_r(&seed) % 200 == 0) {
+        errors.push_back(contents.size());
+        c = "\xFF";
+      }
+      contents += c;
+      ascii += c;
+    }
+    const char* space =
+        spaces[rand_r(&seed) % (sizeof(spaces) / sizeof(spaces[0]))];
+    contents += space;
+    ascii += strlen(space) == 1 ? space : " ";
+  }
+  errors.push_back(contents.size());    // cut off by the end of the file
+  contents += "x\xE2\x82";
+  ascii += "x\xE2\x82";
+  errors.back()++;
+
+  string name = write_temp_file(contents);
+  string ascii_name = write_temp_file(ascii);
+  ASSERT_NE("", name);
+  ASSERT_NE("", ascii_name);
+  vector<string> expected_tokens;
+  vector<vector<string>> expected_lines;
+  BufferedFileReader expected(ascii_name);
+  while (expected.good()) {
+    expected_tokens.push_back(expected.get_token());
+  }
+  expected.rewind();
+  while (expected.good()) {
+    expected_lines.emplace_back();
+    expected.get_line(&expected_lines.back());
+  }
+
+  for (size_t size : { 1UL, 2UL, 3UL, 7UL, 100UL,
+                       BufferedFileReader::BUF_SIZE }) {
+    BufferedFileReader bf(name, "\r\n\t ", size);
+    bf.set_utf8();
+    for (const string& token : expected_tokens) {
+      ASSERT_TRUE(bf.good());
+      ASSERT_EQ(token, bf.get_token());
+    }
+    ASSERT_FALSE(bf.good());
+    ASSERT_EQ(errors, bf.utf8_errors());
+
+    // Reading again reports nothing new.
+    bf.rewind();
+    for (const string& token : expected_tokens) {
+      ASSERT_EQ(token, bf.get_token_view());
+    }
+    ASSERT_FALSE(bf.good());
+    bf.rewind();
+    for (const vector<string>& line : expected_lines) {
+      vector<string> tokens;
+      bf.get_line(&tokens);
+      ASSERT_EQ(line, tokens);
+    }
+    ASSERT_FALSE(bf.good());
+    ASSERT_EQ(errors, bf.utf8_errors());
+  }
+  HW1Environment::AddPoints(10);
+
+  // Without UTF-8 mode, nothing changes, and nothing is checked.
+  BufferedFileReader bf(name);
+  vector<string> tokens;
+  while (bf.good()) {
+    tokens.push_back(bf.get_token());
+  }
+  ASSERT_LT(tokens.size(), expected_tokens.size());
+  ASSERT_TRUE(bf.utf8_errors().empty());
+  unlink(name.c_str());
+  unlink(ascii_name.c_str());
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileReader, large_offsets) {
+  HW1Environment::OpenTestCase();
+
+  // Positions past 2 GiB, and past 4 GiB, are exact: a line after a hole.
+  for (off_t hole : { (2LL << 30) + 7, (5LL << 30) + 4099 }) {
+    string name = write_temp_file("");
+    ASSERT_NE("", name);
+    ASSERT_EQ(0, truncate(name.c_str(), hole));
+    {
+      std::ofstream out(name, std::ios::binary | std::ios::app);
+      out << "hello world\n";
+    }
+    for (bool direct : { false, true }) {
+      BufferedFileReader bf(name, "\r\n\t ", 4096, false, false, direct);
+      bf.seek(hole);
+      ASSERT_EQ(hole, bf.tell());
+      ASSERT_EQ("hello", bf.get_token());
+      ASSERT_EQ(hole + 6, bf.tell());
+      bf.seek(hole - 1);
+      ASSERT_EQ(hole - 1, bf.tell());
+      ASSERT_EQ('\0', bf.get_char());
+      ASSERT_EQ('h', bf.get_char());
+      bf.seek(hole + 100);
+      ASSERT_EQ(hole + 100, bf.tell());
+      ASSERT_FALSE(bf.good());
+    }
+    unlink(name.c_str());
+  }
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileReader, read_into) {
+  HW1Environment::OpenTestCase();
+
+  // Reads shorter than, about as long as, and much longer than the
+  // buffer, mixed with get_char() and get_token(), read back the whole
+  // file, with plain, adaptive, readahead and O_DIRECT buffers.
+  const string delims = "\r\n\t ";
+  for (size_t size : { 1UL, 7UL, 4096UL, BufferedFileReader::BUF_SIZE }) {
+    for (int mode = 0; mode < 4; mode++) {
+      if (mode == 2 && size < 4096) {
+        continue;                       // a handoff per byte is too slow
+      }
+      BufferedFileReader bf(kLongFileName, delims, size, mode == 1,
+                            mode == 2, mode == 3);
+      vector<char> contents(kLongContents.length());
+      size_t pos = 0, n = 1;
+      while (pos < kLongContents.length()) {
+        size_t read = bf.read_into(contents.data() + pos, n);
+        ASSERT_EQ(std::min(n, kLongContents.length() - pos), read);
+        pos += read;
+        ASSERT_EQ(static_cast<off_t>(pos), bf.tell());
+        if (pos < kLongContents.length() && n % 3 == 0) {
+          contents[pos++] = bf.get_char();
+        } else if (pos < kLongContents.length() && n % 3 == 1) {
+          string token = bf.get_token();
+          memcpy(contents.data() + pos, token.data(), token.size());
+          pos += token.size();
+          if (bf.tell() > static_cast<off_t>(pos)) {
+            ASSERT_NE(string::npos, delims.find(kLongContents[pos]));
+            contents[pos] = kLongContents[pos];
+            pos++;
+          }
+        }
+        n = n * 7 % 70001;
+      }
+      ASSERT_EQ(kLongContents, string(contents.data(), pos));
+      ASSERT_EQ(0U, bf.read_into(contents.data(), 1));
+      ASSERT_FALSE(bf.good());
+    }
+  }
+  HW1Environment::AddPoints(10);
+
+  // What's buffered is copied out, and the rest, being many buffers'
+  // worth, goes straight into dst: one more fill, and no more bytes read
+  // than asked for. The reader is left where the read ends.
+  BufferedFileReader bf(kLongFileName, delims, 4096);
+  bf.enable_stats();
+  bf.rewind();
+  vector<char> contents(kLongContents.length() + 100);
+  ASSERT_EQ(100U, bf.read_into(contents.data(), 100));
+  ASSERT_EQ(500000U, bf.read_into(contents.data() + 100, 500000));
+  ASSERT_EQ(0, memcmp(kLongContents.data(), contents.data(), 500100));
+  ASSERT_EQ(2U, bf.stats().fills);
+  ASSERT_EQ(500100U, bf.stats().bytes_read);
+  ASSERT_EQ(500100, bf.tell());
+  ASSERT_EQ(kLongContents[500100], bf.get_char());
+  bf.seek(10);
+  ASSERT_EQ(kLongContents[10], bf.get_char());
+
+  // To the end of the file, and past it.
+  bf.seek(400000);
+  size_t rest = kLongContents.length() - 400000;
+  ASSERT_EQ(rest, bf.read_into(contents.data(), contents.size()));
+  ASSERT_EQ(0, memcmp(kLongContents.data() + 400000, contents.data(), rest));
+  ASSERT_FALSE(bf.good());
+  ASSERT_EQ(EOF, bf.get_char());
+
+  // find_next() still counts the lines that went around the buffer.
+  bf.rewind();
+  ASSERT_EQ(300000U, bf.read_into(contents.data(), 300000));
+  SearchMatch match;
+  ASSERT_TRUE(bf.find_next("Natasha", false, &match));
+  size_t expected = kLongContents.find("Natasha", 300000);
+  ASSERT_EQ(static_cast<off_t>(expected), match.offset);
+  ASSERT_EQ(static_cast<uint64_t>(std::count(kLongContents.begin(),
+                                             kLongContents.begin() + expected,
+                                             '\n')),
+            match.line);
+  HW1Environment::AddPoints(5);
+}
+
 static bool verify_token(const string& actual, const string& expected_contents, const string& delims, off_t *offset) {
   off_t off = *offset;
   string expected = expected_contents.substr(off, actual.length());
@@ -0,0 +1,236 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./BufferedFileReader.h"
+#include "./BufferedFileWriter.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace hw1 {
+
+class Test_BufferedFileWriter : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    char name[] = "/tmp/test_bufferedfilewriter.XXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    out_name_ = name;
+  }
+
+  // These values contain the filename that we will be using to test the
+  // writer.  Each test writes out_name_ and reads it back.
+  static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    unlink(out_name_.c_str());
+  }
+
+  string out_name_;
+};  // class Test_BufferedFileWriter
+
+// Returns the whole contents of a file.
+static string read_file(const string& fname) {
+  std::ifstream in(fname, std::ios::binary);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+// Returns the size of a file, as the kernel sees it.
+static off_t file_size(const string& fname) {
+  struct stat st;
+  if (stat(fname.c_str(), &st) == -1) {
+    return -1;
+  }
+  return st.st_size;
+}
+
+TEST_F(Test_BufferedFileWriter, put_char_put_bytes) {
+  HW1Environment::OpenTestCase();
+  string expected = read_file(kLongFileName);
+
+  for (size_t size : { 1UL, 7UL, 512UL, BufferedFileWriter::BUF_SIZE,
+                       1UL << 20 }) {
+    // One character at a time.
+    {
+      BufferedFileWriter bw(out_name_, size);
+      ASSERT_TRUE(bw.good());
+      for (char c : expected) {
+        bw.put_char(c);
+      }
+      ASSERT_EQ(static_cast<off_t>(expected.size()), bw.tell());
+    }
+    ASSERT_EQ(expected, read_file(out_name_));
+
+    // Runs of bytes shorter than, about as long as, and much longer than
+    // the buffer, so every path through put_bytes() is taken.
+    {
+      BufferedFileWriter bw(out_name_, size);
+      size_t pos = 0, len = 1;
+      while (pos < expected.size()) {
+        size_t n = std::min(len, expected.size() - pos);
+        bw.put_bytes(expected.data() + pos, n);
+        pos += n;
+        len = len * 3 % 70001 + 1;
+      }
+      ASSERT_EQ(static_cast<off_t>(expected.size()), bw.tell());
+    }
+    ASSERT_EQ(expected, read_file(out_name_));
+  }
+
+  // Nothing happens without a file.
+  BufferedFileWriter bw(out_name_);
+  bw.put_char('a');
+  bw.close_file();
+  ASSERT_FALSE(bw.good());
+  bw.put_char('b');
+  bw.put_bytes("cd", 2);
+  bw.flush();
+  bw.sync();
+  ASSERT_EQ("a", read_file(out_name_));
+
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_BufferedFileWriter, put_token_put_line) {
+  HW1Environment::OpenTestCase();
+
+  // Tokens written out read back as the same tokens.
+  vector<string> tokens;
+  BufferedFileReader bf(kLongFileName);
+  while (bf.good()) {
+    tokens.push_back(bf.get_token());
+  }
+  {
+    BufferedFileWriter bw(out_name_, 512);
+    for (const string& token : tokens) {
+      bw.put_token(token, '\n');
+    }
+  }
+  BufferedFileReader tokens_in(out_name_);
+  for (const string& token : tokens) {
+    ASSERT_TRUE(tokens_in.good());
+    ASSERT_EQ(token, tokens_in.get_token());
+  }
+
+  // And so do lines, in either form.
+  vector<vector<string>> lines;
+  BufferedFileReader lines_bf(kLongFileName, " ");
+  while (lines_bf.good()) {
+    int len;
+    string* line = lines_bf.get_line(&len);
+    lines.emplace_back(line, line + len);
+    delete[] line;
+  }
+  {
+    BufferedFileWriter bw(out_name_, 100);
+    for (size_t i = 0; i < lines.size(); i++) {
+      if (i % 2 == 0) {
+        bw.put_line(lines[i], '|');
+      } else {
+        bw.put_line(lines[i].data(), lines[i].size(), '|');
+      }
+    }
+  }
+  BufferedFileReader lines_in(out_name_, "|");
+  for (const vector<string>& line : lines) {
+    ASSERT_TRUE(lines_in.good());
+    vector<string> read;
+    lines_in.get_line(&read);
+    ASSERT_EQ(line, read);
+  }
+
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_BufferedFileWriter, flush_and_sync) {
+  HW1Environment::OpenTestCase();
+
+  BufferedFileWriter bw(out_name_, 16, true);
+  bw.put_bytes("hello ", 6);
+  ASSERT_EQ(0, file_size(out_name_));   // still in the buffer
+  ASSERT_EQ(6, bw.tell());
+  bw.flush();
+  ASSERT_EQ(6, file_size(out_name_));
+  ASSERT_EQ("hello ", read_file(out_name_));
+
+  // Filling the buffer writes it out; a big write goes out with it.
+  bw.put_bytes("0123456789abcdef", 16);
+  ASSERT_EQ(6, file_size(out_name_));
+  bw.put_char('!');
+  ASSERT_EQ(22, file_size(out_name_));
+  string big(40, 'x');
+  bw.put_bytes(big.data(), big.size());
+  ASSERT_EQ(63, file_size(out_name_));
+  ASSERT_EQ(63, bw.tell());
+
+  bw.put_token("bye");
+  bw.sync();
+  ASSERT_EQ(67, file_size(out_name_));
+
+  // Reopening empties the file; closing with sync_on_close writes it all.
+  bw.open_file(out_name_);
+  ASSERT_EQ(0, bw.tell());
+  ASSERT_EQ(0, file_size(out_name_));
+  bw.put_bytes("abc", 3);
+  bw.close_file();
+  ASSERT_EQ("abc", read_file(out_name_));
+
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_BufferedFileWriter, large_offsets) {
+  HW1Environment::OpenTestCase();
+  const size_t kChunk = 1 << 30;
+
+  // Positions past 2 GiB, and past 4 GiB, are exact. /dev/null takes the
+  // bytes without storing them, and the chunk is never touched, so this
+  // costs neither disk nor memory.
+  void* chunk = mmap(nullptr, kChunk, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1, 0);
+  ASSERT_NE(MAP_FAILED, chunk);
+  BufferedFileWriter bw("/dev/null");
+  off_t expected = 0;
+  for (int i = 0; i < 5; i++) {
+    bw.put_bytes(static_cast<const char*>(chunk), kChunk);
+    expected += kChunk;
+    ASSERT_EQ(expected, bw.tell());
+    bw.put_token("x");
+    expected += 2;
+    ASSERT_EQ(expected, bw.tell());
+  }
+  bw.flush();
+  ASSERT_EQ(expected, bw.tell());
+  munmap(chunk, kChunk);
+
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
@@ -0,0 +1,144 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./DelimSet.h"
+
+#include <string>
+
+using std::string;
+
+namespace hw1 {
+
+class Test_DelimSet : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    // Nothing
+  }
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    // Nothing as of now
+  }
+
+};  // class Test_DelimSet
+
+TEST_F(Test_DelimSet, contains) {
+  HW1Environment::OpenTestCase();
+  string members = "\r\n\t ,";
+  members += static_cast<char>(0xFF);
+  members += static_cast<char>(0x80);
+  DelimSet set(members);
+
+  for (int c = 0; c < 256; c++) {
+    bool expected = members.find(static_cast<char>(c)) != string::npos;
+    ASSERT_EQ(expected, set.contains(static_cast<char>(c)));
+  }
+
+  // Adding a member, or one that's already there.
+  set.add('x');
+  set.add('x');
+  ASSERT_TRUE(set.contains('x'));
+  ASSERT_FALSE(set.contains('y'));
+
+  DelimSet empty;
+  for (int c = 0; c < 256; c++) {
+    ASSERT_FALSE(empty.contains(static_cast<char>(c)));
+  }
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_DelimSet, find) {
+  HW1Environment::OpenTestCase();
+  // Small sets take the SIMD path, the big one (more than
+  // MAX_SIMD_CHARS members) falls back to the table.
+  const char* sets[] = { "", " ", "\r\n\t ", ",\n ", "abcdefgh",
+                         "abcdefghijklmnopqrstuvwxyz" };
+  char buf[300];
+  unsigned int seed = 5950;
+
+  for (const char* members : sets) {
+    DelimSet set(members);
+    for (int trial = 0; trial < 2000; trial++) {
+      // Mostly bytes outside the set, so hits land anywhere in the
+      // buffer, including past the first few SIMD blocks.
+      for (size_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = static_cast<char>(128 + rand_r(&seed) % 128);
+      }
+      int num_hits = rand_r(&seed) % 3;
+      for (int i = 0; i < num_hits && members[0] != '\0'; i++) {
+        buf[rand_r(&seed) % sizeof(buf)] =
+            members[rand_r(&seed) % strlen(members)];
+      }
+
+      // Every start alignment and a range of lengths.
+      size_t begin = rand_r(&seed) % 64;
+      size_t end = begin + rand_r(&seed) % (sizeof(buf) - begin + 1);
+      const char* expected = buf + end;
+      for (size_t i = begin; i < end; i++) {
+        if (strchr(members, buf[i]) != nullptr && buf[i] != '\0') {
+          expected = buf + i;
+          break;
+        }
+      }
+      ASSERT_EQ(expected, set.find_scalar(buf + begin, buf + end));
+      ASSERT_EQ(expected, set.find(buf + begin, buf + end));
+    }
+  }
+  HW1Environment::AddPoints(10);
+}
+
+// Checks that a StaticDelimSet holds the same bytes as the DelimSet made
+// from chars, and finds the same ones in random buffers.
+template <class Static>
+static void check_static(const string& chars, unsigned int* seed) {
+  DelimSet set(chars);
+  for (int c = 0; c < 256; c++) {
+    ASSERT_EQ(set.contains(static_cast<char>(c)),
+              Static::contains(static_cast<char>(c)));
+  }
+
+  char buf[300];
+  for (int trial = 0; trial < 2000; trial++) {
+    for (size_t i = 0; i < sizeof(buf); i++) {
+      buf[i] = static_cast<char>(rand_r(seed) % 128);
+    }
+    size_t begin = rand_r(seed) % 64;
+    size_t end = begin + rand_r(seed) % (sizeof(buf) - begin + 1);
+    ASSERT_EQ(set.find(buf + begin, buf + end),
+              Static::find(buf + begin, buf + end));
+  }
+}
+
+TEST_F(Test_DelimSet, static_sets) {
+  HW1Environment::OpenTestCase();
+  unsigned int seed = 5950;
+
+  // The sets BasicBufferedReader uses, plus one too big for SIMD.
+  string whitespace = "\r\n\t ";
+  whitespace += static_cast<char>(EOF);
+  check_static<StaticDelimSet<'\r', '\n', '\t', ' ',
+                              static_cast<char>(EOF)>>(whitespace, &seed);
+  check_static<StaticDelimSet<',', '\r', '\n'>>(",\r\n", &seed);
+  check_static<StaticDelimSet<'\n'>>("\n", &seed);
+  check_static<StaticDelimSet<'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i',
+                              'j'>>("abcdefghij", &seed);
+  check_static<StaticDelimSet<>>("", &seed);
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
@@ -0,0 +1,171 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./BufferedFileReader.h"
+#include "./DirectoryScanner.h"
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace hw1 {
+
+class Test_DirectoryScanner : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case. Makes a directory
+  // with copies of the test files in it, one of them a level down, and
+  // an empty file.
+  virtual void SetUp() {
+    char name[] = "/tmp/test_directoryscanner.XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(name));
+    dir_ = name;
+    ASSERT_EQ(0, mkdir((dir_ + "/sub").c_str(), 0755));
+    copy_file(kLongFileName, dir_ + "/b_long.txt");
+    copy_file(kGreatFileName, dir_ + "/sub/great.txt");
+    copy_file(kHelloFileName, dir_ + "/a_hello.txt");
+    copy_file(kByeFileName, dir_ + "/c_bye.txt");
+    copy_file(kEmptyFileName, dir_ + "/d_empty.txt");
+  }
+
+  // These values contain the filenames that we will be using to test
+  // the scanner.
+  static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+  static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+  static constexpr const char* kEmptyFileName = "./test_files/Empty.txt";
+  static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+  static constexpr const char* kGreatFileName = "./test_files/mutual_aid.txt";
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    for (const string& fname : DirectoryScanner::list_directory(dir_)) {
+      unlink(fname.c_str());
+    }
+    rmdir((dir_ + "/sub").c_str());
+    rmdir(dir_.c_str());
+  }
+
+  static void copy_file(const string& from, const string& to) {
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary);
+    out << in.rdbuf();
+  }
+
+  string dir_;
+};  // class Test_DirectoryScanner
+
+TEST_F(Test_DirectoryScanner, list_directory) {
+  HW1Environment::OpenTestCase();
+
+  vector<string> expected = { dir_ + "/a_hello.txt", dir_ + "/b_long.txt",
+                              dir_ + "/c_bye.txt", dir_ + "/d_empty.txt",
+                              dir_ + "/sub/great.txt" };
+  vector<string> files = DirectoryScanner::list_directory(dir_);
+  ASSERT_EQ(expected, files);
+
+  DirectoryScanner scanner(files);
+  ASSERT_EQ(5, scanner.num_files());
+  off_t total = 0;
+  for (int i = 0; i < scanner.num_files(); i++) {
+    struct stat st;
+    ASSERT_EQ(0, stat(files[i].c_str(), &st));
+    ASSERT_EQ(files[i], scanner.file_name(i));
+    ASSERT_EQ(st.st_size, scanner.file_size(i));
+    total += st.st_size;
+  }
+  ASSERT_EQ(total, scanner.total_bytes());
+
+  // One thread takes the files biggest first.
+  vector<int> order;
+  scanner.for_each_line([&order](int file, const vector<string_view>&) {
+    if (order.empty() || order.back() != file) {
+      order.push_back(file);
+    }
+  });
+  ASSERT_EQ((vector<int>{ 1, 4, 2, 0 }), order);   // the empty file has
+                                                    // no lines
+
+  // No files, no calls.
+  DirectoryScanner none(vector<string>{}, "\r\n\t ", 4);
+  none.for_each_token([](int, string_view) { FAIL(); });
+
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_DirectoryScanner, for_each) {
+  HW1Environment::OpenTestCase();
+  vector<string> files = DirectoryScanner::list_directory(dir_);
+
+  // What BufferedFileReader reads from each file.
+  vector<vector<string>> expected_tokens(files.size());
+  vector<vector<vector<string>>> expected_lines(files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    BufferedFileReader bf(files[i], " ,");
+    while (bf.good()) {
+      expected_tokens[i].push_back(bf.get_token());
+    }
+    BufferedFileReader lines(files[i], " ,");
+    while (lines.good()) {
+      expected_lines[i].emplace_back();
+      lines.get_line(&expected_lines[i].back());
+    }
+  }
+
+  // The same, however many threads read them, and whatever the buffer.
+  for (int num_threads : { 1, 3, 8 }) {
+    for (size_t size : { 7UL, DirectoryScanner::BUF_SIZE }) {
+      DirectoryScanner scanner(files, " ,", num_threads, size);
+      std::mutex mutex;
+      vector<vector<string>> tokens(files.size());
+      scanner.for_each_token([&](int file, string_view token) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tokens[file].emplace_back(token);
+      });
+      ASSERT_EQ(expected_tokens, tokens);
+
+      vector<vector<vector<string>>> lines(files.size());
+      scanner.for_each_line([&](int file, const vector<string_view>& line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        lines[file].emplace_back(line.begin(), line.end());
+      });
+      ASSERT_EQ(expected_lines, lines);
+
+      // Or each file, to read with the reader it is open in.
+      vector<vector<string>> file_tokens(files.size());
+      scanner.for_each_file([&](int file, BufferedFileReader* reader) {
+        vector<string> read;
+        while (reader->good()) {
+          read.push_back(reader->get_token());
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        file_tokens[file] = read;
+      });
+      ASSERT_EQ(expected_tokens, file_tokens);
+    }
+  }
+
+  HW1Environment::AddPoints(10);
+}
+
+}  // namespace hw1
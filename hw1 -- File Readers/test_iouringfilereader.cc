@@ -0,0 +1,179 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./BufferedFileReader.h"
+#include "./IoUringFileReader.h"
+
+#include <string>
+
+using std::string;
+
+namespace hw1 {
+
+class Test_IoUringFileReader : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    // Nothing
+  }
+
+  // These values contain the filename that we will be using to test the
+  // io_uring file reader.  Each test checks that IoUringFileReader
+  // behaves exactly like BufferedFileReader on the same file, with
+  // io_uring and with the pread() fallback.
+  static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+  static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+  static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+  static constexpr const char* kGreatFileName = "./test_files/mutual_aid.txt";
+  static constexpr const char* kEmptyFileName = "./test_files/Empty.txt";
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    // Nothing as of now
+  }
+
+};  // class Test_IoUringFileReader
+
+TEST_F(Test_IoUringFileReader, get_char) {
+  HW1Environment::OpenTestCase();
+  const char* files[] = { kHelloFileName, kByeFileName,
+                          kLongFileName, kGreatFileName };
+
+  for (bool use_io_uring : { true, false }) {
+    for (int depth : { 1, 3, 8 }) {
+      IoUringFileReader uf(kHelloFileName, "\r\n\t ", 4096, depth,
+                           use_io_uring);
+      for (const char* fname : files) {
+        BufferedFileReader bf(fname);
+        uf.open_file(fname);
+        char c;
+        do {
+          ASSERT_EQ(bf.tell(), uf.tell());
+          c = bf.get_char();
+          ASSERT_EQ(c, uf.get_char());
+          ASSERT_EQ(bf.good(), uf.good());
+        } while (c != EOF);
+
+        // Reading past the end stays at EOF and doesn't crash.
+        ASSERT_EQ(EOF, uf.get_char());
+        ASSERT_FALSE(uf.good());
+      }
+    }
+  }
+  HW1Environment::AddPoints(5);
+
+  // No file open, then an empty file, then rewinding partway through a
+  // file while reads are in flight.
+  IoUringFileReader uf(kEmptyFileName);
+  ASSERT_FALSE(uf.good());
+  ASSERT_EQ(0, uf.tell());
+  ASSERT_EQ(EOF, uf.get_char());
+  uf.close_file();
+  ASSERT_FALSE(uf.good());
+  ASSERT_EQ(EOF, uf.get_char());
+  ASSERT_EQ("", uf.get_token());
+  uf.open_file(kLongFileName);
+  for (int i = 0; i < 100000; i++) {
+    uf.get_char();
+  }
+  ASSERT_EQ(100000, uf.tell());
+  uf.rewind();
+  ASSERT_TRUE(uf.good());
+  ASSERT_EQ(0, uf.tell());
+  BufferedFileReader bf(kLongFileName);
+  ASSERT_EQ(bf.get_token(), uf.get_token());
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_IoUringFileReader, get_token_get_line) {
+  HW1Environment::OpenTestCase();
+  const char* files[] = { kHelloFileName, kByeFileName,
+                          kLongFileName, kGreatFileName };
+  const char* delim_sets[] = { "\t ", ",\t ", ",\n " };
+
+  for (bool use_io_uring : { true, false }) {
+    for (const char* fname : files) {
+      for (const char* delims : delim_sets) {
+        BufferedFileReader bf(fname, delims);
+        IoUringFileReader uf(fname, delims, 4096, 4, use_io_uring);
+
+        // Alternate get_token and get_line, twice through the file.
+        for (int pass = 0; pass < 2; pass++) {
+          bool read_line = false;
+          while (bf.good()) {
+            ASSERT_TRUE(uf.good());
+            if (read_line) {
+              int blen, ulen;
+              string* btokens = bf.get_line(&blen);
+              string* utokens = uf.get_line(&ulen);
+              ASSERT_EQ(blen, ulen);
+              for (int i = 0; i < blen; i++) {
+                ASSERT_EQ(btokens[i], utokens[i]);
+              }
+              delete[] btokens;
+              delete[] utokens;
+            } else {
+              ASSERT_EQ(bf.get_token(), uf.get_token_view());
+            }
+            ASSERT_EQ(bf.tell(), uf.tell());
+            read_line = !read_line;
+          }
+          ASSERT_FALSE(uf.good());
+          bf.rewind();
+          uf.rewind();
+        }
+      }
+    }
+  }
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_IoUringFileReader, stats) {
+  HW1Environment::OpenTestCase();
+  BufferedFileReader bf(kLongFileName);
+  uint64_t tokens = 0;
+  while (bf.good()) {
+    bf.get_token();
+    tokens++;
+  }
+  uint64_t length = bf.tell();
+
+  // Every block is read once, however the reads are issued, and the
+  // reader waits for each one in turn.
+  for (bool use_io_uring : { true, false }) {
+    IoUringFileReader uf(kLongFileName, "\r\n\t ", 4096, 4, use_io_uring);
+    uf.enable_stats();
+    uf.open_file(kLongFileName);
+    while (uf.good()) {
+      uf.get_token_view();
+    }
+    const ReaderStats& stats = uf.stats();
+    ASSERT_EQ(length, stats.bytes_read);
+    ASSERT_EQ(tokens, stats.tokens);
+    ASSERT_EQ((length + 4095) / 4096, stats.fills);
+    ASSERT_LT(0U, stats.read_syscalls);
+    if (!use_io_uring) {
+      ASSERT_EQ(stats.fills, stats.read_syscalls);
+    }
+    ASSERT_LE(stats.max_fill_ns, stats.fill_ns);
+  }
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
@@ -0,0 +1,222 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./BufferedFileReader.h"
+#include "./LineIndex.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace hw1 {
+
+class Test_LineIndex : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    char name[] = "/tmp/test_lineindex.XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(name));
+    dir_ = name;
+  }
+
+  // These values contain the filenames that we will be using to test the
+  // line index.  The test files are only indexed without a sidecar; tests
+  // that write sidecars work on copies in dir_.
+  static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+  static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+  static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+  static constexpr const char* kGreatFileName = "./test_files/mutual_aid.txt";
+  static constexpr const char* kEmptyFileName = "./test_files/Empty.txt";
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    for (const string& name : created_) {
+      unlink(name.c_str());
+      unlink(LineIndex::sidecar_name(name).c_str());
+    }
+    rmdir(dir_.c_str());
+  }
+
+  // Writes contents to a new file in dir_ and returns its name.
+  string make_file(const string& name, const string& contents) {
+    string path = dir_ + "/" + name;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << contents;
+    created_.push_back(path);
+    return path;
+  }
+
+  string dir_;
+  vector<string> created_;
+};  // class Test_LineIndex
+
+// Returns the whole contents of a file.
+static string read_file(const string& fname) {
+  std::ifstream in(fname, std::ios::binary);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+// Returns where each line of contents starts, then its length.
+static vector<uint64_t> line_starts(const string& contents) {
+  vector<uint64_t> starts = { 0 };
+  for (size_t i = 0; i < contents.size(); i++) {
+    if (contents[i] == '\n' && i + 1 < contents.size()) {
+      starts.push_back(i + 1);
+    }
+  }
+  if (!contents.empty()) {
+    starts.push_back(contents.size());
+  }
+  return starts;
+}
+
+// Checks that the index has the lines of contents.
+static void check_index(LineIndex* index, const string& contents) {
+  vector<uint64_t> expected = line_starts(contents);
+  ASSERT_EQ(expected.size() - 1, index->num_lines());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(static_cast<off_t>(expected[i]), index->line_start(i));
+  }
+}
+
+TEST_F(Test_LineIndex, lines) {
+  HW1Environment::OpenTestCase();
+  const char* files[] = { kHelloFileName, kByeFileName, kLongFileName,
+                          kGreatFileName, kEmptyFileName };
+
+  for (const char* fname : files) {
+    string contents = read_file(fname);
+    vector<uint64_t> starts = line_starts(contents);
+    LineIndex index(fname, false);
+    ASSERT_FALSE(index.from_sidecar());
+    check_index(&index, contents);
+
+    // A reader moved to a line reads that line, and get_lines() returns
+    // the lines' bytes.
+    BufferedFileReader bf(fname, " ");
+    BufferedFileReader expected_bf(fname, " ");
+    vector<string> tokens, expected_tokens;
+    unsigned int seed = 5950;
+    for (int i = 0; i < 200 && index.num_lines() > 0; i++) {
+      size_t line = rand_r(&seed) % index.num_lines();
+      index.seek_to_line(&bf, line);
+      bf.get_line(&tokens);
+      expected_bf.seek(starts[line]);
+      expected_bf.get_line(&expected_tokens);
+      ASSERT_EQ(expected_tokens, tokens);
+
+      size_t count = rand_r(&seed) % 5;
+      size_t last = std::min(line + count, index.num_lines());
+      off_t start = index.line_start(line);
+      ASSERT_EQ(contents.substr(start, index.line_start(last) - start),
+                index.get_lines(line, count));
+    }
+    ASSERT_EQ("", index.get_lines(index.num_lines(), 3));
+  }
+  HW1Environment::AddPoints(5);
+
+  // Files that do and don't end with a newline, blank lines, and newlines
+  // right at the edges of the blocks the file is read in.
+  string block_edges(3 * LineIndex::BLOCK_SIZE + 17, 'x');
+  for (size_t i : { 0UL, 31UL, 32UL, 33UL }) {
+    block_edges[LineIndex::BLOCK_SIZE - 1 + i] = '\n';
+    block_edges[LineIndex::BLOCK_SIZE + i] = '\n';
+    block_edges[2 * LineIndex::BLOCK_SIZE + i] = '\n';
+  }
+  const char* names[] = { "a", "b", "c", "d", "e", "f" };
+  const string cases[] = { "no newline", "one newline\n", "\n", "\n\n\n",
+                           "two\nlines", block_edges };
+  for (int i = 0; i < 6; i++) {
+    string fname = make_file(names[i], cases[i]);
+    LineIndex index(fname, false);
+    check_index(&index, cases[i]);
+  }
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_LineIndex, sidecar) {
+  HW1Environment::OpenTestCase();
+  string contents = read_file(kLongFileName);
+  string fname = make_file("war_and_peace.txt", contents);
+  string sidecar = LineIndex::sidecar_name(fname);
+  struct stat st;
+
+  // Without a sidecar, none is written.
+  {
+    LineIndex index(fname, false);
+    ASSERT_NE(0, stat(sidecar.c_str(), &st));
+  }
+
+  // The first index is built and saved, the next one is loaded.
+  {
+    LineIndex index(fname);
+    ASSERT_FALSE(index.from_sidecar());
+    ASSERT_EQ(0, stat(sidecar.c_str(), &st));
+  }
+  {
+    LineIndex index(fname);
+    ASSERT_TRUE(index.from_sidecar());
+    check_index(&index, contents);
+  }
+
+  // Changing the file makes the sidecar stale.
+  contents += "one more line\n";
+  make_file("war_and_peace.txt", contents);
+  {
+    LineIndex index(fname);
+    ASSERT_FALSE(index.from_sidecar());
+    check_index(&index, contents);
+  }
+  {
+    LineIndex index(fname);
+    ASSERT_TRUE(index.from_sidecar());
+    check_index(&index, contents);
+  }
+
+  // So does touching it, even if the contents are the same.
+  struct timespec times[2] = { { 0, UTIME_NOW }, { 12345, 678 } };
+  ASSERT_EQ(0, utimensat(AT_FDCWD, fname.c_str(), times, 0));
+  {
+    LineIndex index(fname);
+    ASSERT_FALSE(index.from_sidecar());
+  }
+
+  // And a damaged sidecar is rebuilt.
+  ASSERT_EQ(0, truncate(sidecar.c_str(), 100));
+  {
+    LineIndex index(fname);
+    ASSERT_FALSE(index.from_sidecar());
+    check_index(&index, contents);
+  }
+  {
+    LineIndex index(fname);
+    ASSERT_TRUE(index.from_sidecar());
+  }
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
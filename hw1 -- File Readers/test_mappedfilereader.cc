@@ -0,0 +1,170 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./BufferedFileReader.h"
+#include "./MappedFileReader.h"
+
+#include <string>
+
+using std::string;
+
+namespace hw1 {
+
+class Test_MappedFileReader : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    // Nothing
+  }
+
+  // These values contain the filename that we will be using to test the
+  // mapped file reader.  Rather than keep expected contents around, each
+  // test checks that MappedFileReader behaves exactly like
+  // BufferedFileReader on the same file.
+  static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+  static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+  static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+  static constexpr const char* kGreatFileName = "./test_files/mutual_aid.txt";
+  static constexpr const char* kEmptyFileName = "./test_files/Empty.txt";
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    // Nothing as of now
+  }
+
+};  // class Test_MappedFileReader
+
+TEST_F(Test_MappedFileReader, get_char) {
+  HW1Environment::OpenTestCase();
+  const char* files[] = { kHelloFileName, kByeFileName,
+                          kLongFileName, kGreatFileName };
+
+  MappedFileReader mf(kHelloFileName);
+  for (const char* fname : files) {
+    BufferedFileReader bf(fname);
+    mf.open_file(fname);
+    char c;
+    do {
+      ASSERT_EQ(bf.tell(), mf.tell());
+      c = bf.get_char();
+      ASSERT_EQ(c, mf.get_char());
+      ASSERT_EQ(bf.good(), mf.good());
+    } while (c != EOF);
+
+    // Reading past the end stays at EOF and doesn't crash.
+    ASSERT_EQ(EOF, mf.get_char());
+    ASSERT_EQ(EOF, mf.get_char());
+    ASSERT_FALSE(mf.good());
+  }
+  HW1Environment::AddPoints(5);
+
+  // No file open, then an empty file.
+  mf.close_file();
+  ASSERT_FALSE(mf.good());
+  ASSERT_EQ(EOF, mf.get_char());
+  mf.open_file(kEmptyFileName);
+  ASSERT_TRUE(mf.good());
+  ASSERT_EQ(0, mf.tell());
+  ASSERT_EQ("", mf.get_token());
+  ASSERT_FALSE(mf.good());
+  mf.rewind();
+  ASSERT_TRUE(mf.good());
+  ASSERT_EQ(EOF, mf.get_char());
+  ASSERT_FALSE(mf.good());
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_MappedFileReader, get_token_get_line) {
+  HW1Environment::OpenTestCase();
+  const char* files[] = { kHelloFileName, kByeFileName,
+                          kLongFileName, kGreatFileName };
+  const char* delim_sets[] = { "\t ", ",\t ", ",\n " };
+
+  for (const char* fname : files) {
+    for (const char* delims : delim_sets) {
+      BufferedFileReader bf(fname, delims);
+      MappedFileReader mf(fname, delims);
+
+      // Alternate get_token and get_line, twice through the file.
+      for (int pass = 0; pass < 2; pass++) {
+        bool read_line = false;
+        while (bf.good()) {
+          ASSERT_TRUE(mf.good());
+          if (read_line) {
+            int blen, mlen;
+            string* btokens = bf.get_line(&blen);
+            string* mtokens = mf.get_line(&mlen);
+            ASSERT_EQ(blen, mlen);
+            for (int i = 0; i < blen; i++) {
+              ASSERT_EQ(btokens[i], mtokens[i]);
+            }
+            delete[] btokens;
+            delete[] mtokens;
+          } else {
+            ASSERT_EQ(bf.get_token(), mf.get_token());
+          }
+          ASSERT_EQ(bf.tell(), mf.tell());
+          read_line = !read_line;
+        }
+        ASSERT_FALSE(mf.good());
+        bf.rewind();
+        mf.rewind();
+      }
+    }
+  }
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_MappedFileReader, find_next) {
+  HW1Environment::OpenTestCase();
+  const char* patterns[] = { "war", "WAR", "Prince Andrew", ".\n\n" };
+
+  // The same matches, on the same lines, as BufferedFileReader finds, also
+  // with tokens read in between.
+  for (const char* fname : { kLongFileName, kGreatFileName }) {
+    for (const char* pattern : patterns) {
+      for (bool case_insensitive : { false, true }) {
+        BufferedFileReader bf(fname);
+        MappedFileReader mf(fname);
+        SearchMatch expected, match;
+        int i = 0;
+        while (bf.find_next(pattern, case_insensitive, &expected)) {
+          ASSERT_TRUE(mf.find_next(pattern, case_insensitive, &match));
+          ASSERT_EQ(expected.offset, match.offset);
+          ASSERT_EQ(expected.line, match.line);
+          ASSERT_EQ(bf.tell(), mf.tell());
+          if (i++ % 3 == 0) {
+            ASSERT_EQ(bf.get_token(), mf.get_token());
+          }
+        }
+        ASSERT_FALSE(mf.find_next(pattern, case_insensitive, &match));
+        ASSERT_FALSE(mf.good());
+      }
+    }
+  }
+
+  // Nothing to find in an empty file.
+  MappedFileReader mf(kEmptyFileName);
+  SearchMatch match;
+  ASSERT_FALSE(mf.find_next("a", false, &match));
+  ASSERT_FALSE(mf.good());
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
@@ -0,0 +1,122 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./BufferedFileReader.h"
+#include "./ParallelTokenizer.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace hw1 {
+
+class Test_ParallelTokenizer : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    // Nothing
+  }
+
+  // These values contain the filename that we will be using to test the
+  // parallel tokenizer.  Each test checks that it finds exactly the
+  // tokens BufferedFileReader does.
+  static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+  static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+  static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+  static constexpr const char* kGreatFileName = "./test_files/mutual_aid.txt";
+  static constexpr const char* kEmptyFileName = "./test_files/Empty.txt";
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    // Nothing as of now
+  }
+
+};  // class Test_ParallelTokenizer
+
+// Returns every token BufferedFileReader reads from the file.
+static vector<string> read_tokens(const char* fname, const string& delims) {
+  BufferedFileReader bf(fname, delims);
+  vector<string> tokens;
+  while (bf.good()) {
+    tokens.push_back(bf.get_token());
+  }
+  return tokens;
+}
+
+TEST_F(Test_ParallelTokenizer, tokens) {
+  HW1Environment::OpenTestCase();
+  const char* files[] = { kHelloFileName, kByeFileName, kLongFileName,
+                          kGreatFileName, kEmptyFileName };
+  const char* delim_sets[] = { "\r\n\t ", ",\n ", "\n" };
+
+  for (const char* fname : files) {
+    for (const char* delims : delim_sets) {
+      vector<string> expected = read_tokens(fname, delims);
+      for (int num_chunks : { 1, 2, 3, 7, 16 }) {
+        ParallelTokenizer pt(fname, delims, num_chunks);
+        ASSERT_EQ(num_chunks, pt.num_chunks());
+        ASSERT_EQ(expected, pt.tokens());
+      }
+    }
+  }
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_ParallelTokenizer, chunks_and_counts) {
+  HW1Environment::OpenTestCase();
+  string delims = "\r\n\t ";
+  vector<string> tokens = read_tokens(kLongFileName, delims);
+  unordered_map<string, size_t> expected;
+  for (const string& token : tokens) {
+    expected[token]++;
+  }
+
+  // Every chunk but the first starts right after a delimiter, and the
+  // chunks are about the same size.
+  ParallelTokenizer pt(kLongFileName, delims, 8);
+  BufferedFileReader bf(kLongFileName, delims);
+  off_t size = pt.chunk_start(8);
+  ASSERT_EQ(0, pt.chunk_start(0));
+  for (int i = 1; i < 8; i++) {
+    off_t start = pt.chunk_start(i);
+    ASSERT_LE(pt.chunk_start(i - 1), start);
+    ASSERT_LT(start - size * i / 8, 1000);
+    while (bf.tell() < start - 1) {
+      bf.get_char();
+    }
+    char c = bf.get_char();
+    ASSERT_NE(string::npos, delims.find(c));
+  }
+  ASSERT_EQ(expected, pt.count_tokens());
+
+  // A file too small to split gets empty chunks, and still counts right.
+  ParallelTokenizer small(kHelloFileName, delims, 16);
+  unordered_map<string, size_t> hello;
+  for (const string& token : read_tokens(kHelloFileName, delims)) {
+    hello[token]++;
+  }
+  ASSERT_EQ(hello, small.count_tokens());
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
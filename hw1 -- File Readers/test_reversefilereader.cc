@@ -0,0 +1,231 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./BufferedFileReader.h"
+#include "./ReverseFileReader.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace hw1 {
+
+class Test_ReverseFileReader : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    std::ifstream long_ifs(kLongFileName);
+    kLongContents.assign((std::istreambuf_iterator<char>(long_ifs)),
+                         (std::istreambuf_iterator<char>()));
+  }
+
+  // These values contain the filenames that we will be using to test
+  // the reader.
+  static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+  static constexpr const char* kByeFileName = "./test_files/Bye.txt";
+  static constexpr const char* kEmptyFileName = "./test_files/Empty.txt";
+  static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+  static string kLongContents;
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    // Nothing as of now
+  }
+};  // class Test_ReverseFileReader
+
+// statics
+string Test_ReverseFileReader::kLongContents = "";
+
+// Writes contents to a new temporary file, and returns its name.
+static string write_temp_file(const string& contents) {
+  char name[] = "/tmp/test_reversefilereader.XXXXXX";
+  int fd = mkstemp(name);
+  if (fd == -1) {
+    return "";
+  }
+  close(fd);
+  std::ofstream out(name, std::ios::binary);
+  out << contents;
+  return name;
+}
+
+// Returns every token BufferedFileReader reads from the file, last first.
+static vector<string> reversed_tokens(const string& fname,
+                                      const string& delims) {
+  vector<string> tokens;
+  BufferedFileReader bf(fname, delims);
+  while (bf.good()) {
+    tokens.push_back(bf.get_token());
+  }
+  std::reverse(tokens.begin(), tokens.end());
+  return tokens;
+}
+
+// Returns the lines of contents, split at '\n', last first. A '\n' at the
+// end ends the last line, so "a\n" is one line, but "a\n\n" is two.
+static vector<string> reversed_lines(const string& contents) {
+  vector<string> lines;
+  size_t start = 0;
+  while (start < contents.size()) {
+    size_t end = contents.find('\n', start);
+    if (end == string::npos) {
+      end = contents.size();
+    }
+    lines.push_back(contents.substr(start, end - start));
+    start = end + 1;
+  }
+  std::reverse(lines.begin(), lines.end());
+  return lines;
+}
+
+TEST_F(Test_ReverseFileReader, prev_token) {
+  HW1Environment::OpenTestCase();
+
+  // The tokens come out as BufferedFileReader's, in reverse, whether they
+  // fit in a block or are stitched together across several.
+  vector<string> expected = reversed_tokens(kLongFileName, "\r\n\t ");
+  for (size_t size : { 7UL, 100UL, 4096UL, ReverseFileReader::BUF_SIZE }) {
+    ReverseFileReader rf(kLongFileName, "\r\n\t ", size);
+    for (const string& token : expected) {
+      ASSERT_TRUE(rf.good());
+      ASSERT_EQ(token, rf.prev_token());
+    }
+    ASSERT_FALSE(rf.good());
+    ASSERT_EQ(0, rf.tell());
+    ASSERT_EQ("", rf.prev_token());
+  }
+
+  // Small files, and delimiters at either end.
+  string leading = write_temp_file("  lead,ing\ttokens,,");
+  ASSERT_NE("", leading);
+  for (const string& fname : { string(kHelloFileName), string(kByeFileName),
+                               string(kEmptyFileName), leading }) {
+    for (const string& delims : { string("\r\n\t "), string(",") }) {
+      for (size_t size : { 1UL, 3UL, 4096UL }) {
+        ReverseFileReader rf(fname, delims, size);
+        vector<string> tokens;
+        while (rf.good()) {
+          tokens.push_back(rf.prev_token());
+        }
+        ASSERT_EQ(reversed_tokens(fname, delims), tokens);
+      }
+    }
+  }
+  unlink(leading.c_str());
+
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_ReverseFileReader, prev_line) {
+  HW1Environment::OpenTestCase();
+
+  vector<string> expected = reversed_lines(kLongContents);
+  for (size_t size : { 7UL, 100UL, 4096UL, ReverseFileReader::BUF_SIZE }) {
+    ReverseFileReader rf(kLongFileName, "\r\n\t ", size);
+    for (const string& line : expected) {
+      ASSERT_TRUE(rf.good());
+      ASSERT_EQ(line, rf.prev_line());
+    }
+    ASSERT_FALSE(rf.good());
+  }
+
+  // Split into tokens, they are BufferedFileReader's lines, in reverse,
+  // without the empty one it reads after the file's final '\n'.
+  vector<vector<string>> lines;
+  BufferedFileReader bf(kLongFileName, " ");
+  while (bf.good()) {
+    lines.emplace_back();
+    bf.get_line(&lines.back());
+  }
+  ASSERT_EQ(vector<string>{""}, lines.back());
+  lines.pop_back();
+  std::reverse(lines.begin(), lines.end());
+  ReverseFileReader tokenized(kLongFileName, " ", 100);
+  vector<string> line;
+  for (const vector<string>& expected_line : lines) {
+    ASSERT_TRUE(tokenized.good());
+    tokenized.prev_line(&line);
+    ASSERT_EQ(expected_line, line);
+  }
+  ASSERT_FALSE(tokenized.good());
+
+  // Files with and without a final '\n', and with empty lines.
+  for (const string& contents : { string("a\nbc\nd"), string("a\nbc\nd\n"),
+                                   string("\n\na\n\n"), string("\n"),
+                                   string("one line") }) {
+    string fname = write_temp_file(contents);
+    ASSERT_NE("", fname);
+    for (size_t size : { 1UL, 2UL, 4096UL }) {
+      ReverseFileReader rf(fname, "\r\n\t ", size);
+      vector<string> got;
+      while (rf.good()) {
+        got.push_back(rf.prev_line());
+      }
+      ASSERT_EQ(reversed_lines(contents), got);
+    }
+    unlink(fname.c_str());
+  }
+
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_ReverseFileReader, prev_char_and_cost) {
+  HW1Environment::OpenTestCase();
+
+  ReverseFileReader rf(kLongFileName, "\r\n\t ", 1000);
+  for (size_t i = kLongContents.size(); i > 0; i--) {
+    ASSERT_TRUE(rf.good());
+    ASSERT_EQ(kLongContents[i - 1], rf.prev_char());
+    ASSERT_EQ(static_cast<off_t>(i - 1), rf.tell());
+  }
+  ASSERT_EQ(EOF, rf.prev_char());
+  ASSERT_FALSE(rf.good());
+
+  // rewind() starts again from the end; prev_char() and prev_token() mix.
+  rf.rewind();
+  ASSERT_EQ(static_cast<off_t>(kLongContents.size()), rf.tell());
+  ASSERT_EQ('\n', rf.prev_char());
+  ASSERT_EQ("", rf.prev_token());
+  ASSERT_EQ("eBooks.", rf.prev_token());
+
+  // The last few lines only read the blocks they are in.
+  ReverseFileReader tail(kLongFileName);
+  tail.enable_stats();
+  for (int i = 0; i < 10; i++) {
+    tail.prev_line();
+  }
+  const ReaderStats& stats = tail.stats();
+  ASSERT_EQ(10U, stats.lines);
+  ASSERT_GE(2U, stats.fills);
+  ASSERT_GE(2 * ReverseFileReader::BUF_SIZE, stats.bytes_read);
+  ASSERT_EQ('\n', kLongContents[tail.tell()]);
+
+  // Nothing is read without a file.
+  tail.close_file();
+  ASSERT_FALSE(tail.good());
+  ASSERT_EQ(EOF, tail.prev_char());
+
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
@@ -0,0 +1,197 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./BufferedFileReader.h"
+#include "./SharedFileReader.h"
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace hw1 {
+
+class Test_SharedFileReader : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    std::ifstream long_ifs(kLongFileName);
+    kLongContents.assign((std::istreambuf_iterator<char>(long_ifs)),
+                         (std::istreambuf_iterator<char>()));
+  }
+
+  // These values contain the filenames that we will be using to test
+  // the reader.
+  static constexpr const char* kHelloFileName = "./test_files/Hello.txt";
+  static constexpr const char* kLongFileName = "./test_files/war_and_peace.txt";
+
+  static string kLongContents;
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    // Nothing as of now
+  }
+};  // class Test_SharedFileReader
+
+// statics
+string Test_SharedFileReader::kLongContents = "";
+
+TEST_F(Test_SharedFileReader, Handle) {
+  HW1Environment::OpenTestCase();
+  SharedFileReader file(kLongFileName);
+  ASSERT_EQ(static_cast<off_t>(kLongContents.size()), file.size());
+
+  // A Handle over the whole file reads it like a BufferedFileReader.
+  for (size_t size : { 1UL, 7UL, SharedFileReader::BUF_SIZE, 1UL << 16 }) {
+    SharedFileReader::Handle handle(file, 0, SharedFileReader::TO_EOF,
+                                    "\r\n\t ", size);
+    BufferedFileReader expected(kLongFileName, "\r\n\t ", size);
+    vector<string> line, expected_line;
+    int i = 0;
+    while (expected.good()) {
+      ASSERT_TRUE(handle.good());
+      if (i++ % 5 == 0) {
+        expected.get_line(&expected_line);
+        handle.get_line(&line);
+        ASSERT_EQ(expected_line, line);
+      } else {
+        ASSERT_EQ(expected.get_token(), handle.get_token());
+      }
+      ASSERT_EQ(expected.tell(), handle.tell());
+    }
+    ASSERT_FALSE(handle.good());
+    ASSERT_EQ(EOF, handle.get_char());
+  }
+
+  // A range reads as a file of its own.
+  SharedFileReader hello(kHelloFileName);
+  SharedFileReader::Handle range(hello, 2, 9, " ", 4);
+  string bytes;
+  for (char c = range.get_char(); c != EOF; c = range.get_char()) {
+    bytes += c;
+  }
+  ASSERT_FALSE(range.good());
+  ASSERT_EQ(9, range.tell());
+  range.seek(2);
+  ASSERT_TRUE(range.good());
+  ASSERT_EQ(bytes.substr(0, bytes.find(' ')), range.get_token());
+  range.seek(20);
+  ASSERT_FALSE(range.good());
+  ASSERT_EQ("", range.get_token());
+
+  std::ifstream hello_ifs(kHelloFileName);
+  string hello_contents((std::istreambuf_iterator<char>(hello_ifs)),
+                        (std::istreambuf_iterator<char>()));
+  ASSERT_EQ(hello_contents.substr(2, 7), bytes);
+
+  // Stats are the Handle's own.
+  SharedFileReader::Handle counted(file, 0, 1000, "\r\n\t ", 512);
+  counted.enable_stats();
+  while (counted.good()) {
+    counted.get_token_view();
+  }
+  counted.reset_stats();
+  counted.seek(0);
+  while (counted.good()) {
+    counted.get_token_view();
+  }
+  ASSERT_EQ(1000U, counted.stats().bytes_read);
+  ASSERT_EQ(2U, counted.stats().fills);
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_SharedFileReader, Concurrency) {
+  HW1Environment::OpenTestCase();
+  const int kThreads = 8;
+  SharedFileReader file(kLongFileName);
+  off_t size = file.size();
+  std::atomic<int> failures(0);
+
+  // Each thread reads a range byte by byte, and checks it against the
+  // file: half the ranges split the file between them, the other half
+  // overlap all of those. Reads from every handle interleave.
+  vector<std::thread> threads;
+  for (int i = 0; i < kThreads; i++) {
+    off_t begin, end;
+    if (i % 2 == 0) {
+      begin = size * i / kThreads;
+      end = size * (i + 2) / kThreads;
+    } else {
+      begin = size / 4 * (i % 3);
+      end = begin + size / 2;
+    }
+    threads.emplace_back([&file, &failures, begin, end, i]() {
+      SharedFileReader::Handle handle(file, begin, end, "\r\n\t ", 100 + i);
+      string bytes;
+      bytes.reserve(end - begin);
+      for (char c = handle.get_char(); c != EOF; c = handle.get_char()) {
+        bytes += c;
+      }
+      if (bytes != kLongContents.substr(begin, end - begin)) {
+        failures++;
+      }
+
+      // And then random seeks, each read checked as it goes.
+      unsigned int seed = 5950 + i;
+      for (int j = 0; j < 2000; j++) {
+        off_t offset = begin + rand_r(&seed) % (end - begin);
+        handle.seek(offset);
+        if (handle.tell() != offset ||
+            handle.get_char() != kLongContents[offset]) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(0, failures.load());
+
+  // Tokens read by many handles at once are the tokens read by one.
+  vector<string> expected;
+  SharedFileReader::Handle one(file);
+  while (one.good()) {
+    expected.push_back(one.get_token());
+  }
+  vector<vector<string>> tokens(kThreads);
+  threads.clear();
+  for (int i = 0; i < kThreads; i++) {
+    threads.emplace_back([&file, &tokens, i]() {
+      SharedFileReader::Handle handle(file, 0, SharedFileReader::TO_EOF,
+                                      "\r\n\t ", 4096);
+      while (handle.good()) {
+        tokens[i].push_back(handle.get_token());
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const vector<string>& thread_tokens : tokens) {
+    ASSERT_EQ(expected, thread_tokens);
+  }
+  HW1Environment::AddPoints(10);
+}
+
+}  // namespace hw1
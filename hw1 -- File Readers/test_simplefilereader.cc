@@ -18,11 +18,14 @@
 
 #include "./SimpleFileReader.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
+#include <vector>
 
 using std::ifstream;
 using std::string;
+using std::vector;
 
 namespace hw1 {
 
@@ -362,5 +365,37 @@ TEST_F(Test_SimpleFileReader, Complex) {
   HW1Environment::AddPoints(15);
 }
 
+TEST_F(Test_SimpleFileReader, read_into) {
+  HW1Environment::OpenTestCase();
+
+  // Reads of all sizes, from one byte to a hundred thousand, land in the
+  // right place, and get_char() carries on where they stop.
+  SimpleFileReader sf(kLongFileName);
+  vector<char> contents(kLongContents.length() + 1);
+  size_t pos = 0, n = 1;
+  while (pos < kLongContents.length()) {
+    size_t read = sf.read_into(contents.data() + pos, n);
+    ASSERT_EQ(std::min(n, kLongContents.length() - pos), read);
+    pos += read;
+    ASSERT_EQ(static_cast<int>(pos), sf.tell());
+    if (pos < kLongContents.length() && n % 5 == 0) {
+      contents[pos++] = sf.get_char();
+    }
+    n = n * 7 % 100003;
+  }
+  ASSERT_EQ(kLongContents, string(contents.data(), pos));
+  ASSERT_EQ(0U, sf.read_into(contents.data(), 1));
+  ASSERT_FALSE(sf.good());
+
+  // Asking for more than is left stops at the end of the file.
+  sf.open_file(kHelloFileName);
+  ASSERT_EQ(kHelloContents.length(), sf.read_into(contents.data(),
+                                                  contents.size()));
+  ASSERT_EQ(kHelloContents, string(contents.data(), kHelloContents.length()));
+  ASSERT_FALSE(sf.good());
+
+  HW1Environment::AddPoints(5);
+}
+
 }  // namespace hw1
 
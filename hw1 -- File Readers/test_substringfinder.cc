@@ -0,0 +1,109 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+#include <strings.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./SubstringFinder.h"
+
+#include <algorithm>
+#include <string>
+
+using std::string;
+
+namespace hw1 {
+
+class Test_SubstringFinder : public ::testing::Test {
+ protected:
+  // Code here will be called before each test case
+  virtual void SetUp() {
+    // Nothing
+  }
+
+  // Code here will be called after each test executes (ie, after
+  // each TEST_F)
+  virtual void TearDown() {
+    // Nothing as of now
+  }
+};  // class Test_SubstringFinder
+
+// The obvious way to find a pattern.
+static const char* naive_find(const char* begin, const char* end,
+                              const string& pattern, bool case_insensitive) {
+  for (const char* p = begin; end - p >= static_cast<ptrdiff_t>(pattern.size());
+       p++) {
+    if (case_insensitive ? strncasecmp(p, pattern.data(), pattern.size()) == 0
+                         : memcmp(p, pattern.data(), pattern.size()) == 0) {
+      return p;
+    }
+  }
+  return end;
+}
+
+TEST_F(Test_SubstringFinder, find) {
+  HW1Environment::OpenTestCase();
+  // A small alphabet, with both cases of a letter and a couple of bytes
+  // that only differ from letters in the 0x20 bit, so there are plenty of
+  // near misses.
+  const char alphabet[] = "aAbB@`\n";
+  char buf[400];
+  unsigned int seed = 5950;
+
+  for (int trial = 0; trial < 20000; trial++) {
+    for (size_t i = 0; i < sizeof(buf); i++) {
+      buf[i] = alphabet[rand_r(&seed) % (sizeof(alphabet) - 1)];
+    }
+    // Patterns from 1 byte to longer than a SIMD block, mostly taken
+    // from the buffer so they match somewhere.
+    size_t len = 1 + rand_r(&seed) % (trial % 10 == 0 ? 40 : 6);
+    string pattern(buf + rand_r(&seed) % (sizeof(buf) - len), len);
+    if (trial % 3 == 0) {
+      pattern[rand_r(&seed) % len] = 'c';   // matches nowhere
+    }
+    bool case_insensitive = trial % 2 == 0;
+    SubstringFinder finder(pattern, case_insensitive);
+    ASSERT_EQ(len, finder.size());
+
+    size_t begin = rand_r(&seed) % 64;
+    size_t end = begin + rand_r(&seed) % (sizeof(buf) - begin + 1);
+    ASSERT_EQ(naive_find(buf + begin, buf + end, pattern, case_insensitive),
+              finder.find(buf + begin, buf + end));
+  }
+
+  // Too short a range never matches; an empty pattern matches anywhere.
+  SubstringFinder finder("abc");
+  ASSERT_EQ(buf + 2, finder.find(buf, buf + 2));
+  SubstringFinder empty("");
+  ASSERT_EQ(buf + 5, empty.find(buf + 5, buf + 10));
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_SubstringFinder, count_newlines) {
+  HW1Environment::OpenTestCase();
+  char buf[300];
+  unsigned int seed = 5950;
+
+  for (int trial = 0; trial < 2000; trial++) {
+    for (size_t i = 0; i < sizeof(buf); i++) {
+      buf[i] = rand_r(&seed) % 4 == 0 ? '\n' : 'x';
+    }
+    size_t begin = rand_r(&seed) % 64;
+    size_t end = begin + rand_r(&seed) % (sizeof(buf) - begin + 1);
+    ASSERT_EQ(static_cast<size_t>(std::count(buf + begin, buf + end, '\n')),
+              SubstringFinder::count_newlines(buf + begin, buf + end));
+  }
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
@@ -24,7 +24,7 @@ class HW1Environment : public ::testing::Environment {
   virtual void TearDown();
 
  private:
-  static constexpr int HW1_MAXPOINTS = 210;
+  static constexpr int HW1_MAXPOINTS = 605;
   static int total_points_;
   static int curr_test_points_;
 };
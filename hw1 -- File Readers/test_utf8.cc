@@ -0,0 +1,253 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "./test_suite.h"
+
+#include "./Utf8.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace hw1 {
+
+// Returns the UTF-8 encoding of code point cp.
+static string encode(uint32_t cp) {
+  string s;
+  if (cp < 0x80) {
+    s += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    s += static_cast<char>(0xC0 | (cp >> 6));
+    s += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    s += static_cast<char>(0xE0 | (cp >> 12));
+    s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    s += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    s += static_cast<char>(0xF0 | (cp >> 18));
+    s += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    s += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+  return s;
+}
+
+// Returns random valid UTF-8 text, mostly ASCII, with some of every length
+// of sequence.
+static string random_text(unsigned int* seed, size_t len) {
+  string s;
+  while (s.size() < len) {
+    int kind = rand_r(seed) % 16;
+    uint32_t cp;
+    if (kind < 10) {
+      cp = rand_r(seed) % 0x80;
+    } else if (kind < 12) {
+      cp = 0x80 + rand_r(seed) % (0x800 - 0x80);
+    } else if (kind < 15) {
+      do {
+        cp = 0x800 + rand_r(seed) % (0x10000 - 0x800);
+      } while (cp >= 0xD800 && cp < 0xE000);
+    } else {
+      cp = 0x10000 + rand_r(seed) % (0x110000 - 0x10000);
+    }
+    s += encode(cp);
+  }
+  return s;
+}
+
+// Returns the offsets of the invalid sequences in text, from
+// find_invalid() or find_invalid_scalar().
+static vector<off_t> all_invalid(const string& text, bool scalar) {
+  vector<off_t> offsets;
+  const char* begin = text.data();
+  const char* end = begin + text.size();
+  const char* p = begin;
+  while (p < end) {
+    int len;
+    const char* bad = scalar ? Utf8Validator::find_invalid_scalar(p, end, &len)
+                             : Utf8Validator::find_invalid(p, end, &len);
+    if (bad == end) {
+      break;
+    }
+    offsets.push_back(bad - begin);
+    p = bad + len;
+  }
+  return offsets;
+}
+
+TEST(Test_Utf8, find_invalid) {
+  HW1Environment::OpenTestCase();
+
+  // The edges of each length of sequence are valid.
+  string valid;
+  for (uint32_t cp : { 0x0, 0x7F, 0x80, 0x7FF, 0x800, 0xD7FF, 0xE000, 0xFFFF,
+                       0x10000, 0x10FFFF }) {
+    valid += encode(cp);
+  }
+  int len;
+  ASSERT_EQ(valid.data() + valid.size(),
+            Utf8Validator::find_invalid(valid.data(),
+                                        valid.data() + valid.size(), &len));
+
+  // Each kind of invalid sequence, and how much of it is its maximal
+  // subpart, found at every position in text with and without
+  // multibyte characters, so both the SIMD and the scalar paths see it.
+  struct Case {
+    const char* bytes;
+    int len;
+  };
+  const Case kCases[] = {
+    { "\x80", 1 },              // a continuation on its own
+    { "\xBF\xBF", 1 },
+    { "\xC0\x80", 1 },          // overlong
+    { "\xC1\xBF", 1 },
+    { "\xE0\x80\x80", 1 },
+    { "\xF0\x80\x80\x80", 1 },
+    { "\xED\xA0\x80", 1 },      // a surrogate
+    { "\xF4\x90\x80\x80", 1 },  // past U+10FFFF
+    { "\xF5\x80", 1 },
+    { "\xFF", 1 },
+    { "\xC3", 1 },              // cut off by ASCII
+    { "\xE2\x82", 2 },
+    { "\xF0\x9F\x98", 3 },
+  };
+  unsigned int seed = 5950;
+  string contexts[] = { string(200, 'x'), random_text(&seed, 200) };
+  for (const string& context : contexts) {
+    for (const Case& c : kCases) {
+      for (size_t pos = 0; pos <= context.size(); pos++) {
+        // Only at the start of a sequence.
+        if (pos < context.size() && (context[pos] & 0xC0) == 0x80) {
+          continue;
+        }
+        string text = context.substr(0, pos) + c.bytes + "!" +
+                      context.substr(pos);
+        for (bool scalar : { false, true }) {
+          const char* begin = text.data();
+          const char* end = begin + text.size();
+          const char* bad = scalar
+              ? Utf8Validator::find_invalid_scalar(begin, end, &len)
+              : Utf8Validator::find_invalid(begin, end, &len);
+          ASSERT_EQ(static_cast<ptrdiff_t>(pos), bad - begin);
+          ASSERT_EQ(c.len, len);
+        }
+      }
+    }
+  }
+
+  // Cut off by the end, it is invalid too.
+  string cut = valid + "\xF0\x9F\x98";
+  const char* bad = Utf8Validator::find_invalid(cut.data(),
+                                                cut.data() + cut.size(), &len);
+  ASSERT_EQ(static_cast<ptrdiff_t>(valid.size()), bad - cut.data());
+  ASSERT_EQ(3, len);
+
+  // Random text with random bytes changed: SIMD and scalar agree.
+  for (int i = 0; i < 200; i++) {
+    string text = random_text(&seed, 1 + rand_r(&seed) % 3000);
+    int changes = rand_r(&seed) % 4;
+    for (int j = 0; j < changes; j++) {
+      text[rand_r(&seed) % text.size()] = static_cast<char>(rand_r(&seed));
+    }
+    ASSERT_EQ(all_invalid(text, true), all_invalid(text, false));
+    if (changes == 0) {
+      ASSERT_TRUE(all_invalid(text, false).empty());
+    }
+  }
+
+  HW1Environment::AddPoints(10);
+}
+
+TEST(Test_Utf8, Validator) {
+  HW1Environment::OpenTestCase();
+  unsigned int seed = 5950;
+
+  // Fed in pieces of any size, the errors are the ones in the whole.
+  for (int i = 0; i < 100; i++) {
+    string text = random_text(&seed, 1 + rand_r(&seed) % 5000);
+    for (int j = rand_r(&seed) % 6; j > 0; j--) {
+      text[rand_r(&seed) % text.size()] = static_cast<char>(rand_r(&seed));
+    }
+    if (i % 3 == 0) {
+      text += "\xE2\x82";                 // cut off by the end
+    }
+    Utf8Validator validator;
+    size_t pos = 0;
+    while (pos < text.size()) {
+      size_t len = std::min(text.size() - pos,
+                            static_cast<size_t>(1 + rand_r(&seed) % 100));
+      validator.feed(text.data() + pos, len, pos);
+      pos += len;
+    }
+    validator.finish();
+    ASSERT_EQ(all_invalid(text, false), validator.errors());
+  }
+
+  // Fed again from the start, nothing is reported twice; fed from the
+  // middle of a sequence, it starts over from the next one.
+  string text = "ab\xFF" + encode(0x3000) + "c\x80";
+  Utf8Validator validator;
+  validator.feed(text.data(), text.size(), 0);
+  validator.finish();
+  ASSERT_EQ((vector<off_t>{ 2, 7 }), validator.errors());
+  validator.feed(text.data(), text.size(), 0);
+  ASSERT_EQ((vector<off_t>{ 2, 7 }), validator.errors());
+  validator.reset();
+  validator.feed(text.data() + 4, text.size() - 4, 4);
+  ASSERT_EQ((vector<off_t>{ 7 }), validator.errors());
+
+  HW1Environment::AddPoints(5);
+}
+
+TEST(Test_Utf8, Delims) {
+  HW1Environment::OpenTestCase();
+
+  // Every multibyte white space character separates tokens, and other
+  // characters that share its last byte don't.
+  const uint32_t kSpaces[] = { 0x85, 0xA0, 0x1680, 0x2000, 0x2003, 0x200A,
+                               0x2028, 0x2029, 0x202F, 0x205F, 0x3000 };
+  const uint32_t kNotSpaces[] = { 0xA9, 0xE9, 0x100, 0x200B, 0x2010, 0x2080,
+                                  0x20AC, 0x3001, 0x65E5, 0x1F600 };
+  Utf8Delims delims(" ,");
+  vector<string_view> tokens;
+  for (uint32_t space : kSpaces) {
+    for (uint32_t other : kNotSpaces) {
+      string word = "w" + encode(other) + encode(other);
+      string line = word + encode(space) + encode(space) + word + "," + word +
+                    encode(space);
+      delims.split(line, &tokens);
+      ASSERT_EQ((vector<string_view>{ word, "", word, word, "" }), tokens);
+    }
+  }
+
+  // Lots of text between delimiters, for the SIMD loops.
+  string word = string(100, 'a') + encode(0xE9) + string(100, 'b');
+  string line = word + encode(0x3000) + word + " " + word;
+  delims.split(line, &tokens);
+  ASSERT_EQ((vector<string_view>{ word, word, word }), tokens);
+
+  // Without white space in it, a line is one token.
+  delims.split("", &tokens);
+  ASSERT_EQ(vector<string_view>{ "" }, tokens);
+  ASSERT_EQ(0, delims.delim_length("a", "a"));
+  ASSERT_EQ(1, delims.delim_length(",", ","));
+
+  HW1Environment::AddPoints(5);
+}
+
+}  // namespace hw1
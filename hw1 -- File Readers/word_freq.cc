@@ -0,0 +1,102 @@
+/*
+ * Copyright ©2023 Travis McGaha.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Pennsylvania
+ * CIT 5950 for use solely during Spring Semester 2023 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+// Counts the words in one or more files with a ParallelTokenizer, and
+// prints the most common ones.
+//
+// Usage: ./word_freq [-t num_threads] [-n num_words] file...
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./ParallelTokenizer.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::pair;
+
+// Words are separated by white space and punctuation.
+static const char* kWordDelims = " \t\r\n.,;:!?\"()[]{}<>*_/\\";
+
+static double now_ms() {
+  struct timespec spec;
+  clock_gettime(CLOCK_MONOTONIC, &spec);
+  return spec.tv_sec * 1.0e3 + spec.tv_nsec / 1.0e6;
+}
+
+static void usage(const char* prog) {
+  cerr << "usage: " << prog << " [-t num_threads] [-n num_words] file..."
+       << endl;
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+  int num_threads = 4;
+  size_t num_words = 10;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "t:n:")) != -1) {
+    switch (opt) {
+      case 't':
+        num_threads = atoi(optarg);
+        break;
+      case 'n':
+        num_words = atoi(optarg);
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (optind == argc || num_threads <= 0) {
+    usage(argv[0]);
+  }
+
+  unordered_map<string, size_t> counts;
+  size_t total_words = 0;
+  double start = now_ms();
+  for (int i = optind; i < argc; i++) {
+    ParallelTokenizer tokenizer(argv[i], kWordDelims, num_threads);
+    for (const auto& count : tokenizer.count_tokens()) {
+      if (!count.first.empty()) {     // runs of delimiters
+        counts[count.first] += count.second;
+        total_words += count.second;
+      }
+    }
+  }
+  double ms = now_ms() - start;
+
+  // Most common first; ties in alphabetical order.
+  vector<pair<string, size_t>> sorted(counts.begin(), counts.end());
+  std::sort(sorted.begin(), sorted.end(),
+            [](const pair<string, size_t>& a, const pair<string, size_t>& b) {
+              if (a.second != b.second) {
+                return a.second > b.second;
+              }
+              return a.first < b.first;
+            });
+
+  for (size_t i = 0; i < num_words && i < sorted.size(); i++) {
+    printf("%10zu  %s\n", sorted[i].second, sorted[i].first.c_str());
+  }
+  printf("%zu words, %zu distinct, %d threads, %.1f ms\n",
+         total_words, counts.size(), num_threads, ms);
+  return EXIT_SUCCESS;
+}